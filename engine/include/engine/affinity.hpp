@@ -0,0 +1,50 @@
+#ifndef ENGINE_AFFINITY_HPP
+#define ENGINE_AFFINITY_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.hpp"
+
+namespace engine {
+namespace affinity {
+
+struct Placement {
+  int cpu = -1;
+  // INFO: the kernel's id of the NUMA node, as in /sys/devices/system/node
+  int node = -1;
+};
+
+// cpus usable by the process grouped by NUMA node, read once from
+// /sys/devices/system/node. Machines without NUMA info show up as a single
+// node.
+struct Topology {
+  std::vector<std::vector<int>> nodes;
+  // INFO: the kernel's id of every node, the ids can have gaps
+  std::vector<int> ids;
+
+  static const Topology &Get();
+
+  // Reads the online nodes of `root`, a directory laid out like
+  // /sys/devices/system/node.
+  static Topology Read(const std::string &root);
+};
+
+bool Parse(Affinity *affinity, const std::string_view &value);
+const char *ToString(Affinity affinity);
+
+// COMPACT fills a node before moving to the next one, SPREAD deals threads
+// across nodes round-robin.
+Placement Place(int index, Affinity affinity);
+
+// Pins the calling thread, it should happen before the thread allocates its
+// own data so that first-touch puts it on the local node.
+bool Pin(int index, Affinity affinity, Placement *placement = nullptr);
+
+std::string Describe(int threads, Affinity affinity);
+
+}  // namespace affinity
+}  // namespace engine
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef ENGINE_ATTACKS_HPP
+#define ENGINE_ATTACKS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#include "types.hpp"
+
+// 102400 rook & 5248 bishop entries, both backends index the same layout
+#define SLIDING_ATTACKS_TABLE_SIZE 107648
+
+namespace engine {
+
+// Sliding piece attacks looked up by occupancy. The occupancy is turned into a
+// table index with PEXT on cpus where it's fast & with fancy magics
+// elsewhere, the backend is picked once when the table gets built. Builds
+// targeting BMI2 (USE_PEXT) always take the PEXT path.
+class SlidingAttacks {
+ public:
+  enum class Backend { MAGIC, PEXT };
+
+  SlidingAttacks();
+  explicit SlidingAttacks(Backend backend);
+
+  // INFO: false on Zen 1/2 where PEXT is microcoded & slower than a multiply
+  static bool HasFastPext();
+
+  inline Backend Type() const { return backend_; }
+
+  inline Bitboard Rook(Bitboard occupied_sqs, int square) const {
+    return table_[Index(kRooks[square], occupied_sqs)];
+  }
+
+  inline Bitboard Bishop(Bitboard occupied_sqs, int square) const {
+    return table_[Index(kBishops[square], occupied_sqs)];
+  }
+
+  inline Bitboard Queen(Bitboard occupied_sqs, int square) const {
+    return Rook(occupied_sqs, square) | Bishop(occupied_sqs, square);
+  }
+
+ private:
+  struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    int shift;
+    std::size_t offset;
+  };
+
+  static const std::array<Magic, 64> kRooks;
+  static const std::array<Magic, 64> kBishops;
+
+  Backend backend_;
+  std::array<Bitboard, SLIDING_ATTACKS_TABLE_SIZE> table_;
+
+  static std::uint64_t SoftwarePext(Bitboard bb, Bitboard mask);
+  static consteval std::array<Magic, 64> InitMagics(
+      const std::array<Bitboard, 64> &magics, std::size_t offset, bool rook);
+
+  // INFO: the instruction is emitted through inline asm so that builds
+  // without BMI2 still inline it, it only runs once the PEXT backend got
+  // picked for a cpu that has it
+  static inline std::uint64_t Pext(Bitboard bb, Bitboard mask) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    std::uint64_t result;
+
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(bb), "rm"(mask));
+
+    return result;
+#else
+    return SoftwarePext(bb, mask);
+#endif
+  }
+
+  inline std::size_t Index(const Magic &entry, Bitboard occupied_sqs) const {
+#ifdef __BMI2__
+    return entry.offset + _pext_u64(occupied_sqs, entry.mask);
+#else
+    if (backend_ == Backend::PEXT) {
+      return entry.offset + Pext(occupied_sqs, entry.mask);
+    }
+
+    return entry.offset +
+           (((occupied_sqs & entry.mask) * entry.magic) >> entry.shift);
+#endif
+  }
+
+  void Fill(const std::array<Magic, 64> &entries, bool rook);
+};
+
+}  // namespace engine
+
+#endif
@@ -6,6 +6,9 @@
 #define MAX_SCORE (INT_MAX - 2)
 #define MIN_SCORE -MAX_SCORE
 
+// INFO: a tablebase win, minus the plies it takes to reach the position
+#define TB_WIN_SCORE 20000
+
 // #define MAX_DEPTH 10  // 125
 #define MAX_DEPTH 10
 #define MAX_THREADS 256
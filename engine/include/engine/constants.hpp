@@ -3,8 +3,7 @@
 
 #include <array>
 
-#include <magic_bits.hpp>
-
+#include "attacks.hpp"
 #include "types.hpp"
 
 namespace engine {
@@ -43,7 +42,7 @@ using CheckBetween = std::array<std::array<std::array<Bitboard, 64>, 64>, 2>;
 
 extern const AttackMaps kAttackMaps;
 extern const CheckBetween kCheckBetween;
-extern const magic_bits::Attacks kSlidingAttacks;
+extern const SlidingAttacks kSlidingAttacks;
 
 consteval AttackMaps InitAttackMaps();
 consteval CheckBetween InitCheckBetween();
@@ -0,0 +1,87 @@
+#ifndef ENGINE_DATAGEN_HPP
+#define ENGINE_DATAGEN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "position.hpp"
+#include "scheduler.hpp"
+#include "types.hpp"
+
+// INFO: layout of the sample files, a header of little-endian fields followed
+// by one record per position: the square of every piece of the signature, a
+// flags byte (bit 0 set when black moves, bits 1-3 the WDL + 2) & the DTZ as
+// an int16.
+#define DATAGEN_MAGIC 0x44544354  // "CTTD"
+#define DATAGEN_VERSION 1
+#define DATAGEN_HEADER_SIZE 64
+#define DATAGEN_MAX_PIECES 6
+#define DATAGEN_SIGNATURE_SIZE 16
+
+namespace engine {
+
+// A material signature such as KRvK, white's pieces then black's, each side
+// ordered from the king down so that identical pieces are next to each other.
+struct Material {
+  int size = 0;
+  Color colors[DATAGEN_MAX_PIECES];
+  Piece pieces[DATAGEN_MAX_PIECES];
+
+  bool HasPawns() const;
+  std::string ToString() const;
+};
+
+bool ParseMaterial(Material *material, std::string_view signature);
+
+// A position of the signature, `squares` follows the order of its pieces.
+struct Sample {
+  std::uint8_t squares[DATAGEN_MAX_PIECES];
+  Color turn;
+  std::int8_t wdl;
+  std::int16_t dtz;
+};
+
+struct DataGenStats {
+  std::size_t positions = 0;
+  std::size_t failed = 0;
+};
+
+// Enumerates every legal placement of a signature once per symmetry class &
+// probes the tablebases for each, spread across the scheduler.
+class DataGenerator {
+ public:
+  DataGenerator(Scheduler *scheduler, const Material &material);
+
+  // Work is split by the squares of the first two pieces.
+  std::size_t Slices() const { return kings_.size() * 64; }
+
+  // Legal positions of a slice with either side to move, not probed.
+  void Enumerate(std::size_t slice, std::vector<Sample> *samples) const;
+
+  // Probes every position & writes them in slice order. The tablebases have
+  // to be initialized.
+  bool Generate(const std::string &path, DataGenStats *stats);
+
+ private:
+  Scheduler *scheduler_;
+  Material material_;
+
+  // INFO: squares the white king is restricted to by the symmetry
+  std::vector<int> kings_;
+
+  bool Canonical(const int *squares) const;
+  bool Build(Position *position, const Sample &sample) const;
+  bool Probe(Sample *sample) const;
+};
+
+bool WriteSamples(const std::string &path, const Material &material,
+                  const std::vector<Sample> &samples);
+bool ReadSamples(const std::string &path, Material *material,
+                 std::vector<Sample> *samples);
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef ENGINE_EVAL_BATCH_HPP
+#define ENGINE_EVAL_BATCH_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "position.hpp"
+#include "score.hpp"
+#include "types.hpp"
+
+// Positions scored per AVX2 register, one bitboard per 64-bit lane.
+#define EVAL_BATCH_LANES 4
+
+namespace engine {
+
+// Set-wise terms of a position, computed for a whole batch at once.
+struct BatchFeatures {
+  int rooks_mobility;
+  int bishops_mobility;
+  int knights_mobility;
+  int doubled_pawns;
+};
+
+// Positions kept as a structure of arrays, every bitboard kind is contiguous
+// across positions so the SIMD lanes load them straight from memory.
+class EvalBatch {
+ public:
+  void Add(const Position &position);
+  void Clear();
+
+  std::size_t Size() const { return psq_.size(); }
+
+  // Scores every position with the handcrafted terms, same as calling
+  // Evaluate on each of them unless a loaded network covers the position.
+  void Evaluate(int *scores) const;
+
+  // INFO: differences between white & black, exposed for tests & benchmarks.
+  void Features(BatchFeatures *features) const;
+
+ private:
+  std::vector<Bitboard> pieces_[COLOR][PIECES];
+  std::vector<Bitboard> occupied_sqs_;
+  std::vector<Score> psq_;
+  std::vector<int> phase_;
+  std::vector<int> side_to_move_;
+
+  int EvaluateOne(std::size_t i, const BatchFeatures &features) const;
+};
+
+}  // namespace engine
+
+#endif
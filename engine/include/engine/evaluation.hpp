@@ -1,14 +1,17 @@
 #ifndef ENGINE_EVALUATION_HPP
 #define ENGINE_EVALUATION_HPP
 
+#include <atomic>
+#include <cstdint>
+#include <string>
 #include <tuple>
 #include <utility>
 
+#include "constants.hpp"
 #include "position.hpp"
+#include "score.hpp"
 #include "types.hpp"
-
-#define DIFF 2
-#define SUM 3
+#include "weights.hpp"
 
 #define BISHOP_PAIR 6
 #define DOUBLED_PAWNS 7
@@ -32,16 +35,22 @@
 #define QUEEN_ON_7th 25
 
 #define TOTAL_PHASE 24
-#define TAPER_EVAL(opening, endgame, phase) \
-  ((opening * (256 - phase)) + (endgame * phase)) / 256
 
-// INFO: opening & endgame weights
-// order of weights should corresponding with type::piece spec.
+// INFO: fractional bonuses are fixed-point, in hundredths
+#define BONUS_SCALE 100
+
+// Bounds on what the terms of the later stages can add up to, a lazy
+// evaluation stops once the partial score is further than that from the window.
+#define LAZY_EVAL_MATERIAL_MARGIN 600
+#define LAZY_EVAL_PAWNS_MARGIN 450
 
 namespace engine {
 
-extern const int kWeights[26][2];
-extern const float kRankBonus[6];
+// Coefficient of every weight in a score, white minus black. The score is
+// linear in kWeights, the tuner fits them from these.
+struct EvalTrace {
+  int coefficients[WEIGHTS] = {};
+};
 
 struct EvalState {
   const Bitboard *white_pieces;
@@ -52,35 +61,59 @@ struct EvalState {
   Bitboard pin_diag_mask;
 
   int phase;
-  int materials[4][6];
+  Score psq;
   Bitboard attack_map[2];
 
+  // INFO: only set by the tuner, the Eval* functions record their terms in it
+  EvalTrace *trace;
+
   EvalState(const Bitboard *white_pieces, const Bitboard *black_pieces,
-            Bitboard occupied_sqs, Bitboard check_mask, Bitboard pin_hv_mask,
-            Bitboard pin_diag_mask)
+            Bitboard occupied_sqs, Score psq, int phase_weight)
       : white_pieces(white_pieces),
         black_pieces(black_pieces),
         occupied_sqs(occupied_sqs),
-        check_mask(check_mask),
-        pin_hv_mask(pin_hv_mask),
-        pin_diag_mask(pin_diag_mask) {
-    ComputeMaterials();
-    ComputePhase();
-    ComputeAttackMap<WHITE>();
-    ComputeAttackMap<BLACK>();
+        check_mask(kUniverse),
+        pin_hv_mask(kEmpty),
+        pin_diag_mask(kEmpty),
+        psq(psq),
+        attack_map{kEmpty, kEmpty},
+        trace(nullptr) {
+    ComputePhase(phase_weight);
   }
 
-  static EvalState For(const Position &position);
+  // INFO: `attacks` can be skipped by callers that only need the cheap terms,
+  // LoadAttacks fills them in later.
+  static EvalState For(const Position &position, bool attacks = true);
+
+  void LoadAttacks(const position::AttackInfo &info);
+
+  void Trace(int index, int count) {
+    if (trace != nullptr) {
+      trace->coefficients[index] += count;
+    }
+  }
 
  private:
-  void ComputePhase();
-  void ComputeMaterials();
-  template <enum Color side>
-  void ComputeAttackMap();
+  void ComputePhase(int phase_weight);
 };
 
 enum Phase { OPENING, ENDGAME };
 
+// Stages of the lazy evaluation, from the cheapest terms to the full score.
+enum EvalStage { EVAL_MATERIAL, EVAL_PAWNS, EVAL_FULL, EVAL_STAGES };
+
+// How often the lazy evaluation stopped at every stage, only collected when
+// built with EVAL_STATS.
+struct LazyEvalStats {
+  std::atomic<std::uint64_t> calls = 0;
+  std::atomic<std::uint64_t> exits[EVAL_STAGES] = {};
+
+  static void Reset();
+  static std::string Report();
+};
+
+extern LazyEvalStats lazy_eval_stats;
+
 template <enum Color side>
 int DoublePawns(Bitboard pawns);
 template <enum Color side>
@@ -107,37 +140,43 @@ int BishopsMobility(EvalState &state);
 template <enum Color>
 int KnightsMobility(EvalState &state);
 template <enum Color>
-std::pair<float, float> PassedPawns(EvalState &state);
+Score PassedPawns(EvalState &state);
 
 template <enum Color>
 int KingPosition(EvalState &state);
 
-std::pair<int, int> EvalPieces(EvalState &state);
-int EvalKingDistance(EvalState &state);
-std::pair<int, int> EvalMobility(EvalState &state);
-std::pair<int, int> EvalOpenFile(EvalState &state);
-std::pair<int, int> EvalRank7(EvalState &state);
-std::pair<int, int> EvalMaterials(EvalState &state);
-std::pair<float, float> EvalPassedPawns(EvalState &state);
-std::pair<float, float> EvalPawnStructure(EvalState &state);
-int EvalKingPosition(EvalState &state);
+Score EvalPieces(EvalState &state);
+Score EvalKingDistance(EvalState &state);
+Score EvalMobility(EvalState &state);
+Score EvalOpenFile(EvalState &state);
+Score EvalRank7(EvalState &state);
+Score EvalMaterials(EvalState &state);
+Score EvalPassedPawns(EvalState &state);
+Score EvalPawnStructure(EvalState &state);
+// isolated & backward pawns, the part of the pawn structure scored per pawn
+Score EvalWeakPawns(EvalState &state);
+Score EvalKingPosition(EvalState &state);
+
+int Evaluate(Position &position, EvalTrace *trace = nullptr);
 
-int Evaluate(Position &position);
+// Evaluates up to the first stage that leaves the score clearly outside of
+// (alpha, beta), the result is exact only when it falls inside the window.
+int Evaluate(Position &position, int alpha, int beta);
 
 inline int PieceValue(Piece piece) {
   switch (piece) {
     case KING:
-      return kWeights[KING][0];
+      return OpeningValue(kWeights[KING]);
     case QUEEN:
-      return kWeights[QUEEN][0];
+      return OpeningValue(kWeights[QUEEN]);
     case ROOK:
-      return kWeights[ROOK][0];
+      return OpeningValue(kWeights[ROOK]);
     case KNIGHT:
-      return kWeights[KNIGHT][0];
+      return OpeningValue(kWeights[KNIGHT]);
     case BISHOP:
-      return kWeights[BISHOP][0];
+      return OpeningValue(kWeights[BISHOP]);
     case PAWN:
-      return kWeights[PAWN][0];
+      return OpeningValue(kWeights[PAWN]);
     default:
       return 0;
   }
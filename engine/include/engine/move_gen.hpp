@@ -58,22 +58,41 @@
 
 namespace engine {
 
+// INFO: dispatch on the side to move once & call the specialized versions
+// below, recursive callers that track the side themselves can call those
+// directly. They fill the position's attack info cache, see AttackInfo.
 Bitboard CheckMask(const Position &position);
 std::pair<Bitboard, Bitboard> PinMask(const Position &position);
 
 MoveList GenerateMoves(const Position &position);
 
+template <enum Color side>
+Bitboard Checkers(const Position &position);
+
+// universe when not in check, empty on a double check, otherwise the checker
+// & the squares between it and the king.
+Bitboard CheckMask(Bitboard checkers, int king_square);
+
+template <enum Color side>
+Bitboard CheckMask(const Position &position);
+
+template <enum Color side>
+std::pair<Bitboard, Bitboard> PinMask(const Position &position);
+
+template <enum Color side>
+MoveList GenerateMoves(const Position &position);
+
 void AddMovesToList(MoveList &moves, int from, Bitboard targets, Piece piece,
                     const Mailbox &mailbox, Bitboard enemy_bb);
 
-constexpr Bitboard BishopXRayAttacks(Bitboard attacks, Bitboard occupied_sqs,
-                                     Bitboard blockers, int square) {
+inline Bitboard BishopXRayAttacks(Bitboard attacks, Bitboard occupied_sqs,
+                                  Bitboard blockers, int square) {
   return attacks ^
          kSlidingAttacks.Bishop(occupied_sqs ^ (blockers & attacks), square);
 }
 
-constexpr Bitboard RookXRayAttacks(Bitboard attacks, Bitboard occupied_sqs,
-                                   Bitboard blockers, int square) {
+inline Bitboard RookXRayAttacks(Bitboard attacks, Bitboard occupied_sqs,
+                                Bitboard blockers, int square) {
   return attacks ^
          kSlidingAttacks.Rook(occupied_sqs ^ (blockers & attacks), square);
 }
@@ -0,0 +1,151 @@
+#ifndef ENGINE_NETWORK_HPP
+#define ENGINE_NETWORK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "types.hpp"
+
+// Layers of the KRK model trained by nn/lib/nn/model.ex.
+#define NETWORK_INPUTS 193
+#define NETWORK_L1 512
+#define NETWORK_L2 32
+#define NETWORK_L3 32
+#define NETWORK_PARAMS                                                  \
+  (NETWORK_INPUTS * NETWORK_L1 + NETWORK_L1 + NETWORK_L1 * NETWORK_L2 + \
+   NETWORK_L2 + NETWORK_L2 * NETWORK_L3 + NETWORK_L3 + NETWORK_L3 + 1)
+
+// INFO: fixed-point scale of the accumulator & of the hidden activations
+#define NETWORK_SCALE 64
+
+// Score of a won KRK ending before the predicted distance to zeroing is taken
+// off, in centipawns per ply.
+#define NETWORK_WIN_SCORE 1000
+#define NETWORK_DTZ_WEIGHT 8
+#define NETWORK_MAX_DTZ 100
+
+namespace engine {
+
+class Position;
+
+// Inputs of the model: the side to move, then one-hot squares of the king &
+// rook of the strong side and of the lone king.
+enum NetworkInput {
+  INPUT_TURN = 0,
+  INPUT_KING = 1,
+  INPUT_ROOK = 65,
+  INPUT_ENEMY_KING = 129
+};
+
+// First layer of the model for both sides as the strong one, black's inputs
+// are mirrored. Keeps the pieces it was computed from so that an update only
+// touches the squares that changed.
+struct Accumulator {
+  alignas(32) std::int16_t values[COLOR][NETWORK_L1];
+  Bitboard kings[COLOR];
+  Bitboard rooks[COLOR];
+};
+
+// INFO: layout of the network file written by mix export.weights. Every field
+// is a little-endian uint32, sections start on NETWORK_ALIGNMENT so that the
+// mapping is used as is.
+#define NETWORK_MAGIC 0x4e4e5443  // "CTNN"
+#define NETWORK_VERSION 1
+#define NETWORK_LAYERS 4
+#define NETWORK_ALIGNMENT 64
+#define NETWORK_HEADER_SIZE 128
+
+struct NetworkLayerHeader {
+  std::uint32_t inputs;
+  std::uint32_t outputs;
+  std::uint32_t scale;
+  std::uint32_t weights;
+  std::uint32_t biases;
+};
+
+// `size` is the size of the whole file & `checksum` the CRC-32 of everything
+// after the header.
+struct NetworkHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t layers;
+  std::uint32_t size;
+  std::uint32_t checksum;
+  std::uint32_t reserved;
+  NetworkLayerHeader layer[NETWORK_LAYERS];
+};
+
+static_assert(sizeof(NetworkHeader) <= NETWORK_HEADER_SIZE);
+
+// Hidden dense layer with int8 weights, widened to int16 & stored per output
+// so that every output is a single dot product.
+struct DenseLayer {
+  int inputs;
+  int outputs;
+  int scale;
+  const std::int16_t *weights;
+  const std::int32_t *biases;
+};
+
+// Points into a read-only mapping of the network file, processes loading the
+// same file share its pages.
+class Network {
+ public:
+  Network() = default;
+  ~Network();
+
+  Network(const Network &) = delete;
+  Network &operator=(const Network &) = delete;
+
+  // Quantizes NETWORK_PARAMS floats, every layer's kernel ([inputs][outputs])
+  // followed by its bias, into the file format. Values out of the format's
+  // range are clamped to it.
+  static std::vector<std::byte> Quantize(const float *params);
+
+  // Maps & validates a network file, `network` is left untouched on failure.
+  static bool Load(Network *network, const std::string &path);
+
+  void Refresh(Accumulator *accumulator, const Board &board) const;
+  void Update(Accumulator *accumulator, const Accumulator &previous,
+              const Board &board) const;
+
+  // Distance to zeroing predicted for `strong`, from the side to move's view.
+  float Predict(const Accumulator &accumulator, Color strong,
+                bool strong_to_move) const;
+
+ private:
+  void *mapping_ = nullptr;
+  std::size_t size_ = 0;
+
+  const std::int16_t *input_weights_ = nullptr;
+  const std::int16_t *input_biases_ = nullptr;
+  DenseLayer hidden_[3] = {};
+
+  bool Bind(const std::byte *data, std::size_t size);
+
+  void AddInput(std::int16_t *values, int input) const;
+  void SubInput(std::int16_t *values, int input) const;
+};
+
+// CRC-32 (IEEE, as in zlib & :erlang.crc32) of `data`.
+std::uint32_t Crc32(const std::byte *data, std::size_t size);
+
+namespace network {
+
+// INFO: not thread-safe, only called while no search is running
+bool Load(const std::string &path);
+void Unload();
+const Network *Current();
+
+// Scores the material signatures the model covers, a king & rook against a
+// lone king, from white's side. Drawn positions score 0.
+bool Evaluate(Position &position, int *score);
+
+}  // namespace network
+
+}  // namespace engine
+
+#endif
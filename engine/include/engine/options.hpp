@@ -1,10 +1,23 @@
 #ifndef ENGINE_OPTIONS_HPP
 #define ENGINE_OPTIONS_HPP
 
+#include "types.hpp"
+
 namespace engine {
 
 struct Options {
   int tasks;
+  Affinity affinity;
+
+  // INFO: the search probes the tablebases for positions of at most
+  // `syzygy_probe_limit` pieces, those with exactly that many only from
+  // `syzygy_probe_depth` on.
+  int syzygy_probe_depth;
+  int syzygy_probe_limit;
+
+  // INFO: tables of up to that many pieces are pre-faulted in the background
+  // once they're found, 0 leaves them to the first probes
+  int syzygy_warmup;
 };
 
 extern Options options;
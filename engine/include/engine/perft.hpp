@@ -0,0 +1,71 @@
+#ifndef ENGINE_PERFT_HPP
+#define ENGINE_PERFT_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "move.hpp"
+#include "position.hpp"
+#include "scheduler.hpp"
+#include "transposition.hpp"
+
+// Deepest ply ThreadedPerft will split the tree at before handing subtrees to
+// the scheduler.
+#define PERFT_MAX_SPLIT_DEPTH 6
+
+namespace engine {
+
+struct PerftStat {
+  std::size_t nodes = 0;
+  std::size_t checks = 0;
+  std::size_t captures = 0;
+  std::size_t checkmates = 0;
+  std::size_t en_passants = 0;
+  std::size_t discovery_checks = 0;
+  std::size_t double_checks = 0;
+  std::size_t promotions = 0;
+  std::size_t castles = 0;
+  std::size_t tt_probes = 0;
+  std::size_t tt_hits = 0;
+  std::unordered_map<std::string, std::size_t> map{};
+
+  PerftStat &operator+=(const PerftStat &stat);
+};
+
+// The moves leading from the root to a subtree counted by a single job.
+struct PerftSplit {
+  std::array<Move, PERFT_MAX_SPLIT_DEPTH> path;
+  int size = 0;
+};
+
+// A position from an EPD perft suite, i.e. "<fen> ;D1 20 ;D2 400".
+struct PerftCase {
+  std::string fen;
+  std::vector<std::pair<int, std::uint64_t>> expected;
+};
+
+PerftStat Perft(Position &position, int depth, bool divide);
+PerftStat BulkPerft(Position &position, int depth, bool divide,
+                    PerftTT *tt = nullptr);
+
+// Splits the tree `split_depth` plies below the root, at most `depth - 1` &
+// PERFT_MAX_SPLIT_DEPTH, and counts every subtree as its own job. 0 picks the
+// shallowest split giving every worker several jobs. Once `stop` is set the
+// remaining subtrees are cut short & the nodes counted so far are returned.
+PerftStat ThreadedPerft(Scheduler *scheduler, Position &position, int depth,
+                        bool divide, bool bulk = true, PerftTT *tt = nullptr,
+                        int split_depth = 0,
+                        const std::atomic<bool> *stop = nullptr);
+
+bool ParseEPD(PerftCase *perft_case, const std::string_view &line);
+
+}  // namespace engine
+
+#endif
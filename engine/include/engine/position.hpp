@@ -1,14 +1,19 @@
 #ifndef ENGINE_POSITION_HPP
 #define ENGINE_POSITION_HPP
 
+#include <bit>
 #include <cstdint>
 #include <stack>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "board.hpp"
+#include "constants.hpp"
 #include "move.hpp"
+#include "network.hpp"
+#include "score.hpp"
 #include "types.hpp"
 
 namespace engine {
@@ -20,6 +25,7 @@ inline constexpr const char *kStartPos =
     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
 class Position;
+struct EvalTrace;
 
 namespace position {
 
@@ -29,7 +35,6 @@ inline constexpr Castling CASTLE_B_KING_SIDE = static_cast<Castling>(1) << 2;
 inline constexpr Castling CASTLE_B_QUEEN_SIDE = static_cast<Castling>(1) << 3;
 
 struct State {
-  Bitboard king_ban;
   Bitboard occupied_sqs;
   Bitboard en_passant_square;
   Bitboard en_passant_target;
@@ -37,11 +42,53 @@ struct State {
   std::uint8_t halfmove_clock;
 
   std::uint64_t hash;
+  Score psq;
+  int phase;
 
   static State From(Position &position);
   static void Apply(Position &position, State &state);
 };
 
+// Attack & legality info of a position, computed on first use & dropped by
+// every move. Position::Masks only fills the masks, Position::Attacks fills
+// the attack maps too. Filling it writes to a const position, so a position
+// shared between threads isn't safe to read through them.
+struct AttackInfo {
+  Bitboard checkers;
+  Bitboard check_mask;
+  Bitboard pin_hv_mask;
+  Bitboard pin_diag_mask;
+  // squares attacked by the enemy as if the king to move wasn't there
+  Bitboard king_ban;
+
+  Bitboard attacks[COLOR];
+  Bitboard piece_attacks[COLOR][PIECES];
+};
+
+enum AttackInfoLevel : std::uint8_t { ATTACK_NONE, ATTACK_MASKS, ATTACK_MAPS };
+
+// fills the per-side & per-piece attack maps of `info` for `board`
+void AttackMaps(const Board &board, AttackInfo *info);
+
+// A whole position handed over at once, either piece by piece through Add or
+// by filling the bitboards directly. Position::ApplyPlacement validates it &
+// computes the internals a single time.
+struct Placement {
+  PieceList pieces[COLOR] = {};
+  Color turn = WHITE;
+  Castling castling_rights = 0;
+  Bitboard en_passant_sq = kEmpty;
+  std::uint8_t halfmove_clock = 0;
+  long fullmove_counter = 1;
+
+  // false when the square is taken already
+  bool Add(Color color, Piece piece, int square);
+
+  // One king a side, no pawn on the back ranks, the side that just moved not
+  // in check & castling rights/en passant square backed by the pieces.
+  bool Valid() const;
+};
+
 }  // namespace position
 
 static const std::stack<position::State> kEmptyStack;
@@ -56,34 +103,64 @@ class Position {
   static Position FromFen(const std::string_view &fen);
   static void ApplyFen(Position *position, const std::string_view &fen);
 
+  // INFO: leaves `position` untouched & returns false when the placement
+  // isn't valid.
+  static bool ApplyPlacement(Position *position,
+                             const position::Placement &placement);
+
   std::string ToFen() const;
 
   void Reset();
+
+  // INFO: fills the attack info cache like Masks, not thread-safe either
   MoveList LegalMoves() const;
   void Make(const Move &move);
   void Undo(const Move &move);
+
+  // INFO: `side` is the color making/taking back the move, callers that know
+  // it skip the runtime dispatch.
+  template <enum Color side>
+  void Make(const Move &move);
+  template <enum Color side>
+  void Undo(const Move &move);
+
   bool PieceAt(char *, int index) const;
   bool PieceAt(Piece *, int index) const;
 
   void UnsetPieceAt(int square);
   void SetPieceAt(Color color, Piece piece, int square);
 
-  inline void SetTurn(Color color) { turn_ = color; }
+  inline void SetTurn(Color color) {
+    turn_ = color;
+    attack_info_level_ = position::ATTACK_NONE;
+  }
 
   inline Color Turn() const { return turn_; }
   inline Bitboard EnPassantSquare() const { return en_passant_sq_; }
+  inline std::uint8_t HalfmoveClock() const { return halfmove_clock_; }
+  inline std::uint64_t Hash() const { return hash_; }
+  inline int PieceCount() const { return std::popcount(board_.occupied_sqs); }
   inline bool CanCastle(Castling flag) const { return castling_rights_ & flag; }
 
   inline const PieceList &Pieces(Color color) const {
     return board_.pieces[color];
   }
 
+  // INFO: not thread-safe, the first call fills the attack info cache of the
+  // const position. Threads reading one position each need their own copy.
+  const position::AttackInfo &Masks() const;
+  const position::AttackInfo &Attacks() const;
+
+  template <enum Color side>
+  const position::AttackInfo &Masks() const;
+  template <enum Color side>
+  const position::AttackInfo &Attacks() const;
+
  private:
   Color turn_;
   std::uint64_t hash_;
 
   Board board_;
-  Bitboard king_ban_;
   Bitboard en_passant_sq_;
   Bitboard en_passant_target_;
   std::uint8_t castling_rights_;
@@ -94,9 +171,28 @@ class Position {
   Mailbox mailbox_;
   std::stack<position::State> history_;
 
-  void UpdateKingBan();
+  // INFO: material + piece-square sum from white's point of view & the phase
+  // weight of the pieces left on the board.
+  Score psq_;
+  int phase_;
+
+  // INFO: empty until the network scores a position, then one entry per move
+  // made since.
+  std::vector<Accumulator> accumulators_;
+
+  mutable position::AttackInfo attack_info_;
+  mutable position::AttackInfoLevel attack_info_level_;
+
   void UpdateMailbox();
+  void UpdateInternals();
+  void Load(const position::Placement &placement);
+
+  void AddScore(Color color, Piece piece, int square);
+  void RemoveScore(Color color, Piece piece, int square);
+
+  template <enum Color side>
   void UpdateEnPassantSq();
+  template <enum Color side>
   void UpdateInternals();
 
   void Clone(const Position &src);
@@ -104,14 +200,27 @@ class Position {
   friend struct position::State;
 
   friend class TT;
+  friend class PerftTT;
 
   friend struct EvalState;
+  friend class EvalBatch;
   friend class SearchManager;
 
   friend int SEE(Position &position);
-  friend int Evaluate(Position &position);
+  friend int Evaluate(Position &position, EvalTrace *trace);
+  friend int Evaluate(Position &position, int alpha, int beta);
+  friend bool network::Evaluate(Position &position, int *score);
+  friend MoveList GenerateMoves(const Position &position);
+  friend Bitboard CheckMask(const Position &position);
+  friend std::pair<Bitboard, Bitboard> PinMask(const Position &position);
+
+  template <enum Color side>
   friend MoveList GenerateMoves(const Position &position);
+  template <enum Color side>
+  friend Bitboard Checkers(const Position &position);
+  template <enum Color side>
   friend Bitboard CheckMask(const Position &position);
+  template <enum Color side>
   friend std::pair<Bitboard, Bitboard> PinMask(const Position &position);
 };
 
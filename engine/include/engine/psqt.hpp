@@ -0,0 +1,23 @@
+#ifndef ENGINE_PSQT_HPP
+#define ENGINE_PSQT_HPP
+
+#include "score.hpp"
+#include "types.hpp"
+
+namespace engine {
+
+// Phase weight of every piece, pieces on the board add up to TOTAL_PHASE in
+// the starting position.
+inline constexpr int kPhaseWeights[PIECES] = {2, 1, 1, 0, 4, 0};
+
+// INFO: piece-square bonuses seen from the owner of the piece, indexed by
+// [color][piece][square].
+struct PieceSquare {
+  Score scores[COLOR][PIECES][64];
+};
+
+extern const PieceSquare kPieceSquare;
+
+}  // namespace engine
+
+#endif
@@ -1,81 +1,157 @@
 #ifndef ENGINE_SCHEDULER_HPP
 #define ENGINE_SCHEDULER_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
-#include <functional>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <new>
 #include <thread>
-#include <unordered_set>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-namespace engine {
+#include "types.hpp"
+
+// Jobs a worker can hold before further dispatches overflow into the shared
+// queue, must be a power of two.
+#define SCHEDULER_DEQUE_SIZE 4096
+#define SCHEDULER_STATUS_POOL_SIZE 1024
 
-using Callback = std::function<void()>;
+namespace engine {
 
 class Status;
 class Scheduler;
 class Worker;
 
-class Job {
- private:
-  Callback callback_;
-  bool done_;
-  Worker *worker_;
+// A move-only `void()` callable kept inline, callables larger than the buffer
+// fall back to the heap.
+class Callback {
+ public:
+  static constexpr std::size_t kCapacity = 64;
+
+  Callback() : invoke_(nullptr), manage_(nullptr) {}
+
+  template <typename F, typename T = std::decay_t<F>,
+            typename = std::enable_if_t<!std::is_same_v<T, Callback>>>
+  Callback(F &&fun) {
+    if constexpr (sizeof(T) <= kCapacity &&
+                  alignof(T) <= alignof(std::max_align_t)) {
+      ::new (storage_) T(std::forward<F>(fun));
+
+      invoke_ = [](void *storage) { (*static_cast<T *>(storage))(); };
+      manage_ = [](void *dst, void *src) {
+        T *fun = static_cast<T *>(src);
+
+        if (dst != nullptr) {
+          ::new (dst) T(std::move(*fun));
+        }
+
+        fun->~T();
+      };
+    } else {
+      *reinterpret_cast<T **>(storage_) = new T(std::forward<F>(fun));
+
+      invoke_ = [](void *storage) { (**static_cast<T **>(storage))(); };
+      manage_ = [](void *dst, void *src) {
+        T **fun = static_cast<T **>(src);
+
+        if (dst != nullptr) {
+          *static_cast<T **>(dst) = *fun;
+        } else {
+          delete *fun;
+        }
+      };
+    }
+  }
 
-  Job(Callback fun) : callback_(fun), done_(false), worker_(nullptr) {}
+  Callback(Callback &&other) noexcept : Callback() { *this = std::move(other); }
 
-  void Execute() {
-    if (done_) {
-      return;
+  Callback &operator=(Callback &&other) noexcept {
+    if (this != &other) {
+      Reset();
+
+      if (other.manage_ != nullptr) {
+        other.manage_(storage_, other.storage_);
+      }
+
+      invoke_ = std::exchange(other.invoke_, nullptr);
+      manage_ = std::exchange(other.manage_, nullptr);
     }
 
-    callback_();
-    done_ = true;
-    worker_ = nullptr;
+    return *this;
   }
 
-  friend class Status;
-  friend class Worker;
+  Callback(const Callback &) = delete;
+  Callback &operator=(const Callback &) = delete;
+
+  ~Callback() { Reset(); }
+
+  void operator()() { invoke_(storage_); }
+  explicit operator bool() const { return invoke_ != nullptr; }
+
+ private:
+  alignas(std::max_align_t) unsigned char storage_[kCapacity];
+  void (*invoke_)(void *);
+  void (*manage_)(void *dst, void *src);
+
+  void Reset() {
+    if (manage_ != nullptr) {
+      manage_(nullptr, storage_);
+    }
+
+    invoke_ = nullptr;
+    manage_ = nullptr;
+  }
 };
 
-class Worker {
+// Completion handle of a dispatched job. It must be waited on before it is
+// deleted, the allocations are recycled through a per-thread pool.
+class Status {
  public:
-  Worker() : job_(nullptr), id_(ID++), ready_(false), stopped_(false) {}
-  ~Worker() { Stop(); }
+  void Wait();
 
- private:
-  Job *job_;
-  std::mutex mutex_;
-  std::thread thread_;
-  std::condition_variable cv_;
+  static void *operator new(std::size_t size);
+  static void operator delete(void *ptr);
 
-  int id_;
-  bool ready_;
-  bool stopped_;
+ private:
+  Callback callback_;
   Scheduler *scheduler_;
+  std::atomic<bool> done_;
+  std::atomic<bool> released_;
 
-  static int ID;
+  Status(Scheduler *scheduler, Callback &&callback)
+      : callback_(std::move(callback)),
+        scheduler_(scheduler),
+        done_(false),
+        released_(false) {}
 
-  void Init(Scheduler *scheduler);
-  void Stop();
-  void Run(Job *job);
-  void Wait();
+  void Execute();
 
   friend class Scheduler;
-  friend class Status;
+  friend class Worker;
 };
 
-class Status {
+// Chase-Lev deque, the owner pushes & takes at the bottom while other threads
+// steal from the top.
+class Worker {
  public:
-  void Wait();
+  Worker() : top_(0), bottom_(0), buffer_(SCHEDULER_DEQUE_SIZE) {}
 
  private:
-  Job job_;
+  std::atomic<std::int64_t> top_;
+  std::atomic<std::int64_t> bottom_;
+  std::vector<std::atomic<Status *>> buffer_;
+  std::thread thread_;
 
-  Status(Callback callback) : job_(callback) {}
+  bool Push(Status *status);
+  Status *Take();
+  Status *Steal();
 
   friend class Scheduler;
 };
@@ -83,7 +159,7 @@ class Status {
 class Scheduler {
  public:
   Scheduler();
-  Scheduler(int workers);
+  Scheduler(int workers, Affinity affinity = Affinity::NONE);
 
   ~Scheduler() { Stop(); }
 
@@ -91,24 +167,76 @@ class Scheduler {
 
   void Init();
   std::size_t Busy();
-  void MakeAvailable(Worker *worker);
-  Status *Dispatch(Callback callback);
+
+  template <typename F>
+  Status *Dispatch(F &&fun) {
+    Status *status = new Status(this, Callback(std::forward<F>(fun)));
+
+    Submit(status);
+
+    return status;
+  }
+
+  // Calls `fun(i)` for every i in [begin, end) in chunks of `grain` indexes,
+  // 0 splits the range into a few chunks per worker. The calling thread helps
+  // until every chunk is done.
+  template <typename F>
+  void ParallelFor(std::size_t begin, std::size_t end, const F &fun,
+                   std::size_t grain = 0) {
+    if (begin >= end) {
+      return;
+    }
+
+    if (grain == 0) {
+      grain = std::max<std::size_t>(1, (end - begin) / (4 * size_ + 1));
+    }
+
+    std::vector<Status *> jobs;
+
+    jobs.reserve((end - begin) / grain + 1);
+
+    for (std::size_t i = begin + grain; i < end; i += grain) {
+      std::size_t last = std::min(i + grain, end);
+
+      jobs.push_back(Dispatch([&fun, i, last]() {
+        for (std::size_t j = i; j < last; j++) {
+          fun(j);
+        }
+      }));
+    }
+
+    for (std::size_t j = begin; j < std::min(begin + grain, end); j++) {
+      fun(j);
+    }
+
+    for (Status *status : jobs) {
+      status->Wait();
+      delete status;
+    }
+  }
 
  private:
   int size_;
   bool ready_;
-  bool stopped_;
-  std::queue<Job *> pending_;
+  Affinity affinity_;
+  std::atomic<bool> stopped_;
   std::vector<Worker> workers_;
-  std::queue<Worker *> free_;
-  std::unordered_set<int> busy_;
 
+  // INFO: jobs dispatched from threads that aren't workers
   std::mutex mutex_;
-  std::thread thread_;
+  std::deque<Status *> injected_;
+
   std::condition_variable cv_;
+  std::atomic<std::int64_t> pending_;
+  std::atomic<std::int64_t> active_;
+  std::atomic<int> sleeping_;
 
   void Stop();
-  void Monitor();
+  void Loop(int index);
+  void Submit(Status *status);
+  Status *FindJob(int index);
+
+  friend class Status;
 };
 
 }  // namespace engine
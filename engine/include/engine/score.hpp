@@ -0,0 +1,36 @@
+#ifndef ENGINE_SCORE_HPP
+#define ENGINE_SCORE_HPP
+
+#include <cstdint>
+
+namespace engine {
+
+// Opening & endgame values packed in one integer, the endgame value sits in
+// the upper 16 bits. Scores are added, subtracted & scaled by an integer as a
+// whole, both halves have to stay within 16 bits.
+using Score = std::int32_t;
+
+constexpr Score MakeScore(int opening, int endgame) {
+  return static_cast<Score>(static_cast<std::uint32_t>(endgame) << 16) +
+         opening;
+}
+
+constexpr int OpeningValue(Score score) {
+  return static_cast<std::int16_t>(static_cast<std::uint16_t>(score));
+}
+
+// INFO: the rounding makes up for the borrow taken by a negative opening value
+constexpr int EndgameValue(Score score) {
+  return static_cast<std::int16_t>(static_cast<std::uint16_t>(
+      static_cast<std::uint32_t>(score + 0x8000) >> 16));
+}
+
+// blends both values by `phase`, 0 being the opening & 256 the endgame
+constexpr int Taper(Score score, int phase) {
+  return (OpeningValue(score) * (256 - phase) + EndgameValue(score) * phase) /
+         256;
+}
+
+}  // namespace engine
+
+#endif
@@ -1,8 +1,11 @@
 #ifndef ENGINE_SEARCH_HPP
 #define ENGINE_SEARCH_HPP
 
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -83,7 +86,8 @@ class WorkerRegistry {
  private:
   std::size_t idle_;
 
-  std::vector<Worker> workers_;
+  // INFO: workers can't be moved, a deque keeps them in place
+  std::deque<Worker> workers_;
   std::vector<Worker *> stack_;
 
   std::mutex mutex_;
@@ -97,12 +101,19 @@ class Search {
   Position *position;
   search::State state;
   bool allow_node_splitting;
+  int max_depth;
   search::WorkerRegistry *workers;
 
+  // INFO: polled at every node, once set the search unwinds & the last
+  // complete iteration stands
+  const std::atomic<bool> *stop;
+
   Search(search::WorkerRegistry *workers);
   Search(const Search &) = delete;
 
-  void Run();
+  // INFO: iterates up to `max_depth` & returns the score of the last
+  // complete iteration from the side to move
+  int Run();
   void Clone(Search *search);
 
   void StopAll(search::State new_state);
@@ -114,15 +125,28 @@ class Search {
 
   inline bool Continue() { return state == search::State::RUNNING; }
 
+  // INFO: the root move & depth of the last complete iteration, the move is
+  // NONE when none completed
+  inline const Move &BestMove() const { return best_move_; }
+  inline int CompletedDepth() const { return completed_depth_; }
+
  private:
   int depth_;
   int height_;
-  SpinLock spin_;
+  int completed_depth_;
+  Move best_move_;
+  SpinLock spin_{&lock_site_};
   std::vector<Search *> children_;
 
+  // INFO: root moves kept by the tablebases, empty when the root isn't in
+  // them & every move gets searched
+  MoveList root_moves_;
+
   Search *parent_;
   Search *master_;
 
+  static LockSite lock_site_;
+
   friend class search::Worker;
 
   template <enum NodeType T>
@@ -141,7 +165,9 @@ class Worker {
  public:
   WorkerRegistry *registry;
 
-  Worker(bool loop = true);
+  // INFO: `id` is the worker's index in its registry & picks the cpu it's
+  // pinned to, negative ids are never pinned
+  Worker(int id, bool loop = true);
   ~Worker();
 
   void Search();
@@ -152,8 +178,10 @@ class Worker {
   Node *node_;
   Move *move_;
   std::size_t nodes_;
+  int id_;
 
-  Position position_;
+  // INFO: allocated by the worker thread after it got pinned, see Loop
+  std::unique_ptr<Position> position_;
   class Search search_;
 
   std::mutex mutex_;
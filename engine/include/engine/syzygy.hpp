@@ -0,0 +1,77 @@
+#ifndef ENGINE_SYZYGY_HPP
+#define ENGINE_SYZYGY_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+#include "move.hpp"
+#include "position.hpp"
+
+// INFO: largest tables the probing code handles
+#define SYZYGY_MAX_PIECES 6
+
+// INFO: WDL results every search thread remembers, a power of two
+#define SYZYGY_WDL_CACHE_SIZE 2048
+
+namespace engine {
+namespace syzygy {
+
+// INFO: not thread-safe, only called while no search is running. `paths` are
+// directories separated by ':', "<empty>" unloads the tables. Returns the
+// piece count of the largest table found & starts the warmup set by the
+// SyzygyWarmup option.
+int Init(std::string_view paths);
+
+// Receives the messages of the tables loader, e.g. the tables found, from
+// whichever thread loads them. Nothing is reported without one, like Init it
+// is only set while no search or warmup is running.
+void SetLogger(std::function<void(std::string_view)> logger);
+
+// Maps & pre-faults the tables of up to `pieces` pieces from a background
+// thread, the smaller tables first. A running warmup is stopped first, 0 only
+// stops it.
+void Warmup(int pieces);
+
+// Waits for the background warmup, returns the number of tables it warmed.
+int JoinWarmup();
+
+// Largest piece count the search probes, bounded by the loaded tables & the
+// SyzygyProbeLimit option.
+int Cardinality();
+
+// Probes the WDL tables for a position of the search at `depth`, false when
+// it's out of reach of the tables or of the probe options.
+bool Probe(const Position &position, int depth, int *wdl);
+
+// Keeps the root moves that preserve the tablebase result, ranked by DTZ when
+// the tables are there & by WDL otherwise. `moves` is left untouched when the
+// root can't be probed.
+bool FilterRoot(Position &position, MoveList *moves, int *wdl);
+
+// Score of a WDL result `height` plies from the root, from the side to move.
+int Score(int wdl, int height);
+
+// INFO: only collected when built with TB_STATS, zero otherwise
+struct Stats {
+  // INFO: probes answered by the WDL cache & by the tables
+  std::uint64_t cache_hits;
+  std::uint64_t table_probes;
+  std::uint64_t table_nanoseconds;
+
+  // INFO: lookups of the decoded blocks behind the table probes
+  std::uint64_t block_hits;
+  std::uint64_t block_misses;
+};
+
+// INFO: successful probes since the last reset, across every search thread.
+// Every thread counts its own, ResetStats is only called while no search is
+// running.
+std::uint64_t Hits();
+Stats GetStats();
+void ResetStats();
+
+}  // namespace syzygy
+}  // namespace engine
+
+#endif
@@ -2,14 +2,55 @@
 #define ENGINE_THREADS_HPP
 
 #include <atomic>
+#include <cstdint>
+#include <string>
 
+// Contention counters shared by every lock of a kind (i.e. all TT entries),
+// they are only collected when built with LOCK_STATS.
+struct LockSite {
+  const char *name;
+  std::atomic<std::uint64_t> acquisitions = 0;
+  std::atomic<std::uint64_t> contentions = 0;
+  std::atomic<std::uint64_t> spins = 0;
+  std::atomic<std::uint64_t> max_wait = 0;
+
+  explicit LockSite(const char *name);
+  ~LockSite();
+
+  static void Reset();
+  static std::string Report();
+};
+
+// Test-and-test-and-set lock, waiters spin on a plain load with an
+// exponential backoff so the cache line isn't bounced between cores.
 class SpinLock {
  public:
-  void Lock();
-  void Unlock();
+  SpinLock() = default;
+  explicit SpinLock(LockSite *site);
+
+  inline void Lock() {
+    if (locked_.exchange(true, std::memory_order_acquire)) {
+      Contend();
+      return;
+    }
+
+#ifdef LOCK_STATS
+    if (site_ != nullptr) {
+      site_->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+  }
+
+  inline void Unlock() { locked_.store(false, std::memory_order_release); }
 
  private:
-  std::atomic_flag atomic_flag_ = ATOMIC_FLAG_INIT;
+  std::atomic<bool> locked_ = false;
+
+#ifdef LOCK_STATS
+  LockSite *site_ = nullptr;
+#endif
+
+  void Contend();
 };
 
 #endif
@@ -12,6 +12,7 @@
 #include "types.hpp"
 
 #define MAX_TRANSPOSITION_SIZE 2097152 * sizeof(engine::TTEntry)
+#define PERFT_TRANSPOSITION_SIZE 4194304 * sizeof(engine::PerftTTEntry)
 
 namespace engine {
 
@@ -23,7 +24,9 @@ struct TTEntry {
   std::uint8_t age;
   NodeType node;
 
-  SpinLock spin;
+  SpinLock spin{&lock_site};
+
+  static LockSite lock_site;
 
   TTEntry() = default;
 
@@ -55,5 +58,28 @@ class TT {
   std::vector<TTEntry> entries_;
 };
 
+// INFO: entries are read & written without locks, the key is stored xor'ed
+// with the data so a torn write from another thread fails verification.
+struct PerftTTEntry {
+  std::uint64_t key = 0;
+  std::uint64_t data = 0;
+};
+
+class PerftTT {
+ public:
+  PerftTT(std::size_t size);
+
+  void Add(const Position &position, int depth, std::uint64_t nodes);
+  bool Probe(const Position &position, int depth, std::uint64_t *nodes);
+  void Clear() noexcept;
+  void Resize(std::size_t new_size);
+
+  inline std::size_t Capacity() const { return entries_.size(); }
+
+ private:
+  std::size_t size_;
+  std::vector<PerftTTEntry> entries_;
+};
+
 }  // namespace engine
 #endif
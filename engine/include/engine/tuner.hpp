@@ -0,0 +1,88 @@
+#ifndef ENGINE_TUNER_HPP
+#define ENGINE_TUNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "position.hpp"
+#include "scheduler.hpp"
+#include "weights.hpp"
+
+// Adam hyper parameters of the gradient descent.
+#define TUNER_BETA1 0.9
+#define TUNER_BETA2 0.999
+#define TUNER_EPSILON 1e-8
+
+namespace engine {
+
+// A non-zero coefficient of a traced position.
+struct TunerFeature {
+  std::uint16_t index;
+  std::int16_t coefficient;
+};
+
+// A labelled position reduced to its features. The score is `base` plus the
+// features dotted with the tapered weights, `base` holds every term that isn't
+// tuned (piece-square tables, passed pawns, king safety, rounding).
+struct TunerEntry {
+  std::uint32_t offset;
+  std::uint16_t size;
+  std::int16_t phase;
+  float base;
+  float result;
+};
+
+// Texel tuning of kWeights: positions are traced once & the gradient descent
+// only works on the cached features, spread across the scheduler.
+class Tuner {
+ public:
+  explicit Tuner(Scheduler *scheduler);
+
+  std::size_t Size() const { return entries_.size(); }
+  double K() const { return k_; }
+  void SetK(double k) { k_ = k; }
+
+  // `result` is from white's side, 1 for a win & 0.5 for a draw.
+  void Add(Position &position, double result);
+  bool Load(const std::string &path);
+
+  // Picks the sigmoid scale that fits the current weights best.
+  double FitK();
+  double Error() const;
+
+  // Runs `epochs` more full passes of Adam at `rate`, returns the final
+  // error.
+  double Train(int epochs, double rate);
+
+  // Source of weights.hpp with the tuned weights.
+  std::string Header() const;
+
+ private:
+  Scheduler *scheduler_;
+  std::vector<TunerFeature> features_;
+  std::vector<TunerEntry> entries_;
+
+  // INFO: opening & endgame value of every weight, side by side
+  double weights_[WEIGHTS][2];
+
+  // INFO: Adam moments, kept so that Train can be called in steps
+  double momentum_[WEIGHTS][2];
+  double velocity_[WEIGHTS][2];
+  int epoch_;
+  double k_;
+
+  double Predict(const TunerEntry &entry) const;
+  double Error(double k) const;
+  void Gradient(double gradient[WEIGHTS][2]) const;
+};
+
+// Parses a position labelled with its game result, either as `[1.0]` or as
+// the `c9 "1-0";` opcode of EPD files.
+bool ParseLabelled(std::string *fen, double *result, std::string_view line);
+
+}  // namespace engine
+
+#endif
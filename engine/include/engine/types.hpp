@@ -19,6 +19,9 @@ enum Piece { ROOK, BISHOP, KNIGHT, KING, QUEEN, PAWN, NONE };
 // exact, lower bound, upper bound
 enum class NodeType { PV, CUT, ALL };
 
+// how worker threads get pinned to cpus, see affinity.hpp
+enum class Affinity { NONE, COMPACT, SPREAD };
+
 // clang-format off
 enum ESquare {
   a1, b1, c1, d1, e1, f1, g1, h1,
@@ -1,12 +1,18 @@
 #ifndef ENGINE_UCI_HPP
 #define ENGINE_UCI_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <thread>
 
 #include "uci/command.hpp"
 #include "uci/link.hpp"
 
 #include "engine/position.hpp"
+#include "engine/search.hpp"
+#include "engine/transposition.hpp"
 
 namespace command = uci::command;
 
@@ -14,6 +20,7 @@ namespace engine {
 class UCILink : public uci::Link {
  public:
   UCILink(Position *position);
+  ~UCILink();
 
  protected:
   void Handle(command::Input *command) override;
@@ -22,11 +29,24 @@ class UCILink : public uci::Link {
   void Handle(command::SetOption *) override;
   void Handle(command::Register *) override;
   void Handle(command::Position *command) override;
-  void Handle(command::Go *) override;
+  void Handle(command::Go *command) override;
 
  private:
   engine::Position *position_;
   std::string fen_;
+  TT tt_;
+
+  // INFO: `go` runs on its own thread until it's done, `stop` or `quit`
+  std::atomic<bool> stop_;
+  std::thread go_;
+  PerftTT perft_tt_;
+
+  void RunPerft(int depth);
+  void RunSearch(int depth, std::int64_t budget, bool infinite);
+  void Report(Position &position, const Search &search, int score,
+              std::int64_t ms);
+  void Stop();
+  void LoadNetwork(std::string_view path);
 };
 }  // namespace engine
 
@@ -0,0 +1,55 @@
+#ifndef ENGINE_WEIGHTS_HPP
+#define ENGINE_WEIGHTS_HPP
+
+#include "score.hpp"
+
+// INFO: regenerated by the tuner, indexed by the term ids of evaluation.hpp
+#define WEIGHTS 26
+
+namespace engine {
+
+// INFO: opening & endgame weights
+// order of weights should corresponding with type::piece spec.
+inline constexpr Score kWeights[WEIGHTS] = {
+    // materials
+    MakeScore(500, 500),
+    MakeScore(325, 325),
+    MakeScore(325, 325),
+    MakeScore(2000, 2000),
+    MakeScore(975, 975),
+    MakeScore(70, 90),
+    // bishop pair values
+    MakeScore(50, 50),
+    // pawns structure
+    MakeScore(10, 20),
+    MakeScore(10, 20),
+    MakeScore(20, 20),
+    MakeScore(8, 10),
+    MakeScore(16, 10),
+    MakeScore(5, 10),
+    // tempo
+    MakeScore(20, 10),
+    // knight mobility
+    MakeScore(4, 4),
+    // bishop mobility
+    MakeScore(5, 5),
+    // rook mobility
+    MakeScore(2, 4),
+    // file
+    MakeScore(-10, -10),
+    MakeScore(0, 0),
+    MakeScore(10, 0),
+    MakeScore(20, 0),
+    MakeScore(10, 10),
+    MakeScore(20, 10),
+    MakeScore(30, 10),
+    // 7th rank
+    MakeScore(20, 40),
+    MakeScore(10, 20),
+};
+
+inline constexpr int kRankBonus[6] = {0, 0, 10, 30, 60, 100};
+
+}  // namespace engine
+
+#endif
@@ -18,19 +18,27 @@
 #endif
 
 #ifndef __WIN32__
-#define LOCK_T pthread_mutex_t
-#define LOCK_INIT(x) pthread_mutex_init(&(x), NULL)
-#define LOCK_DESTROY(x) pthread_mutex_destroy(&(x))
-#define LOCK(x) pthread_mutex_lock(&(x))
-#define UNLOCK(x) pthread_mutex_unlock(&(x))
+#include <sched.h>
+#define YIELD() sched_yield()
 #else
-#define LOCK_T HANDLE
-#define LOCK_INIT(x) do { x = CreateMutex(NULL, FALSE, NULL); } while (0)
-#define LOCK_DESTROY(x) CloseHandle(x)
-#define LOCK(x) WaitForSingleObject(x, INFINITE)
-#define UNLOCK(x) ReleaseMutex(x)
+#define YIELD() SwitchToThread()
 #endif
 
+// States of the `ready` byte of a table, it leaves TB_UNINIT once: the thread
+// that moves it to TB_LOADING maps the table while the others wait for that
+// table alone.
+#define TB_UNINIT 0
+#define TB_LOADING 1
+#define TB_READY 2
+#define TB_FAILED 3
+
+// Every thread keeps the symbols of its TBCACHE_BLOCKS most recently probed
+// blocks, blocks of more than TBCACHE_SYMBOLS symbols are walked each time.
+// An entry takes 4 bytes a symbol, about 4KB, so the cache is about 33KB of
+// static TLS that every thread of the process carries, probing or not.
+#define TBCACHE_BLOCKS 8
+#define TBCACHE_SYMBOLS 1024
+
 #define WDLSUFFIX ".rtbw"
 #define DTZSUFFIX ".rtbz"
 #define WDLDIR "RTBWDIR"
@@ -1,20 +1,34 @@
 #ifndef TBPROBE_H
 #define TBPROBE_H
 
+#include "engine/move.hpp"
+
 extern int TBlargest;  // 5 if 5-piece tables, 6 if 6-piece tables were found.
 
 namespace engine {
 class Position;
-class Value;
 }
 
-using Value = engine::Value;
 using Position = engine::Position;
 
 void init_tablebases(char* path);
-int probe_wdl(Position& pos, int* success);
+// The loader reports the tables it found & the broken ones to `logger`, from
+// whichever thread loads them. Silent until set, set it before loading.
+void tb_set_logger(void (*logger)(const char* message));
+// INFO: only reads `pos`, concurrent probes of the same position are safe
+int probe_wdl(const Position& pos, int* success);
+int probe_wdl_reference(Position& pos, int* success);
 int probe_dtz(Position& pos, int* success);
-int root_probe(Position& pos, Value& TBScore);
-int root_probe_wdl(Position& pos, Value& TBScore);
+int root_probe(Position& pos, engine::MoveList& moves, int* wdl);
+int root_probe_wdl(Position& pos, engine::MoveList& moves, int* wdl);
+
+// Lookups of the per-thread caches of decoded blocks, summed over threads.
+// Only counted when built with TB_STATS.
+void tb_block_stats(unsigned long long* hits, unsigned long long* misses);
+void tb_reset_block_stats(void);
+
+// Maps & pre-faults the tables of up to `pieces` pieces, meant for a
+// background thread. `stopped` is polled to abandon the warmup.
+int tb_warmup(int pieces, int (*stopped)(void));
 
 #endif
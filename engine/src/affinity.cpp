@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "engine/affinity.hpp"
+#include "engine/types.hpp"
+
+namespace engine {
+namespace affinity {
+
+// parses a kernel cpu or node list, i.e. "0-7,16-23"
+static std::vector<int> ParseCpuList(const std::string &list) {
+  std::string range;
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+
+  while (std::getline(stream, range, ',')) {
+    int first;
+    int last;
+    int matched = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+
+    if (matched == 1) {
+      last = first;
+    } else if (matched != 2) {
+      continue;
+    }
+
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+static std::vector<int> AllowedCpus() {
+  std::vector<int> cpus;
+
+#ifdef __linux__
+  cpu_set_t set;
+
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+
+  if (cpus.empty()) {
+    for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+Topology Topology::Read(const std::string &root) {
+  Topology topology;
+  std::string online;
+  std::vector<int> allowed = AllowedCpus();
+  std::ifstream nodes(root + "/online");
+
+  std::getline(nodes, online);
+
+  // INFO: the node ids can have gaps, only the online ones are listed
+  for (int id : ParseCpuList(online)) {
+    std::string list;
+    std::ifstream file(std::format("{}/node{}/cpulist", root, id));
+
+    if (!file) {
+      continue;
+    }
+
+    std::getline(file, list);
+
+    std::vector<int> cpus;
+
+    // INFO: drop cpus outside of our cpuset & memory-only nodes
+    for (int cpu : ParseCpuList(list)) {
+      if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+        cpus.push_back(cpu);
+      }
+    }
+
+    if (!cpus.empty()) {
+      topology.nodes.push_back(cpus);
+      topology.ids.push_back(id);
+    }
+  }
+
+  if (topology.nodes.empty()) {
+    topology.nodes.push_back(allowed);
+    topology.ids.push_back(0);
+  }
+
+  return topology;
+}
+
+const Topology &Topology::Get() {
+  static const Topology topology = Read("/sys/devices/system/node");
+
+  return topology;
+}
+
+bool Parse(Affinity *affinity, const std::string_view &value) {
+  if (value == "none") {
+    *affinity = Affinity::NONE;
+  } else if (value == "compact") {
+    *affinity = Affinity::COMPACT;
+  } else if (value == "spread") {
+    *affinity = Affinity::SPREAD;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+const char *ToString(Affinity affinity) {
+  switch (affinity) {
+    case Affinity::COMPACT:
+      return "compact";
+
+    case Affinity::SPREAD:
+      return "spread";
+
+    default:
+      return "none";
+  }
+}
+
+Placement Place(int index, Affinity affinity) {
+  Placement placement;
+  const Topology &topology = Topology::Get();
+  int nodes = topology.nodes.size();
+
+  if (affinity == Affinity::SPREAD) {
+    const std::vector<int> &cpus = topology.nodes[index % nodes];
+
+    placement.node = topology.ids[index % nodes];
+    placement.cpu = cpus[(index / nodes) % cpus.size()];
+  } else if (affinity == Affinity::COMPACT) {
+    std::size_t total = 0;
+
+    for (const std::vector<int> &cpus : topology.nodes) {
+      total += cpus.size();
+    }
+
+    std::size_t slot = index % total;
+
+    for (int node = 0; node < nodes; node++) {
+      const std::vector<int> &cpus = topology.nodes[node];
+
+      if (slot < cpus.size()) {
+        placement.node = topology.ids[node];
+        placement.cpu = cpus[slot];
+        break;
+      }
+
+      slot -= cpus.size();
+    }
+  }
+
+  return placement;
+}
+
+bool Pin(int index, Affinity affinity, Placement *result) {
+  Placement placement = Place(index, affinity);
+
+  if (result != nullptr) {
+    *result = placement;
+  }
+
+  if (placement.cpu < 0) {
+    return false;
+  }
+
+#ifdef __linux__
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET(placement.cpu, &set);
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+std::string Describe(int threads, Affinity affinity) {
+  const Topology &topology = Topology::Get();
+  std::string str = std::format("affinity {}, {} node(s)", ToString(affinity),
+                                topology.nodes.size());
+
+  if (affinity == Affinity::NONE) {
+    return str;
+  }
+
+  str.append(":");
+
+  for (int i = 0; i < threads; i++) {
+    Placement placement = Place(i, affinity);
+
+    str.append(std::format(" {}->cpu{}/node{}", i, placement.cpu,
+                           placement.node));
+  }
+
+  return str;
+}
+
+}  // namespace affinity
+}  // namespace engine
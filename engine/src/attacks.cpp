@@ -0,0 +1,220 @@
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#endif
+
+#include "engine/attacks.hpp"
+#include "engine/types.hpp"
+
+namespace engine {
+
+// INFO: found offline with a sparse random search, the index of every square
+// uses 64 - popcount(mask) as the shift.
+static constexpr std::array<Bitboard, 64> kRookMagics = {
+    0x0080021620804001, 0x0040001000200041,
+    0x0200102200088040, 0x4080040800821000,
+    0x2200020004200810, 0x4B00020C000D0008,
+    0x01000C4183000600, 0x2080010000402C80,
+    0x8002800826864000, 0x0410802000884000,
+    0x0C01004010200100, 0x020300100100203C,
+    0x0450800801040080, 0x4010800200040080,
+    0x8804000208048110, 0x0C40800080004100,
+    0xA2018880024004A0, 0x0080848020004004,
+    0x1010410010200101, 0x2010008008008010,
+    0x0A08010004110008, 0x0802080104209040,
+    0x0080040090010802, 0x0280020000841069,
+    0x080C400080248000, 0x2048850100224008,
+    0x00200800C0300040, 0x11400D0100201000,
+    0x0041001100080204, 0x4802000200040810,
+    0x0100080C00103601, 0x0020084200043085,
+    0x0100804000800022, 0x0460401000402002,
+    0x8309002001001044, 0x0000800800801000,
+    0x0000800800800400, 0xB542040080800200,
+    0x1041000401000200, 0x000318B04A000401,
+    0x0280082000484000, 0x0080400081010030,
+    0x0010002000108080, 0x012010002101000A,
+    0x0801000408010012, 0x0004008002008004,
+    0x0AD1005200110014, 0x4000004110820004,
+    0x9400400080003080, 0x0000802200490200,
+    0x1521100080200280, 0x9021000824100100,
+    0x0081080080840280, 0x0002000904100200,
+    0x0130024801302400, 0x0102008100442200,
+    0x0080984063800101, 0x0016810201412812,
+    0x40200101603008C1, 0x2851100004082101,
+    0x1049001002880005, 0x0081000804000201,
+    0x100020901208410C, 0x0101064400813102};
+
+static constexpr std::array<Bitboard, 64> kBishopMagics = {
+    0x24E0440C00802202, 0x00881808841A4500,
+    0x29C1021085004190, 0x18C4041080042020,
+    0x0841104000008108, 0x890828080880C088,
+    0x0006021024062018, 0x2000404044104040,
+    0x09000504104A0210, 0x0088390204040820,
+    0x4001420082008402, 0x028108048B001142,
+    0x1C00140421001008, 0x0008021212200400,
+    0x080000581A082004, 0x3000048208027204,
+    0x0120004044148482, 0x4021000808108090,
+    0x0084011808009452, 0x11C802242020E000,
+    0x0124002210140002, 0x4009008200420200,
+    0x0000830202100202, 0x9002042500420200,
+    0x0A60200004480210, 0x0402481020480080,
+    0x8001100101004200, 0x6240104004004080,
+    0x1124848014002000, 0x00180200204100A0,
+    0x8020890844880800, 0x0000802009040204,
+    0x0410042041100280, 0x0804022000020440,
+    0x2418280400480024, 0x0801080800420A00,
+    0x4002248400020020, 0x3020004102038084,
+    0x84280110601C0200, 0x2004004208088080,
+    0x0008022220041210, 0x00820E0120000440,
+    0x0002002201020822, 0x0000002019000804,
+    0x0211204C10101100, 0x0604808081001200,
+    0x1010029204030041, 0x1008090102110621,
+    0x0002015002100C00, 0x06002C040404400A,
+    0xC030002201100011, 0x4040008020884000,
+    0x0248000903040100, 0xC010092008008040,
+    0x6008084108020494, 0x28102182008E0042,
+    0x0010210820842002, 0x4080020111491002,
+    0x0108100084008800, 0x0022242100420221,
+    0x10A8008110020210, 0x400019122A900102,
+    0x00800A1051080300, 0x0420222088008080};
+
+static constexpr Bitboard Ray(Bitboard occupied_sqs, int square, int df,
+                              int dr, bool edges) {
+  Bitboard ray = 0;
+  int file = square % 8 + df;
+  int rank = square / 8 + dr;
+
+  while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+    int next_file = file + df;
+    int next_rank = rank + dr;
+
+    // relevant occupancy masks leave out the last square of a ray
+    if (!edges &&
+        (next_file < 0 || next_file > 7 || next_rank < 0 || next_rank > 7)) {
+      break;
+    }
+
+    Bitboard bb = static_cast<Bitboard>(1) << (rank * 8 + file);
+
+    ray |= bb;
+
+    if (occupied_sqs & bb) {
+      break;
+    }
+
+    file = next_file;
+    rank = next_rank;
+  }
+
+  return ray;
+}
+
+static constexpr Bitboard RookRays(Bitboard occupied_sqs, int square,
+                                   bool edges) {
+  return Ray(occupied_sqs, square, 1, 0, edges) |
+         Ray(occupied_sqs, square, -1, 0, edges) |
+         Ray(occupied_sqs, square, 0, 1, edges) |
+         Ray(occupied_sqs, square, 0, -1, edges);
+}
+
+static constexpr Bitboard BishopRays(Bitboard occupied_sqs, int square,
+                                     bool edges) {
+  return Ray(occupied_sqs, square, 1, 1, edges) |
+         Ray(occupied_sqs, square, -1, 1, edges) |
+         Ray(occupied_sqs, square, 1, -1, edges) |
+         Ray(occupied_sqs, square, -1, -1, edges);
+}
+
+consteval std::array<SlidingAttacks::Magic, 64> SlidingAttacks::InitMagics(
+    const std::array<Bitboard, 64> &magics, std::size_t offset, bool rook) {
+  std::array<Magic, 64> entries{};
+
+  for (int square = 0; square < 64; square++) {
+    Bitboard mask =
+        rook ? RookRays(0, square, false) : BishopRays(0, square, false);
+    int bits = std::popcount(mask);
+
+    entries[square] = {mask, magics[square], 64 - bits, offset};
+    offset += static_cast<std::size_t>(1) << bits;
+  }
+
+  return entries;
+}
+
+constexpr std::array<SlidingAttacks::Magic, 64> SlidingAttacks::kRooks =
+    InitMagics(kRookMagics, 0, true);
+
+constexpr std::array<SlidingAttacks::Magic, 64> SlidingAttacks::kBishops =
+    InitMagics(kBishopMagics, kRooks[63].offset + 4096, false);
+
+bool SlidingAttacks::HasFastPext() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+  unsigned vendor[3] = {};
+
+  // INFO: a leaf that can't be read counts as no fast PEXT
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_BMI2) ||
+      !__get_cpuid(0, &eax, &vendor[0], &vendor[2], &vendor[1]) ||
+      !__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+
+  bool amd = vendor[0] == 0x68747541 && vendor[1] == 0x69746e65 &&
+             vendor[2] == 0x444d4163;
+  unsigned family = ((eax >> 8) & 0xf) + ((eax >> 20) & 0xff);
+
+  // family 0x17 is Zen, Zen+ & Zen 2
+  return !(amd && family == 0x17);
+#else
+  return false;
+#endif
+}
+
+std::uint64_t SlidingAttacks::SoftwarePext(Bitboard bb, Bitboard mask) {
+  std::uint64_t result = 0;
+
+  for (std::uint64_t bit = 1; mask; bit <<= 1, mask &= mask - 1) {
+    if (bb & mask & -mask) {
+      result |= bit;
+    }
+  }
+
+  return result;
+}
+
+#ifdef __BMI2__
+SlidingAttacks::SlidingAttacks() : SlidingAttacks(Backend::PEXT) {}
+#else
+SlidingAttacks::SlidingAttacks()
+    : SlidingAttacks(HasFastPext() ? Backend::PEXT : Backend::MAGIC) {}
+#endif
+
+SlidingAttacks::SlidingAttacks(Backend backend) : backend_(backend) {
+  static_assert(kBishops[63].offset + (1 << (64 - kBishops[63].shift)) ==
+                SLIDING_ATTACKS_TABLE_SIZE);
+
+  Fill(kRooks, true);
+  Fill(kBishops, false);
+}
+
+void SlidingAttacks::Fill(const std::array<Magic, 64> &entries, bool rook) {
+  for (int square = 0; square < 64; square++) {
+    Bitboard mask = entries[square].mask;
+    Bitboard occupied_sqs = 0;
+
+    // walk every subset of the mask with the carry-rippler trick
+    do {
+      table_[Index(entries[square], occupied_sqs)] =
+          rook ? RookRays(occupied_sqs, square, true)
+               : BishopRays(occupied_sqs, square, true);
+
+      occupied_sqs = (occupied_sqs - mask) & mask;
+    } while (occupied_sqs);
+  }
+}
+
+}  // namespace engine
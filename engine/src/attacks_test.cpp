@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <memory>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "engine/attacks.hpp"
+#include "engine/constants.hpp"
+#include "engine/types.hpp"
+
+using namespace engine;
+
+static Bitboard Slide(Bitboard occupied_sqs, int square, int df, int dr) {
+  Bitboard ray = 0;
+
+  for (int file = square % 8 + df, rank = square / 8 + dr;
+       file >= 0 && file < 8 && rank >= 0 && rank < 8;
+       file += df, rank += dr) {
+    Bitboard bb = static_cast<Bitboard>(1) << (rank * 8 + file);
+
+    ray |= bb;
+
+    if (occupied_sqs & bb) {
+      break;
+    }
+  }
+
+  return ray;
+}
+
+static void ExpectAttacks(const SlidingAttacks &attacks) {
+  std::mt19937_64 random(42);
+
+  for (int i = 0; i < 2000; i++) {
+    Bitboard occupied_sqs = random() & random();
+
+    for (int square = 0; square < 64; square++) {
+      Bitboard rook = Slide(occupied_sqs, square, 1, 0) |
+                      Slide(occupied_sqs, square, -1, 0) |
+                      Slide(occupied_sqs, square, 0, 1) |
+                      Slide(occupied_sqs, square, 0, -1);
+      Bitboard bishop = Slide(occupied_sqs, square, 1, 1) |
+                        Slide(occupied_sqs, square, -1, 1) |
+                        Slide(occupied_sqs, square, 1, -1) |
+                        Slide(occupied_sqs, square, -1, -1);
+
+      ASSERT_EQ(attacks.Rook(occupied_sqs, square), rook);
+      ASSERT_EQ(attacks.Bishop(occupied_sqs, square), bishop);
+      ASSERT_EQ(attacks.Queen(occupied_sqs, square), rook | bishop);
+    }
+  }
+}
+
+TEST(SlidingAttacksTestSuite, Magic) {
+#ifdef __BMI2__
+  GTEST_SKIP() << "BMI2 builds always index with PEXT";
+#endif
+
+  auto attacks =
+      std::make_unique<SlidingAttacks>(SlidingAttacks::Backend::MAGIC);
+
+  ExpectAttacks(*attacks);
+}
+
+TEST(SlidingAttacksTestSuite, Pext) {
+  if (!SlidingAttacks::HasFastPext()) {
+    GTEST_SKIP() << "no fast PEXT on this cpu";
+  }
+
+  auto attacks =
+      std::make_unique<SlidingAttacks>(SlidingAttacks::Backend::PEXT);
+
+  ExpectAttacks(*attacks);
+}
+
+TEST(SlidingAttacksTestSuite, Default) { ExpectAttacks(kSlidingAttacks); }
@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine/constants.hpp"
+#include "engine/datagen.hpp"
+#include "engine/position.hpp"
+#include "engine/scheduler.hpp"
+#include "engine/square.hpp"
+#include "engine/types.hpp"
+#include "tb/tbprobe.h"
+
+namespace engine {
+
+// INFO: pieces of a side in signature order, the king first
+static constexpr char kPieceChars[] = "KQRBNP";
+static constexpr Piece kPieceOrder[] = {KING, QUEEN, ROOK, BISHOP, KNIGHT,
+                                        PAWN};
+
+struct SampleHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t pieces;
+  std::uint32_t record;
+  std::uint64_t samples;
+  char signature[DATAGEN_SIGNATURE_SIZE];
+};
+
+static_assert(sizeof(SampleHeader) <= DATAGEN_HEADER_SIZE);
+
+// INFO: the header is copied as is, its fields are little-endian
+static_assert(std::endian::native == std::endian::little);
+
+bool Material::HasPawns() const {
+  return std::find(pieces, pieces + size, PAWN) != pieces + size;
+}
+
+std::string Material::ToString() const {
+  std::string signature;
+
+  for (int i = 0; i < size; i++) {
+    if (i > 0 && colors[i] != colors[i - 1]) {
+      signature += 'v';
+    }
+
+    int order = std::find(kPieceOrder, kPieceOrder + 6, pieces[i]) -
+                kPieceOrder;
+
+    signature += kPieceChars[order];
+  }
+
+  return signature;
+}
+
+bool ParseMaterial(Material *material, std::string_view signature) {
+  std::size_t split = signature.find('v');
+
+  if (split == std::string_view::npos) {
+    return false;
+  }
+
+  Material parsed;
+  std::string_view sides[COLOR] = {signature.substr(0, split),
+                                   signature.substr(split + 1)};
+
+  for (int color = WHITE; color < COLOR; color++) {
+    std::string side(sides[color]);
+
+    // exactly one king per side
+    if (side.empty() || side[0] != 'K' ||
+        side.find('K', 1) != std::string::npos ||
+        side.find_first_not_of("KQRBNP") != std::string::npos ||
+        parsed.size + side.size() > DATAGEN_MAX_PIECES) {
+      return false;
+    }
+
+    std::sort(side.begin(), side.end(), [](char a, char b) {
+      return std::strchr(kPieceChars, a) < std::strchr(kPieceChars, b);
+    });
+
+    for (char c : side) {
+      parsed.colors[parsed.size] = static_cast<Color>(color);
+      parsed.pieces[parsed.size] =
+          kPieceOrder[std::strchr(kPieceChars, c) - kPieceChars];
+      parsed.size++;
+    }
+  }
+
+  if (parsed.size < 3) {
+    return false;
+  }
+
+  *material = parsed;
+
+  return true;
+}
+
+// The 8 symmetries of the board: bit 2 mirrors along the a1-h8 diagonal, bit
+// 1 flips the ranks & bit 0 the files.
+static int Transform(int square, int symmetry) {
+  if (symmetry & 4) {
+    square = ((square & 7) << 3) | (square >> 3);
+  }
+
+  if (symmetry & 2) {
+    square ^= 56;
+  }
+
+  if (symmetry & 1) {
+    square ^= 7;
+  }
+
+  return square;
+}
+
+DataGenerator::DataGenerator(Scheduler *scheduler, const Material &material)
+    : scheduler_(scheduler), material_(material) {
+  // INFO: pawns only allow the left-right mirror, without them the king can
+  // be brought into the a1-d1-d4 triangle
+  for (int square = 0; square < 64; square++) {
+    int rank = square::Rank(square);
+    int file = square::File(square);
+
+    if (material_.HasPawns() ? file < 4 : rank <= file && file < 4) {
+      kings_.push_back(square);
+    }
+  }
+}
+
+// Whether `squares` is the smallest of its symmetry class, identical pieces
+// are sorted before the squares are compared.
+bool DataGenerator::Canonical(const int *squares) const {
+  int symmetries = material_.HasPawns() ? 2 : 8;
+  int mirrored[DATAGEN_MAX_PIECES];
+
+  for (int symmetry = 1; symmetry < symmetries; symmetry++) {
+    for (int i = 0; i < material_.size; i++) {
+      mirrored[i] = Transform(squares[i], symmetry);
+    }
+
+    for (int i = 0; i < material_.size;) {
+      int j = i + 1;
+
+      while (j < material_.size && material_.pieces[j] == material_.pieces[i] &&
+             material_.colors[j] == material_.colors[i]) {
+        j++;
+      }
+
+      // INFO: an insertion sort over the small array, std::sort's bounds
+      // can't be proven once inlined & trip -Warray-bounds
+      for (int k = i + 1; k < j; k++) {
+        int square = mirrored[k];
+        int l = k;
+
+        for (; l > i && mirrored[l - 1] > square; l--) {
+          mirrored[l] = mirrored[l - 1];
+        }
+
+        mirrored[l] = square;
+      }
+
+      i = j;
+    }
+
+    if (std::lexicographical_compare(mirrored, mirrored + material_.size,
+                                     squares, squares + material_.size)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool DataGenerator::Build(Position *position, const Sample &sample) const {
+  position::Placement placement;
+
+  for (int i = 0; i < material_.size; i++) {
+    placement.Add(material_.colors[i], material_.pieces[i], sample.squares[i]);
+  }
+
+  placement.turn = sample.turn;
+
+  return Position::ApplyPlacement(position, placement);
+}
+
+void DataGenerator::Enumerate(std::size_t slice,
+                              std::vector<Sample> *samples) const {
+  const int size = material_.size;
+  int squares[DATAGEN_MAX_PIECES] = {};
+  Position position;
+
+  squares[0] = kings_[slice / 64];
+  squares[1] = slice % 64;
+
+  auto same = [&](int i) {
+    return material_.pieces[i] == material_.pieces[i - 1] &&
+           material_.colors[i] == material_.colors[i - 1];
+  };
+
+  auto placeable = [&](int i) {
+    Bitboard bb = square::BB(squares[i]);
+
+    if (material_.pieces[i] == PAWN && bb & (kRank1 | kRank8)) {
+      return false;
+    }
+
+    for (int j = 0; j < i; j++) {
+      if (squares[j] == squares[i]) {
+        return false;
+      }
+    }
+
+    // INFO: identical pieces are placed in increasing order, once
+    return !same(i) || squares[i] > squares[i - 1];
+  };
+
+  auto emit = [&]() {
+    if (!Canonical(squares)) {
+      return;
+    }
+
+    Sample sample = {};
+
+    // INFO: the squares past `size` stay 0, a constant bound keeps the copy
+    // provably inside both arrays
+    std::copy(squares, squares + DATAGEN_MAX_PIECES, sample.squares);
+
+    // INFO: the side that just moved can't be left in check, touching kings
+    // are invalid with either side to move
+    for (Color turn : {WHITE, BLACK}) {
+      sample.turn = turn;
+
+      if (Build(&position, sample)) {
+        samples->push_back(sample);
+      }
+    }
+  };
+
+  auto place = [&](auto &self, int i) -> void {
+    if (i >= size || i >= DATAGEN_MAX_PIECES) {
+      emit();
+      return;
+    }
+
+    for (squares[i] = 0; squares[i] < 64; squares[i]++) {
+      if (placeable(i)) {
+        self(self, i + 1);
+      }
+    }
+  };
+
+  if (placeable(1)) {
+    place(place, 2);
+  }
+}
+
+bool DataGenerator::Probe(Sample *sample) const {
+  Position position;
+  int success;
+
+  if (!Build(&position, *sample)) {
+    return false;
+  }
+
+  int wdl = probe_wdl(position, &success);
+
+  if (!success) {
+    return false;
+  }
+
+  int dtz = probe_dtz(position, &success);
+
+  if (!success) {
+    return false;
+  }
+
+  sample->wdl = static_cast<std::int8_t>(wdl);
+  sample->dtz = static_cast<std::int16_t>(dtz);
+
+  return true;
+}
+
+static void WriteHeader(std::ostream &out, const Material &material,
+                        std::uint64_t samples) {
+  char buffer[DATAGEN_HEADER_SIZE] = {};
+  SampleHeader header = {DATAGEN_MAGIC,
+                         DATAGEN_VERSION,
+                         static_cast<std::uint32_t>(material.size),
+                         static_cast<std::uint32_t>(material.size + 3),
+                         samples,
+                         {}};
+  std::string signature = material.ToString();
+
+  signature.copy(header.signature, DATAGEN_SIGNATURE_SIZE - 1);
+  std::memcpy(buffer, &header, sizeof(header));
+
+  out.write(buffer, DATAGEN_HEADER_SIZE);
+}
+
+static void WriteRecord(std::string *buffer, const Material &material,
+                        const Sample &sample) {
+  std::uint16_t dtz = static_cast<std::uint16_t>(sample.dtz);
+
+  buffer->append(reinterpret_cast<const char *>(sample.squares),
+                 material.size);
+  buffer->push_back(static_cast<char>((sample.turn == BLACK) |
+                                      ((sample.wdl + 2) << 1)));
+  buffer->push_back(static_cast<char>(dtz & 0xff));
+  buffer->push_back(static_cast<char>(dtz >> 8));
+}
+
+bool DataGenerator::Generate(const std::string &path, DataGenStats *stats) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  std::vector<Sample> first;
+
+  if (!out) {
+    return false;
+  }
+
+  // INFO: the DTZ tables live in a shared most-recently-used list, probing a
+  // position first puts the signature at its head so that the workers only
+  // ever read it.
+  for (std::size_t slice = 0; first.empty() && slice < Slices(); slice++) {
+    Enumerate(slice, &first);
+  }
+
+  if (first.empty() || !Probe(&first[0])) {
+    return false;
+  }
+
+  WriteHeader(out, material_, 0);
+
+  std::size_t batch = 4 * scheduler_->Size() + 1;
+  std::vector<std::string> records(batch);
+  std::vector<DataGenStats> counts(batch);
+
+  for (std::size_t begin = 0; begin < Slices(); begin += batch) {
+    std::size_t end = std::min(begin + batch, Slices());
+
+    scheduler_->ParallelFor(
+        begin, end,
+        [&](std::size_t slice) {
+          std::vector<Sample> samples;
+          std::string &buffer = records[slice - begin];
+          DataGenStats &count = counts[slice - begin];
+
+          Enumerate(slice, &samples);
+
+          buffer.clear();
+          count = {};
+
+          for (Sample &sample : samples) {
+            if (Probe(&sample)) {
+              WriteRecord(&buffer, material_, sample);
+              count.positions++;
+            } else {
+              count.failed++;
+            }
+          }
+        },
+        1);
+
+    for (std::size_t i = 0; i < end - begin; i++) {
+      out.write(records[i].data(), records[i].size());
+
+      stats->positions += counts[i].positions;
+      stats->failed += counts[i].failed;
+    }
+  }
+
+  out.seekp(0);
+  WriteHeader(out, material_, stats->positions);
+
+  return static_cast<bool>(out);
+}
+
+bool WriteSamples(const std::string &path, const Material &material,
+                  const std::vector<Sample> &samples) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  std::string buffer;
+
+  for (const Sample &sample : samples) {
+    WriteRecord(&buffer, material, sample);
+  }
+
+  WriteHeader(out, material, samples.size());
+  out.write(buffer.data(), buffer.size());
+
+  return static_cast<bool>(out);
+}
+
+bool ReadSamples(const std::string &path, Material *material,
+                 std::vector<Sample> *samples) {
+  std::ifstream in(path, std::ios::binary);
+  char buffer[DATAGEN_HEADER_SIZE];
+  SampleHeader header;
+
+  if (!in.read(buffer, DATAGEN_HEADER_SIZE)) {
+    return false;
+  }
+
+  std::memcpy(&header, buffer, sizeof(header));
+  header.signature[DATAGEN_SIGNATURE_SIZE - 1] = '\0';
+
+  if (header.magic != DATAGEN_MAGIC || header.version != DATAGEN_VERSION ||
+      !ParseMaterial(material, header.signature) ||
+      header.pieces != static_cast<std::uint32_t>(material->size) ||
+      header.record != header.pieces + 3) {
+    return false;
+  }
+
+  std::vector<unsigned char> records(header.samples * header.record);
+
+  if (!in.read(reinterpret_cast<char *>(records.data()), records.size())) {
+    return false;
+  }
+
+  samples->resize(header.samples);
+
+  for (std::size_t i = 0; i < header.samples; i++) {
+    const unsigned char *record = &records[i * header.record];
+    unsigned char flags = record[header.pieces];
+    Sample &sample = (*samples)[i];
+
+    sample = {};
+
+    std::copy(record, record + header.pieces, sample.squares);
+    sample.turn = flags & 1 ? BLACK : WHITE;
+    sample.wdl = static_cast<std::int8_t>((flags >> 1) - 2);
+    sample.dtz = static_cast<std::int16_t>(record[header.pieces + 1] |
+                                           record[header.pieces + 2] << 8);
+  }
+
+  return true;
+}
+
+}  // namespace engine
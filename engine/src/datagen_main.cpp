@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "engine/datagen.hpp"
+#include "engine/scheduler.hpp"
+#include "tb/tbprobe.h"
+
+using namespace engine;
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  std::string material;
+  std::string tb;
+  std::string out;
+  int threads = std::thread::hardware_concurrency();
+};
+
+static void Usage(const char *program) {
+  std::printf(
+      "usage: %s --material <signature> --tb <paths> --out <file> "
+      "[options]\n"
+      "  --material <sig>  pieces to place, white's first, e.g. KRvK\n"
+      "  --tb <paths>      syzygy directories, separated by ':'\n"
+      "  --out <file>      where to write the samples\n"
+      "  --threads <n>     worker threads, defaults to the hardware threads\n",
+      program);
+}
+
+static bool ParseArgs(Config *config, int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--material" && has_value) {
+      config->material = argv[++i];
+    } else if (arg == "--tb" && has_value) {
+      config->tb = argv[++i];
+    } else if (arg == "--out" && has_value) {
+      config->out = argv[++i];
+    } else if (arg == "--threads" && has_value) {
+      config->threads = std::atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+
+  return !config->material.empty() && !config->tb.empty() &&
+         !config->out.empty() && config->threads > 0;
+}
+
+static double Elapsed(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+  Config config;
+  Material material;
+
+  if (!ParseArgs(&config, argc, argv)) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  if (!ParseMaterial(&material, config.material)) {
+    std::fprintf(stderr, "invalid material %s\n", config.material.c_str());
+    return 1;
+  }
+
+  std::vector<char> paths(config.tb.begin(), config.tb.end());
+
+  paths.push_back('\0');
+  init_tablebases(paths.data());
+
+  if (TBlargest < material.size) {
+    std::fprintf(stderr, "no %d-piece tablebases in %s\n", material.size,
+                 config.tb.c_str());
+    return 1;
+  }
+
+  Scheduler scheduler(config.threads);
+  DataGenerator generator(&scheduler, material);
+  DataGenStats stats;
+
+  scheduler.Init();
+
+  Clock::time_point start = Clock::now();
+
+  if (!generator.Generate(config.out, &stats)) {
+    std::fprintf(stderr, "unable to generate %s into %s\n",
+                 material.ToString().c_str(), config.out.c_str());
+    return 1;
+  }
+
+  double elapsed = Elapsed(start);
+
+  std::printf("%s: %lu position(s), %lu failed probe(s) in %.3fs (%.0f/s)\n",
+              material.ToString().c_str(), stats.positions, stats.failed,
+              elapsed, stats.positions / elapsed);
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include <cstdio>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/constants.hpp"
+#include "engine/datagen.hpp"
+#include "engine/move_gen.hpp"
+#include "engine/position.hpp"
+#include "engine/scheduler.hpp"
+#include "engine/square.hpp"
+#include "engine/types.hpp"
+
+using namespace engine;
+
+using Key = std::tuple<int, int, int, int>;
+
+class DataGenTestSuite : public testing::Test {
+ protected:
+  Scheduler scheduler;
+
+  DataGenTestSuite() : scheduler(2) {}
+
+  void SetUp() override { scheduler.Init(); }
+
+  std::vector<Sample> EnumerateAll(const DataGenerator &generator) {
+    std::vector<Sample> samples;
+
+    for (std::size_t slice = 0; slice < generator.Slices(); slice++) {
+      generator.Enumerate(slice, &samples);
+    }
+
+    return samples;
+  }
+
+  // the 8 symmetries of the board, diagonal mirror first
+  static int Mirror(int square, int symmetry) {
+    if (symmetry & 4) {
+      square = ((square & 7) << 3) | (square >> 3);
+    }
+
+    return square ^ (symmetry & 2 ? 56 : 0) ^ (symmetry & 1 ? 7 : 0);
+  }
+};
+
+TEST_F(DataGenTestSuite, ParseMaterial) {
+  Material material;
+
+  ASSERT_TRUE(ParseMaterial(&material, "KRvK"));
+  ASSERT_EQ(material.size, 3);
+  ASSERT_EQ(material.pieces[1], ROOK);
+  ASSERT_EQ(material.colors[2], BLACK);
+  ASSERT_FALSE(material.HasPawns());
+
+  // pieces are ordered from the king down
+  ASSERT_TRUE(ParseMaterial(&material, "KNRvKP"));
+  ASSERT_EQ(material.ToString(), "KRNvKP");
+  ASSERT_TRUE(material.HasPawns());
+
+  ASSERT_FALSE(ParseMaterial(&material, "KvK"));
+  ASSERT_FALSE(ParseMaterial(&material, "KR"));
+  ASSERT_FALSE(ParseMaterial(&material, "RKvK"));
+  ASSERT_FALSE(ParseMaterial(&material, "KRvKK"));
+  ASSERT_FALSE(ParseMaterial(&material, "KXvK"));
+  ASSERT_FALSE(ParseMaterial(&material, "KQRBNvKQ"));
+}
+
+TEST_F(DataGenTestSuite, EnumeratesEveryClassOnce) {
+  Material material;
+
+  ParseMaterial(&material, "KRvK");
+
+  DataGenerator generator(&scheduler, material);
+  std::set<Key> enumerated;
+
+  for (const Sample &sample : EnumerateAll(generator)) {
+    Key key = {sample.squares[0], sample.squares[1], sample.squares[2],
+               sample.turn};
+
+    ASSERT_TRUE(enumerated.insert(key).second);
+  }
+
+  // every legal position is a mirror of exactly one enumerated one
+  for (int king = 0; king < 64; king++) {
+    for (int rook = 0; rook < 64; rook++) {
+      for (int enemy = 0; enemy < 64; enemy++) {
+        if (king == rook || king == enemy || rook == enemy ||
+            kAttackMaps[KING][king] & square::BB(enemy)) {
+          continue;
+        }
+
+        Position position;
+
+        position.Reset();
+        position.SetPieceAt(WHITE, KING, king);
+        position.SetPieceAt(WHITE, ROOK, rook);
+        position.SetPieceAt(BLACK, KING, enemy);
+
+        for (Color turn : {WHITE, BLACK}) {
+          bool legal = turn == WHITE ? !Checkers<BLACK>(position)
+                                     : !Checkers<WHITE>(position);
+          std::set<Key> images;
+
+          for (int symmetry = 0; symmetry < 8; symmetry++) {
+            Key key = {Mirror(king, symmetry), Mirror(rook, symmetry),
+                       Mirror(enemy, symmetry), turn};
+
+            if (enumerated.count(key)) {
+              images.insert(key);
+            }
+          }
+
+          ASSERT_EQ(images.size(), legal ? 1u : 0u);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(DataGenTestSuite, PawnsOnlyMirrorFiles) {
+  Material material;
+
+  ParseMaterial(&material, "KPvK");
+
+  DataGenerator generator(&scheduler, material);
+  std::vector<Sample> samples = EnumerateAll(generator);
+
+  ASSERT_EQ(generator.Slices(), 32u * 64);
+  ASSERT_FALSE(samples.empty());
+
+  for (const Sample &sample : samples) {
+    ASSERT_LT(square::File(sample.squares[0]), 4);
+    ASSERT_FALSE(square::BB(sample.squares[1]) & (kRank1 | kRank8));
+  }
+}
+
+TEST_F(DataGenTestSuite, SamplesRoundTrip) {
+  Material material;
+  Material read;
+  std::vector<Sample> samples = {{{4, 0, 60}, WHITE, 2, 31},
+                                 {{3, 7, 35}, BLACK, -2, -100},
+                                 {{2, 9, 44}, BLACK, 0, 0}};
+  std::vector<Sample> loaded;
+  std::string path =
+      std::filesystem::temp_directory_path() / "datagen_test.bin";
+
+  ParseMaterial(&material, "KRvK");
+
+  ASSERT_TRUE(WriteSamples(path, material, samples));
+  ASSERT_TRUE(ReadSamples(path, &read, &loaded));
+
+  std::remove(path.c_str());
+
+  ASSERT_EQ(read.ToString(), "KRvK");
+  ASSERT_EQ(loaded.size(), samples.size());
+
+  for (std::size_t i = 0; i < samples.size(); i++) {
+    for (int j = 0; j < material.size; j++) {
+      ASSERT_EQ(loaded[i].squares[j], samples[i].squares[j]);
+    }
+
+    ASSERT_EQ(loaded[i].turn, samples[i].turn);
+    ASSERT_EQ(loaded[i].wdl, samples[i].wdl);
+    ASSERT_EQ(loaded[i].dtz, samples[i].dtz);
+  }
+}
@@ -0,0 +1,374 @@
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define EVAL_BATCH_X86_SIMD
+#endif
+
+#include "engine/board.hpp"
+#include "engine/constants.hpp"
+#include "engine/eval_batch.hpp"
+#include "engine/evaluation.hpp"
+#include "engine/fill.hpp"
+#include "engine/move_gen.hpp"
+#include "engine/position.hpp"
+#include "engine/score.hpp"
+#include "engine/types.hpp"
+
+namespace engine {
+
+// INFO: every kernel fills the features of positions [begin, end)
+using FeaturesFn = void (*)(const Bitboard *const (*)[PIECES], const Bitboard *,
+                            std::size_t, std::size_t, BatchFeatures *);
+
+// The set-wise terms are sums over directions instead of over pieces. Rays of
+// two sliders going the same way never overlap, the first one stops on the
+// second, so counting the union of a direction counts every piece's moves.
+static int RookMobility(Bitboard rooks, Bitboard empty_sqs,
+                       Bitboard movable_sqs) {
+  Bitboard north = MOVE_NORTH(NorthOccluded(rooks, empty_sqs));
+  Bitboard south = MOVE_SOUTH(SouthOccluded(rooks, empty_sqs));
+  Bitboard east = MOVE_EAST(EastOccluded(rooks, empty_sqs));
+  Bitboard west = MOVE_WEST(WestOccluded(rooks, empty_sqs));
+
+  return std::popcount(north & movable_sqs) +
+         std::popcount(south & movable_sqs) +
+         std::popcount(east & movable_sqs) + std::popcount(west & movable_sqs);
+}
+
+static int BishopMobility(Bitboard bishops, Bitboard empty_sqs,
+                          Bitboard movable_sqs) {
+  Bitboard north_east = MOVE_NORTH_EAST(NorthEastOccluded(bishops, empty_sqs));
+  Bitboard north_west = MOVE_NORTH_WEST(NorthWestOccluded(bishops, empty_sqs));
+  Bitboard south_east = MOVE_SOUTH_EAST(SouthEastOccluded(bishops, empty_sqs));
+  Bitboard south_west = MOVE_SOUTH_WEST(SouthWestOccluded(bishops, empty_sqs));
+
+  return std::popcount(north_east & movable_sqs) +
+         std::popcount(north_west & movable_sqs) +
+         std::popcount(south_east & movable_sqs) +
+         std::popcount(south_west & movable_sqs);
+}
+
+static int KnightMobility(Bitboard knights, Bitboard movable_sqs) {
+  return std::popcount((MOVE_NORTH_NORTH_EAST(knights)) & movable_sqs) +
+         std::popcount((MOVE_NORTH_EAST_EAST(knights)) & movable_sqs) +
+         std::popcount((MOVE_SOUTH_EAST_EAST(knights)) & movable_sqs) +
+         std::popcount((MOVE_SOUTH_SOUTH_EAST(knights)) & movable_sqs) +
+         std::popcount((MOVE_NORTH_NORTH_WEST(knights)) & movable_sqs) +
+         std::popcount((MOVE_NORTH_WEST_WEST(knights)) & movable_sqs) +
+         std::popcount((MOVE_SOUTH_WEST_WEST(knights)) & movable_sqs) +
+         std::popcount((MOVE_SOUTH_SOUTH_WEST(knights)) & movable_sqs);
+}
+
+static void ScalarFeatures(const Bitboard *const (*pieces)[PIECES],
+                           const Bitboard *occupied_sqs, std::size_t begin,
+                           std::size_t end, BatchFeatures *features) {
+  for (std::size_t i = begin; i < end; i++) {
+    Bitboard empty_sqs = ~occupied_sqs[i];
+    BatchFeatures &f = features[i];
+
+    f = {};
+
+    for (int color = WHITE; color < COLOR; color++) {
+      int sign = color == WHITE ? 1 : -1;
+      Bitboard rooks = pieces[color][ROOK][i];
+      Bitboard bishops = pieces[color][BISHOP][i];
+      Bitboard knights = pieces[color][KNIGHT][i];
+      Bitboard own_sqs = rooks | bishops | knights | pieces[color][KING][i] |
+                         pieces[color][QUEEN][i] | pieces[color][PAWN][i];
+
+      f.rooks_mobility += sign * (RookMobility(rooks, empty_sqs, ~own_sqs) -
+                                  7 * std::popcount(rooks));
+      f.bishops_mobility +=
+          sign * (BishopMobility(bishops, empty_sqs, ~own_sqs) -
+                  6 * std::popcount(bishops));
+      f.knights_mobility += sign * (KnightMobility(knights, ~own_sqs) -
+                                    4 * std::popcount(knights));
+    }
+
+    f.doubled_pawns = DoublePawns<WHITE>(pieces[WHITE][PAWN][i]) -
+                      DoublePawns<BLACK>(pieces[BLACK][PAWN][i]);
+  }
+}
+
+#ifdef EVAL_BATCH_X86_SIMD
+// INFO: AVX2 has no 64-bit popcount, count the nibbles through a shuffle &
+// sum the bytes of every lane.
+__attribute__((target("avx2"))) static inline __m256i Popcount(__m256i v) {
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+
+  __m256i low = _mm256_and_si256(v, low_mask);
+  __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  __m256i count = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                                  _mm256_shuffle_epi8(lookup, high));
+
+  return _mm256_sad_epu8(count, _mm256_setzero_si256());
+}
+
+template <int shift>
+__attribute__((target("avx2"))) static inline __m256i Shift(__m256i v) {
+  if constexpr (shift > 0) {
+    return _mm256_slli_epi64(v, shift);
+  } else {
+    return _mm256_srli_epi64(v, -shift);
+  }
+}
+
+// Kogge-Stone fill of every lane towards `shift`, then one more step onto the
+// blockers, `wrap` drops what went past the board edge.
+template <int shift>
+__attribute__((target("avx2"))) static inline __m256i Ray(__m256i gen,
+                                                          __m256i pro,
+                                                          __m256i wrap) {
+  pro = _mm256_and_si256(pro, wrap);
+  gen = _mm256_or_si256(gen, _mm256_and_si256(pro, Shift<shift>(gen)));
+  pro = _mm256_and_si256(pro, Shift<shift>(pro));
+  gen = _mm256_or_si256(gen, _mm256_and_si256(pro, Shift<2 * shift>(gen)));
+  pro = _mm256_and_si256(pro, Shift<2 * shift>(pro));
+  gen = _mm256_or_si256(gen, _mm256_and_si256(pro, Shift<4 * shift>(gen)));
+
+  return _mm256_and_si256(Shift<shift>(gen), wrap);
+}
+
+template <int shift>
+__attribute__((target("avx2"))) static inline __m256i Step(__m256i gen,
+                                                           __m256i wrap) {
+  return _mm256_and_si256(Shift<shift>(gen), wrap);
+}
+
+__attribute__((target("avx2"))) static void Avx2Features(
+    const Bitboard *const (*pieces)[PIECES], const Bitboard *occupied_sqs,
+    std::size_t begin, std::size_t end, BatchFeatures *features) {
+  const __m256i universe = _mm256_set1_epi64x(kUniverse);
+  const __m256i not_a = _mm256_set1_epi64x(~kAFile);
+  const __m256i not_h = _mm256_set1_epi64x(~kHFile);
+  const __m256i not_ab = _mm256_set1_epi64x(~(kAFile | kBFile));
+  const __m256i not_gh = _mm256_set1_epi64x(~(kGFile | kHFile));
+  const __m256i rank1 = _mm256_set1_epi64x(kRank1);
+
+  std::size_t i = begin;
+
+  for (; i + EVAL_BATCH_LANES <= end; i += EVAL_BATCH_LANES) {
+    __m256i empty_sqs = _mm256_xor_si256(
+        _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(occupied_sqs + i)),
+        universe);
+    __m256i counts[4] = {};
+
+    for (int color = WHITE; color < COLOR; color++) {
+      __m256i bb[PIECES];
+      __m256i own_sqs = _mm256_setzero_si256();
+
+      for (int piece = 0; piece < PIECES; piece++) {
+        bb[piece] = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(pieces[color][piece] + i));
+        own_sqs = _mm256_or_si256(own_sqs, bb[piece]);
+      }
+
+      __m256i movable_sqs = _mm256_xor_si256(own_sqs, universe);
+      __m256i rooks = bb[ROOK];
+      __m256i bishops = bb[BISHOP];
+      __m256i knights = bb[KNIGHT];
+
+      __m256i rook_moves = _mm256_add_epi64(
+          _mm256_add_epi64(
+              Popcount(_mm256_and_si256(Ray<8>(rooks, empty_sqs, universe),
+                                        movable_sqs)),
+              Popcount(_mm256_and_si256(Ray<-8>(rooks, empty_sqs, universe),
+                                        movable_sqs))),
+          _mm256_add_epi64(
+              Popcount(_mm256_and_si256(Ray<1>(rooks, empty_sqs, not_a),
+                                        movable_sqs)),
+              Popcount(_mm256_and_si256(Ray<-1>(rooks, empty_sqs, not_h),
+                                        movable_sqs))));
+
+      __m256i bishop_moves = _mm256_add_epi64(
+          _mm256_add_epi64(
+              Popcount(_mm256_and_si256(Ray<9>(bishops, empty_sqs, not_a),
+                                        movable_sqs)),
+              Popcount(_mm256_and_si256(Ray<7>(bishops, empty_sqs, not_h),
+                                        movable_sqs))),
+          _mm256_add_epi64(
+              Popcount(_mm256_and_si256(Ray<-7>(bishops, empty_sqs, not_a),
+                                        movable_sqs)),
+              Popcount(_mm256_and_si256(Ray<-9>(bishops, empty_sqs, not_h),
+                                        movable_sqs))));
+
+      __m256i knight_targets[8] = {
+          Step<17>(knights, not_a),  Step<10>(knights, not_ab),
+          Step<-6>(knights, not_ab), Step<-15>(knights, not_a),
+          Step<15>(knights, not_h),  Step<6>(knights, not_gh),
+          Step<-10>(knights, not_gh), Step<-17>(knights, not_h)};
+      __m256i knight_moves = _mm256_setzero_si256();
+
+      for (__m256i targets : knight_targets) {
+        knight_moves = _mm256_add_epi64(
+            knight_moves, Popcount(_mm256_and_si256(targets, movable_sqs)));
+      }
+
+      // same as DoublePawns, the files holding a pawn with another behind it
+      __m256i pawns = bb[PAWN];
+      __m256i north = Shift<8>(pawns);
+
+      north = _mm256_or_si256(north, Shift<8>(north));
+      north = _mm256_or_si256(north, Shift<16>(north));
+      north = _mm256_or_si256(north, Shift<32>(north));
+
+      __m256i doubled = _mm256_and_si256(pawns, north);
+
+      doubled = _mm256_or_si256(doubled, Shift<-8>(doubled));
+      doubled = _mm256_or_si256(doubled, Shift<-16>(doubled));
+      doubled = _mm256_or_si256(doubled, Shift<-32>(doubled));
+
+      __m256i side_counts[4] = {
+          _mm256_sub_epi64(
+              rook_moves,
+              _mm256_mul_epu32(Popcount(rooks), _mm256_set1_epi64x(7))),
+          _mm256_sub_epi64(
+              bishop_moves,
+              _mm256_mul_epu32(Popcount(bishops), _mm256_set1_epi64x(6))),
+          _mm256_sub_epi64(
+              knight_moves,
+              _mm256_slli_epi64(Popcount(knights), 2)),
+          Popcount(_mm256_and_si256(doubled, rank1))};
+
+      for (int j = 0; j < 4; j++) {
+        counts[j] = color == WHITE
+                        ? _mm256_add_epi64(counts[j], side_counts[j])
+                        : _mm256_sub_epi64(counts[j], side_counts[j]);
+      }
+    }
+
+    alignas(32) long long lanes[4][EVAL_BATCH_LANES];
+
+    for (int j = 0; j < 4; j++) {
+      _mm256_store_si256(reinterpret_cast<__m256i *>(lanes[j]), counts[j]);
+    }
+
+    for (int lane = 0; lane < EVAL_BATCH_LANES; lane++) {
+      features[i + lane] = {static_cast<int>(lanes[0][lane]),
+                            static_cast<int>(lanes[1][lane]),
+                            static_cast<int>(lanes[2][lane]),
+                            static_cast<int>(lanes[3][lane])};
+    }
+  }
+
+  ScalarFeatures(pieces, occupied_sqs, i, end, features);
+}
+#endif
+
+static void ResolveFeatures(const Bitboard *const (*pieces)[PIECES],
+                            const Bitboard *occupied_sqs, std::size_t begin,
+                            std::size_t end, BatchFeatures *features);
+
+// INFO: same lazy dispatch as SliderAttacks, resolved on first use
+static std::atomic<FeaturesFn> features_fn = ResolveFeatures;
+
+static void ResolveFeatures(const Bitboard *const (*pieces)[PIECES],
+                            const Bitboard *occupied_sqs, std::size_t begin,
+                            std::size_t end, BatchFeatures *features) {
+  FeaturesFn fn = ScalarFeatures;
+
+#ifdef EVAL_BATCH_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    fn = Avx2Features;
+  }
+#endif
+
+  features_fn.store(fn, std::memory_order_relaxed);
+
+  fn(pieces, occupied_sqs, begin, end, features);
+}
+
+void EvalBatch::Add(const Position &position) {
+  for (int color = WHITE; color < COLOR; color++) {
+    for (int piece = 0; piece < PIECES; piece++) {
+      pieces_[color][piece].push_back(position.board_.pieces[color][piece]);
+    }
+  }
+
+  occupied_sqs_.push_back(position.board_.occupied_sqs);
+  psq_.push_back(position.psq_);
+  phase_.push_back(position.phase_);
+  side_to_move_.push_back(position.turn_ == WHITE ? 1 : -1);
+}
+
+void EvalBatch::Clear() {
+  for (int color = WHITE; color < COLOR; color++) {
+    for (int piece = 0; piece < PIECES; piece++) {
+      pieces_[color][piece].clear();
+    }
+  }
+
+  occupied_sqs_.clear();
+  psq_.clear();
+  phase_.clear();
+  side_to_move_.clear();
+}
+
+void EvalBatch::Features(BatchFeatures *features) const {
+  const Bitboard *pieces[COLOR][PIECES];
+
+  for (int color = WHITE; color < COLOR; color++) {
+    for (int piece = 0; piece < PIECES; piece++) {
+      pieces[color][piece] = pieces_[color][piece].data();
+    }
+  }
+
+  features_fn.load(std::memory_order_relaxed)(pieces, occupied_sqs_.data(), 0,
+                                              Size(), features);
+}
+
+// INFO: terms that walk the pieces one at a time are left to the Eval*
+// functions, the set-wise ones come from `features`. The weak pawns & the
+// attack maps passed pawns need stay scalar, IsolatedPawns drops the
+// neighbours of every pawn it looks at so its count depends on the scan order.
+int EvalBatch::EvaluateOne(std::size_t i,
+                           const BatchFeatures &features) const {
+  Board board;
+  position::AttackInfo info{};
+
+  for (int color = WHITE; color < COLOR; color++) {
+    for (int piece = 0; piece < PIECES; piece++) {
+      board.pieces[color][piece] = pieces_[color][piece][i];
+    }
+  }
+
+  board.occupied_sqs = occupied_sqs_[i];
+
+  position::AttackMaps(board, &info);
+
+  EvalState state(board.pieces[WHITE].data(), board.pieces[BLACK].data(),
+                  board.occupied_sqs, psq_[i], phase_[i]);
+
+  state.LoadAttacks(info);
+
+  Score score =
+      kWeights[TEMPO] * side_to_move_[i] + EvalMaterials(state) +
+      kWeights[ROOK_MOBILITY] * features.rooks_mobility +
+      kWeights[BISHOP_MOBILITY] * features.bishops_mobility +
+      kWeights[KNIGHT_MOBILITY] * features.knights_mobility +
+      EvalKingDistance(state) + EvalOpenFile(state) + EvalRank7(state) -
+      kWeights[DOUBLED_PAWNS] * features.doubled_pawns -
+      EvalWeakPawns(state) + EvalKingPosition(state) + EvalPassedPawns(state);
+
+  return Taper(score, state.phase);
+}
+
+void EvalBatch::Evaluate(int *scores) const {
+  std::vector<BatchFeatures> features(Size());
+
+  Features(features.data());
+
+  for (std::size_t i = 0; i < Size(); i++) {
+    scores[i] = EvaluateOne(i, features[i]);
+  }
+}
+
+}  // namespace engine
@@ -0,0 +1,91 @@
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/eval_batch.hpp"
+#include "engine/evaluation.hpp"
+#include "engine/move.hpp"
+#include "engine/position.hpp"
+#include "engine/types.hpp"
+
+using namespace engine;
+
+class EvalBatchTestSuite : public testing::Test {
+ protected:
+  EvalBatch batch;
+  std::vector<Position> positions;
+
+  // every position a legal move away from the fens, sizes that aren't a
+  // multiple of the lanes exercise the scalar tail too.
+  void SetUp() override {
+    const char *fens[] = {
+        kStartPos,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 b kq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r1b1k2r/1pp2ppp/p1pb4/8/3PP3/2P2N2/PP3PPP/R1B1K2R b KQkq - 0 1",
+        "8/pp3p2/2p1kP2/4P1p1/P2P4/2P5/1P4PP/6K1 w - - 0 1"};
+
+    for (const char *fen : fens) {
+      Position position = Position::FromFen(fen);
+
+      positions.push_back(position);
+
+      for (Move &move : position.LegalMoves()) {
+        position.Make(move);
+        positions.push_back(position);
+        position.Undo(move);
+      }
+    }
+
+    for (const Position &position : positions) {
+      batch.Add(position);
+    }
+  }
+
+  void TearDown() override { batch.Clear(); }
+};
+
+TEST_F(EvalBatchTestSuite, FeaturesMatchScalarTerms) {
+  std::vector<BatchFeatures> features(batch.Size());
+
+  batch.Features(features.data());
+
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    EvalState state = EvalState::For(positions[i]);
+
+    ASSERT_EQ(features[i].rooks_mobility,
+              RooksMobility<WHITE>(state) - RooksMobility<BLACK>(state));
+    ASSERT_EQ(features[i].bishops_mobility,
+              BishopsMobility<WHITE>(state) - BishopsMobility<BLACK>(state));
+    ASSERT_EQ(features[i].knights_mobility,
+              KnightsMobility<WHITE>(state) - KnightsMobility<BLACK>(state));
+    ASSERT_EQ(features[i].doubled_pawns,
+              DoublePawns<WHITE>(state.white_pieces[PAWN]) -
+                  DoublePawns<BLACK>(state.black_pieces[PAWN]));
+  }
+}
+
+TEST_F(EvalBatchTestSuite, EvaluateMatchesScalarEvaluate) {
+  std::vector<int> scores(batch.Size());
+
+  batch.Evaluate(scores.data());
+
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    ASSERT_EQ(scores[i], Evaluate(positions[i]));
+  }
+}
+
+TEST_F(EvalBatchTestSuite, DoublePawns) {
+  Position position = Position::FromFen("8/8/8/P7/P1P5/P1P5/1P6/8 w - - 0 1");
+  EvalState state = EvalState::For(position);
+
+  // a & c files, the lone b pawn doesn't count
+  ASSERT_EQ(DoublePawns<WHITE>(state.white_pieces[PAWN]), 2);
+
+  position = Position::FromFen("8/1p6/p1p5/p1p5/p7/8/8/8 w - - 0 1");
+  state = EvalState::For(position);
+
+  ASSERT_EQ(DoublePawns<BLACK>(state.black_pieces[PAWN]), 2);
+}
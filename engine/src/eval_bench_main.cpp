@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine/eval_batch.hpp"
+#include "engine/evaluation.hpp"
+#include "engine/perft.hpp"
+#include "engine/position.hpp"
+#include "engine/types.hpp"
+
+using namespace engine;
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  std::string epd;
+  std::size_t positions = 1 << 16;
+  int rounds = 10;
+};
+
+static void Usage(const char *program) {
+  std::printf(
+      "usage: %s [options]\n"
+      "  --epd <file>     positions to evaluate, defaults to the start "
+      "position\n"
+      "  --positions <n>  batch size, the positions are repeated to fill it\n"
+      "  --rounds <n>     times every batch is evaluated\n",
+      program);
+}
+
+static bool ParseArgs(Config *config, int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--epd" && has_value) {
+      config->epd = argv[++i];
+    } else if (arg == "--positions" && has_value) {
+      config->positions = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--rounds" && has_value) {
+      config->rounds = std::atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+
+  return config->positions > 0 && config->rounds > 0;
+}
+
+static double Elapsed(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool LoadFens(const Config &config, std::vector<std::string> *fens) {
+  if (config.epd.empty()) {
+    fens->push_back(kStartPos);
+    return true;
+  }
+
+  std::string line;
+  std::ifstream file(config.epd);
+
+  if (!file) {
+    std::fprintf(stderr, "unable to open %s\n", config.epd.c_str());
+    return false;
+  }
+
+  while (std::getline(file, line)) {
+    PerftCase perft_case;
+
+    if (ParseEPD(&perft_case, line)) {
+      fens->push_back(perft_case.fen);
+    }
+  }
+
+  return !fens->empty();
+}
+
+int main(int argc, char **argv) {
+  Config config;
+  std::vector<std::string> fens;
+
+  if (!ParseArgs(&config, argc, argv)) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  if (!LoadFens(config, &fens)) {
+    return 1;
+  }
+
+  std::vector<Position> positions;
+  EvalBatch batch;
+
+  positions.reserve(config.positions);
+
+  for (std::size_t i = 0; i < config.positions; i++) {
+    positions.push_back(Position::FromFen(fens[i % fens.size()]));
+    batch.Add(positions.back());
+  }
+
+  std::vector<int> scalar(positions.size());
+  std::vector<int> batched(positions.size());
+  std::vector<BatchFeatures> features(positions.size());
+  double total = static_cast<double>(positions.size()) * config.rounds;
+
+  // INFO: evaluated in place, SetTurn drops the cached attack info like a
+  // move does so every round computes it again, as the search & the batch do
+  Clock::time_point start = Clock::now();
+
+  for (int round = 0; round < config.rounds; round++) {
+    for (std::size_t i = 0; i < positions.size(); i++) {
+      positions[i].SetTurn(positions[i].Turn());
+      scalar[i] = Evaluate(positions[i]);
+    }
+  }
+
+  double scalar_seconds = Elapsed(start);
+
+  start = Clock::now();
+
+  for (int round = 0; round < config.rounds; round++) {
+    batch.Evaluate(batched.data());
+  }
+
+  double batched_seconds = Elapsed(start);
+
+  start = Clock::now();
+
+  for (int round = 0; round < config.rounds; round++) {
+    batch.Features(features.data());
+  }
+
+  double features_seconds = Elapsed(start);
+  std::size_t mismatches = 0;
+
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    mismatches += scalar[i] != batched[i];
+  }
+
+  std::printf("%zu position(s), %zu fen(s), %d round(s)\n", positions.size(),
+              fens.size(), config.rounds);
+  std::printf("scalar   time=%.3fs pos/s=%.0f\n", scalar_seconds,
+              total / scalar_seconds);
+  std::printf("batched  time=%.3fs pos/s=%.0f\n", batched_seconds,
+              total / batched_seconds);
+  std::printf("features time=%.3fs pos/s=%.0f\n", features_seconds,
+              total / features_seconds);
+  std::printf("%zu mismatch(es)\n", mismatches);
+
+  return mismatches != 0;
+}
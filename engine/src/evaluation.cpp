@@ -1,7 +1,9 @@
 #include <array>
 #include <bit>
-#include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <format>
+#include <string>
 #include <tuple>
 #include <utility>
 
@@ -10,179 +12,188 @@
 #include "engine/evaluation.hpp"
 #include "engine/fill.hpp"
 #include "engine/move_gen.hpp"
+#include "engine/network.hpp"
 #include "engine/position.hpp"
 #include "engine/square.hpp"
 #include "engine/types.hpp"
 
 namespace engine {
 
-const int kWeights[26][2] = {{500, 500},
-                             {325, 325},
-                             {325, 325},
-                             {2000, 2000},
-                             {975, 975},
-                             {70, 90},
-                             // bishop pair values
-                             {50, 50},
-                             // pawns structure
-                             {10, 20},
-                             {10, 20},
-                             {20, 20},
-                             {8, 10},
-                             {16, 10},
-                             {5, 10},
-                             // tempo
-                             {20, 10},
-                             // knight mobility
-                             {4, 4},
-                             // bishop mobility
-                             {5, 5},
-                             // rook mobility
-                             {2, 4},
-                             // file
-                             {-10, -10},
-                             {0, 0},
-                             {10, 0},
-                             {20, 0},
-                             {10, 10},
-                             {20, 10},
-                             {30, 10},
-                             // 7th rank
-                             {20, 40},
-                             {10, 20}};
-
-const float kRankBonus[] = {0, 0, 0.1, 0.3, 0.6, 1};
-
-void EvalState::ComputeMaterials() {
-  for (int i = 0; i < PIECES; i++) {
-    Piece piece = static_cast<Piece>(i);
-
-    materials[WHITE][piece] = std::popcount(white_pieces[piece]);
-    materials[BLACK][piece] = std::popcount(black_pieces[piece]);
-
-    materials[DIFF][piece] = materials[WHITE][piece] - materials[BLACK][piece];
-    materials[SUM][piece] = materials[WHITE][piece] + materials[BLACK][piece];
+void EvalState::ComputePhase(int phase_weight) {
+  int score = TOTAL_PHASE - phase_weight;
+
+  phase = (score * 256 + (TOTAL_PHASE / 2)) / TOTAL_PHASE;
+}
+
+EvalState EvalState::For(const Position &position, bool attacks) {
+  const PieceList &white_pieces = position.Pieces(WHITE);
+  const PieceList &black_pieces = position.Pieces(BLACK);
+  Bitboard occupied_sqs = position.board_.occupied_sqs;
+
+  EvalState state(white_pieces.data(), black_pieces.data(), occupied_sqs,
+                  position.psq_, position.phase_);
+
+  if (attacks) {
+    // INFO: shared with move generation, whichever runs first computes it
+    state.LoadAttacks(position.Attacks());
   }
+
+  return state;
 }
 
-void EvalState::ComputePhase() {
-  int score = TOTAL_PHASE - (4 * materials[SUM][QUEEN]) -
-              (2 * materials[SUM][ROOK]) - (materials[SUM][BISHOP]) -
-              (materials[SUM][KNIGHT]);
+void EvalState::LoadAttacks(const position::AttackInfo &info) {
+  check_mask = info.check_mask;
+  pin_hv_mask = info.pin_hv_mask;
+  pin_diag_mask = info.pin_diag_mask;
 
-  phase = (score * 256 + (TOTAL_PHASE / 2)) / TOTAL_PHASE;
+  attack_map[WHITE] = info.attacks[WHITE];
+  attack_map[BLACK] = info.attacks[BLACK];
 }
 
-// TODO: maybe apply pin masks to filter what pieces attacks are counted
-template <enum Color side>
-void EvalState::ComputeAttackMap() {
-  const Bitboard *side_pieces;
+LazyEvalStats lazy_eval_stats;
 
-  if constexpr (side == WHITE) {
-    side_pieces = white_pieces;
-  } else {
-    side_pieces = black_pieces;
+void LazyEvalStats::Reset() {
+  lazy_eval_stats.calls = 0;
+
+  for (std::atomic<std::uint64_t> &exits : lazy_eval_stats.exits) {
+    exits = 0;
   }
+}
 
-  Bitboard queens_and_bishops = side_pieces[QUEEN] | side_pieces[BISHOP];
-  Bitboard queens_and_rooks = side_pieces[QUEEN] | side_pieces[ROOK];
+std::string LazyEvalStats::Report() {
+#ifdef EVAL_STATS
+  static const char *kStages[EVAL_STAGES] = {"material", "pawns", "full"};
 
-  attack_map[side] = kEmpty;
-  attack_map[side] |= PawnTargets<side>(side_pieces[PAWN]) |
-                      KNIGHT_ATTACKS(side_pieces[KNIGHT]) |
-                      KING_ATTACKS(side_pieces[KING]);
+  std::uint64_t calls = lazy_eval_stats.calls.load();
+  std::string str = std::format("lazy eval: calls={}", calls);
 
-  BITLOOP(queens_and_bishops) {
-    attack_map[side] |= kSlidingAttacks.Bishop(occupied_sqs, LOOP_INDEX);
-  }
+  for (int i = 0; i < EVAL_STAGES; i++) {
+    std::uint64_t exits = lazy_eval_stats.exits[i].load();
 
-  BITLOOP(queens_and_rooks) {
-    attack_map[side] |= kSlidingAttacks.Rook(occupied_sqs, LOOP_INDEX);
+    str.append(std::format(" {}={} ({:.2f}%)", kStages[i], exits,
+                           calls ? 100.0 * exits / calls : 0.0));
   }
-}
 
-EvalState EvalState::For(const Position &position) {
-  const PieceList &white_pieces = position.Pieces(WHITE);
-  const PieceList &black_pieces = position.Pieces(BLACK);
-  Bitboard occupied_sqs = position.board_.occupied_sqs;
+  str.append("\n");
 
-  // TODO: maybe move position mask computation into the position
-  // class so as to avoid double computation of these masks.
-  Bitboard check_mask = CheckMask(position);
-  auto [pin_hv_mask, pin_diag_mask] = PinMask(position);
+  return str;
+#else
+  return "eval statistics are disabled, build with EVAL_STATS\n";
+#endif
+}
 
-  return {white_pieces.data(), black_pieces.data(), occupied_sqs,
-          check_mask,          pin_hv_mask,         pin_diag_mask};
+static inline void CountExit([[maybe_unused]] EvalStage stage) {
+#ifdef EVAL_STATS
+  lazy_eval_stats.calls.fetch_add(1, std::memory_order_relaxed);
+  lazy_eval_stats.exits[stage].fetch_add(1, std::memory_order_relaxed);
+#endif
 }
 
-// TODO: Position table, Pattern, King, Passed Pawn
-// convert score to float
-int Evaluate(Position &position) {
+// TODO: Pattern, King, Passed Pawn
+int Evaluate(Position &position, EvalTrace *trace) {
+  int network_score;
+
+  // INFO: a traced position has to be scored by the weights being tuned
+  if (trace == nullptr && network::Evaluate(position, &network_score)) {
+    return network_score;
+  }
+
   EvalState state = EvalState::For(position);
   int side_to_move = position.turn_ == WHITE ? 1 : -1;
 
-  auto [opening_pieces, endgame_pieces] = EvalPieces(state);
-  auto [opening_materials, endgame_materials] = EvalMaterials(state);
-  auto [opening_pawn_structure, endgame_pawn_structure] =
-      EvalPawnStructure(state);
-  auto opening_king_position = EvalKingPosition(state);
+  state.trace = trace;
+  state.Trace(TEMPO, side_to_move);
 
-  auto [opening_tempo, endgame_tempo] = std::make_pair(
-      kWeights[TEMPO][0] * side_to_move, kWeights[TEMPO][1] * side_to_move);
+  Score score = kWeights[TEMPO] * side_to_move + EvalMaterials(state) +
+                EvalPieces(state) - EvalPawnStructure(state) +
+                EvalKingPosition(state) + EvalPassedPawns(state);
 
-  auto [opening_passed_pawns, endgame_passed_pawns] = EvalPassedPawns(state);
+  return Taper(score, state.phase);
+}
 
-  int opening = opening_tempo + opening_materials + opening_pieces -
-                opening_pawn_structure + opening_king_position +
-                opening_passed_pawns;
-  int endgame = endgame_tempo + endgame_materials + endgame_pieces -
-                endgame_pawn_structure + endgame_passed_pawns;
+int Evaluate(Position &position, int alpha, int beta) {
+  int network_score;
 
-  return TAPER_EVAL(opening, endgame, state.phase);
-}
+  if (network::Evaluate(position, &network_score)) {
+    return network_score;
+  }
+
+  EvalState state = EvalState::For(position, false);
+  int side_to_move = position.turn_ == WHITE ? 1 : -1;
+
+  // material & piece-square scores are incremental, next to free
+  Score score = kWeights[TEMPO] * side_to_move + EvalMaterials(state);
+  int lazy = Taper(score, state.phase);
+
+  if (lazy + LAZY_EVAL_MATERIAL_MARGIN <= alpha ||
+      lazy - LAZY_EVAL_MATERIAL_MARGIN >= beta) {
+    CountExit(EVAL_MATERIAL);
+    return lazy;
+  }
+
+  // pawn structure only looks at the pawns
+  score -= EvalPawnStructure(state);
+  lazy = Taper(score, state.phase);
+
+  if (lazy + LAZY_EVAL_PAWNS_MARGIN <= alpha ||
+      lazy - LAZY_EVAL_PAWNS_MARGIN >= beta) {
+    CountExit(EVAL_PAWNS);
+    return lazy;
+  }
+
+  state.LoadAttacks(position.Attacks());
 
-std::pair<int, int> EvalMaterials(EvalState &state) {
-  int scores[2];
-  int white_bishop_pair = 0;
-  int black_bishop_pair = 0;
+  score += EvalPieces(state) + EvalKingPosition(state) + EvalPassedPawns(state);
 
-  int pawns = state.materials[DIFF][PAWN];
-  int kings = state.materials[DIFF][KING];
-  int queens = state.materials[DIFF][QUEEN];
-  int rooks = state.materials[DIFF][ROOK];
-  int bishops = state.materials[DIFF][BISHOP];
-  int knights = state.materials[DIFF][KNIGHT];
+  CountExit(EVAL_FULL);
 
+  return Taper(score, state.phase);
+}
+
+// INFO: material & piece-square scores are kept up to date by the position,
+// only the bishop pair is left to look at.
+Score EvalMaterials(EvalState &state) {
   Bitboard white_bishops = state.white_pieces[BISHOP];
   Bitboard black_bishops = state.black_pieces[BISHOP];
 
-  white_bishop_pair =
+  int white_bishop_pair =
       kLightSquares & white_bishops && kDarkSquares & white_bishops;
 
-  black_bishop_pair =
+  int black_bishop_pair =
       kLightSquares & black_bishops && kDarkSquares & black_bishops;
 
-  for (int i = 0; i < 2; i++) {
-    scores[i] =
-        (kWeights[PAWN][i] * pawns) + (kWeights[KING][i] * kings) +
-        (kWeights[QUEEN][i] * queens) + (kWeights[ROOK][i] * rooks) +
-        (kWeights[BISHOP][i] * bishops) + (kWeights[KNIGHT][i] * knights) +
-        (kWeights[BISHOP_PAIR][i] * (white_bishop_pair - black_bishop_pair));
+  if (state.trace != nullptr) {
+    for (int piece = 0; piece < PIECES; piece++) {
+      state.Trace(piece, std::popcount(state.white_pieces[piece]) -
+                             std::popcount(state.black_pieces[piece]));
+    }
+
+    state.Trace(BISHOP_PAIR, white_bishop_pair - black_bishop_pair);
   }
 
-  return std::make_pair(scores[0], scores[1]);
+  return state.psq +
+         kWeights[BISHOP_PAIR] * (white_bishop_pair - black_bishop_pair);
 }
 
 // TODO: maybe include the "candidate" property from fruits/TOGA
-std::pair<float, float> EvalPawnStructure(EvalState &state) {
-  float scores[2];
+Score EvalPawnStructure(EvalState &state) {
   Bitboard white_pawns = state.white_pieces[PAWN];
   Bitboard black_pawns = state.black_pieces[PAWN];
-  Bitboard empty_sqs = ~(white_pawns | black_pawns);
 
   int double_pawns =
       DoublePawns<WHITE>(white_pawns) - DoublePawns<BLACK>(black_pawns);
 
+  // INFO: pawn structure is a penalty, always subtracted from the score
+  state.Trace(DOUBLED_PAWNS, -double_pawns);
+
+  return (kWeights[DOUBLED_PAWNS] * double_pawns) + EvalWeakPawns(state);
+}
+
+Score EvalWeakPawns(EvalState &state) {
+  Bitboard white_pawns = state.white_pieces[PAWN];
+  Bitboard black_pawns = state.black_pieces[PAWN];
+  Bitboard empty_sqs = ~(white_pawns | black_pawns);
+
   auto [white_isolated_pawns, white_open_isolated_pawns] =
       IsolatedPawns<WHITE>(white_pawns, empty_sqs);
   auto [black_isolated_pawns, black_open_isolated_pawns] =
@@ -201,47 +212,31 @@ std::pair<float, float> EvalPawnStructure(EvalState &state) {
   int open_backward_pawns =
       white_open_backward_pawns - black_open_backward_pawns;
 
-  for (int i = 0; i < 2; i++) {
-    scores[i] = (kWeights[DOUBLED_PAWNS][i] * double_pawns) +
-                (kWeights[ISOLATED_PAWNS][i] * isolated_pawns) +
-                (kWeights[BACKWARD_PAWNS][i] * backward_pawns) +
-                (kWeights[ISOLATED_AND_OPEN_PAWNS][i] * open_isolated_pawns) +
-                (kWeights[BACKWARD_AND_OPEN_PAWNS][i] * open_backward_pawns);
-  }
+  state.Trace(ISOLATED_PAWNS, -isolated_pawns);
+  state.Trace(BACKWARD_PAWNS, -backward_pawns);
+  state.Trace(ISOLATED_AND_OPEN_PAWNS, -open_isolated_pawns);
+  state.Trace(BACKWARD_AND_OPEN_PAWNS, -open_backward_pawns);
 
-  return std::make_pair(scores[0], scores[1]);
+  return (kWeights[ISOLATED_PAWNS] * isolated_pawns) +
+         (kWeights[BACKWARD_PAWNS] * backward_pawns) +
+         (kWeights[ISOLATED_AND_OPEN_PAWNS] * open_isolated_pawns) +
+         (kWeights[BACKWARD_AND_OPEN_PAWNS] * open_backward_pawns);
 }
 
 // TODO: knight outpost
-std::pair<int, int> EvalPieces(EvalState &state) {
-  int king_distance = EvalKingDistance(state);
-  auto [opening_mobility, endgame_mobility] = EvalMobility(state);
-  auto [opening_open_line, endgame_open_line] = EvalOpenFile(state);
-  auto [opening_7th_rank, endgame_7th_rank] = EvalRank7(state);
-
-  int opening =
-      opening_mobility + opening_open_line + opening_7th_rank + king_distance;
-  int endgame =
-      endgame_mobility + endgame_open_line + endgame_7th_rank + king_distance;
-
-  return std::make_pair(opening, endgame);
+Score EvalPieces(EvalState &state) {
+  return EvalKingDistance(state) + EvalMobility(state) + EvalOpenFile(state) +
+         EvalRank7(state);
 }
 
-std::pair<float, float> EvalPassedPawns(EvalState &state) {
-  auto [opening_white_passed_pawns, endgame_white_passed_pawns] =
-      PassedPawns<WHITE>(state);
-
-  auto [opening_black_passed_pawns, endgame_black_passed_pawns] =
-      PassedPawns<BLACK>(state);
-
-  float opening = opening_white_passed_pawns - opening_black_passed_pawns;
-  float endgame = endgame_white_passed_pawns - endgame_black_passed_pawns;
-
-  return std::make_pair(opening, endgame);
+Score EvalPassedPawns(EvalState &state) {
+  return PassedPawns<WHITE>(state) - PassedPawns<BLACK>(state);
 }
 
-int EvalKingPosition(EvalState &state) {
-  return -(KingPosition<WHITE>(state) - KingPosition<BLACK>(state));
+// INFO: king safety only matters in the opening
+Score EvalKingPosition(EvalState &state) {
+  return MakeScore(-(KingPosition<WHITE>(state) - KingPosition<BLACK>(state)),
+                   0);
 }
 
 // TODO: consider the castling rights while looking at pawn shelter
@@ -298,7 +293,7 @@ int KingPosition(EvalState &state) {
       distance = 7 - std::abs(rank - 8);
     }
 
-    int penalty = 36 - std::pow(distance, 2);
+    int penalty = 36 - distance * distance;
 
     if (bb & king_file) {
       penalty *= 2;
@@ -391,40 +386,36 @@ int KingPosition(EvalState &state) {
     }
   }
 
-  static std::array<float, 8> PA_WEIGHTS{0,    0,    0.5,  0.75,
-                                         0.88, 0.94, 0.97, 0.99};
+  static constexpr std::array<int, 8> PA_WEIGHTS{0,  0,  50, 75,
+                                                 88, 94, 97, 99};
 
   int attackers_count = std::popcount(attackers);
-  int attackers_score = 20 * attackers_value * PA_WEIGHTS[attackers_count];
+  int attackers_score =
+      20 * attackers_value * PA_WEIGHTS[attackers_count] / BONUS_SCALE;
 
   return shelter_penalty + hostile_pawns_penalty - attackers_score;
 }
 
-std::pair<int, int> EvalMobility(EvalState &state) {
-  int scores[2];
-
-  for (int i = 0; i < 2; i++) {
-    int rooks_mobility =
-        kWeights[ROOK_MOBILITY][i] *
-        (RooksMobility<WHITE>(state) - RooksMobility<BLACK>(state));
+Score EvalMobility(EvalState &state) {
+  int rooks_mobility =
+      RooksMobility<WHITE>(state) - RooksMobility<BLACK>(state);
 
-    int bishop_mobility =
-        kWeights[BISHOP_MOBILITY][i] *
-        (BishopsMobility<WHITE>(state) - BishopsMobility<BLACK>(state));
+  int bishop_mobility =
+      BishopsMobility<WHITE>(state) - BishopsMobility<BLACK>(state);
 
-    int knight_mobility =
-        kWeights[KNIGHT_MOBILITY][i] *
-        (KnightsMobility<WHITE>(state) - KnightsMobility<BLACK>(state));
+  int knight_mobility =
+      KnightsMobility<WHITE>(state) - KnightsMobility<BLACK>(state);
 
-    scores[i] = rooks_mobility + bishop_mobility + knight_mobility;
-  }
+  state.Trace(ROOK_MOBILITY, rooks_mobility);
+  state.Trace(BISHOP_MOBILITY, bishop_mobility);
+  state.Trace(KNIGHT_MOBILITY, knight_mobility);
 
-  return std::make_pair(scores[0], scores[1]);
+  return (kWeights[ROOK_MOBILITY] * rooks_mobility) +
+         (kWeights[BISHOP_MOBILITY] * bishop_mobility) +
+         (kWeights[KNIGHT_MOBILITY] * knight_mobility);
 }
 
-std::pair<int, int> EvalOpenFile(EvalState &state) {
-  int scores[2];
-
+Score EvalOpenFile(EvalState &state) {
   int closed_files = ClosedFiles<WHITE>(state) - ClosedFiles<BLACK>(state);
 
   // semi-open files
@@ -457,64 +448,55 @@ std::pair<int, int> EvalOpenFile(EvalState &state) {
   int open_files_same_enemy_king =
       white_open_files_same_enemy_king - black_open_files_same_enemy_king;
 
-  for (int i = 0; i < 2; i++) {
-    scores[i] =
-        (kWeights[CLOSED_FILE][i] * closed_files) +
-        (kWeights[SEMI_OPEN_FILE][i] * semi_open_files) +
-        (kWeights[SEMI_OPEN_FILE_ADJ_ENEMY_KING][i] *
-         semi_open_files_adj_enemy_king) +
-        (kWeights[SEMI_OPEN_FILE_SAME_ENEMY_KING][i] *
-         semi_open_files_same_enemy_king) +
-        (kWeights[OPEN_FILE][i] * open_files) +
-        (kWeights[OPEN_FILE_ADJ_ENEMY_KING][i] * open_files_adj_enemy_king) +
-        (kWeights[OPEN_FILE_SAME_ENEMY_KING][i] * open_files_same_enemy_king);
-  }
-
-  return std::make_pair(scores[0], scores[1]);
+  state.Trace(CLOSED_FILE, closed_files);
+  state.Trace(SEMI_OPEN_FILE, semi_open_files);
+  state.Trace(SEMI_OPEN_FILE_ADJ_ENEMY_KING, semi_open_files_adj_enemy_king);
+  state.Trace(SEMI_OPEN_FILE_SAME_ENEMY_KING, semi_open_files_same_enemy_king);
+  state.Trace(OPEN_FILE, open_files);
+  state.Trace(OPEN_FILE_ADJ_ENEMY_KING, open_files_adj_enemy_king);
+  state.Trace(OPEN_FILE_SAME_ENEMY_KING, open_files_same_enemy_king);
+
+  return (kWeights[CLOSED_FILE] * closed_files) +
+         (kWeights[SEMI_OPEN_FILE] * semi_open_files) +
+         (kWeights[SEMI_OPEN_FILE_ADJ_ENEMY_KING] *
+          semi_open_files_adj_enemy_king) +
+         (kWeights[SEMI_OPEN_FILE_SAME_ENEMY_KING] *
+          semi_open_files_same_enemy_king) +
+         (kWeights[OPEN_FILE] * open_files) +
+         (kWeights[OPEN_FILE_ADJ_ENEMY_KING] * open_files_adj_enemy_king) +
+         (kWeights[OPEN_FILE_SAME_ENEMY_KING] * open_files_same_enemy_king);
 }
 
-std::pair<int, int> EvalRank7(EvalState &state) {
-  int scores[2];
-
-  for (int i = 0; i < 2; i++) {
-    int rooks_on_7th = (kWeights[ROOK_ON_7th][i] * (Rank7<WHITE, ROOK>(state) -
-                                                    Rank7<BLACK, ROOK>(state)));
+Score EvalRank7(EvalState &state) {
+  int rooks_on_7th = Rank7<WHITE, ROOK>(state) - Rank7<BLACK, ROOK>(state);
+  int queens_on_7th = Rank7<WHITE, QUEEN>(state) - Rank7<BLACK, QUEEN>(state);
 
-    int queens_on_7th =
-        (kWeights[QUEEN_ON_7th][i] *
-         (Rank7<WHITE, QUEEN>(state) - Rank7<BLACK, QUEEN>(state)));
-
-    scores[i] = rooks_on_7th + queens_on_7th;
-  }
+  state.Trace(ROOK_ON_7th, rooks_on_7th);
+  state.Trace(QUEEN_ON_7th, queens_on_7th);
 
-  return std::make_pair(scores[0], scores[1]);
+  return (kWeights[ROOK_ON_7th] * rooks_on_7th) +
+         (kWeights[QUEEN_ON_7th] * queens_on_7th);
 }
 
-int EvalKingDistance(EvalState &state) {
-  return KingDistance<WHITE>(state) - KingDistance<BLACK>(state);
+Score EvalKingDistance(EvalState &state) {
+  int distance = KingDistance<WHITE>(state) - KingDistance<BLACK>(state);
+
+  return MakeScore(distance, distance);
 }
 
+// INFO: counts the files holding more than one pawn, every pawn with another
+// one behind it marks its file.
 template <enum Color side>
 int DoublePawns(Bitboard pawns) {
-  int count = 0;
-  constexpr auto file_fills = side == BLACK ? NorthFill : SouthFill;
-
-  while (pawns) {
-    int square = square::MIndex(pawns);
-    Bitboard bb = square::BB(square);
-    Bitboard targets = file_fills(bb) & pawns;
+  Bitboard doubled = pawns & NorthFill(MOVE_NORTH(pawns));
 
-    if (targets & pawns) {
-      count++;
-      bb |= targets;
-    }
-
-    pawns ^= bb;
-  }
-
-  return count;
+  return std::popcount(SouthFill(doubled) & kRank1);
 }
 
+// INFO: also counted by the batched evaluation
+template int DoublePawns<WHITE>(Bitboard pawns);
+template int DoublePawns<BLACK>(Bitboard pawns);
+
 template <enum Color side>
 std::pair<int, int> IsolatedPawns(Bitboard pawns, Bitboard empty_sqs) {
   int open = 0;
@@ -831,18 +813,18 @@ int KingDistance(EvalState &state) {
 
 // TODO: implement kings distance & unstoppable passed pawn scoring
 template <enum Color side>
-std::pair<float, float> PassedPawns(EvalState &state) {
+Score PassedPawns(EvalState &state) {
   int side_diff;
   Bitboard side_pawns;
   Bitboard enemy_pawns;
   Bitboard (*front_fill)(Bitboard);
 
-  float opening_score = 0;
-  float endgame_score = 0;
+  int opening_score = 0;
+  int endgame_score = 0;
   Bitboard empty_sqs = ~state.occupied_sqs;
   Bitboard all_pawns = state.white_pieces[PAWN] | state.black_pieces[PAWN];
 
-  static std::array<float, 8> PP_BONUS{0, 0, 0, 0.1, 0.3, 0.6, 1};
+  static constexpr std::array<int, 8> PP_BONUS{0, 0, 0, 10, 30, 60, 100};
 
   if constexpr (side == WHITE) {
     side_diff = 0;
@@ -873,7 +855,9 @@ std::pair<float, float> PassedPawns(EvalState &state) {
       continue;
     }
 
-    opening_score += 10 + 60 * PP_BONUS[std::abs(rank - side_diff)];
+    int bonus = PP_BONUS[std::abs(rank - side_diff)];
+
+    opening_score += 10 + 60 * bonus / BONUS_SCALE;
 
     // endgame evaluation
     int kings_distance = 0;
@@ -886,11 +870,11 @@ std::pair<float, float> PassedPawns(EvalState &state) {
                                !(push_target & state.attack_map[OPP(side)]));
 
     endgame_score +=
-        20 + (120 + kings_distance + free_score + unstoppable_score) *
-                 PP_BONUS[std::abs(rank - side_diff)];
+        20 + (120 + kings_distance + free_score + unstoppable_score) * bonus /
+                 BONUS_SCALE;
   }
 
-  return std::make_pair(opening_score, endgame_score);
+  return MakeScore(opening_score, endgame_score);
 }
 
 }  // namespace engine
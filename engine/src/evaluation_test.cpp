@@ -105,10 +105,10 @@ TEST_F(EvaluationTestSuite, PassedPawns) {
       &position, "5rk1/3bb1pp/2p1p3/4P3/1rpP4/1RN1p1P1/5PBP/3R2K1 w - - 0 1");
 
   EvalState state = EvalState::For(position);
-  auto [opening, endgame] = EvalPassedPawns(state);
+  Score score = EvalPassedPawns(state);
 
-  ASSERT_EQ(opening, -28);
-  ASSERT_EQ(endgame, -56);
+  ASSERT_EQ(OpeningValue(score), -28);
+  ASSERT_EQ(EndgameValue(score), -56);
 }
 
 TEST_F(EvaluationTestSuite, KingPosition) {
@@ -117,9 +117,9 @@ TEST_F(EvaluationTestSuite, KingPosition) {
       "1r3rk1/3bb1pp/2p1p3/1p2Pp1Q/2pP4/1P4P1/q3NPBP/2RR2K1 w - - 0 1");
 
   EvalState state = EvalState::For(position);
-  int score = EvalKingPosition(state);
+  Score score = EvalKingPosition(state);
 
-  ASSERT_EQ(score, -117);
+  ASSERT_EQ(OpeningValue(score), -117);
 
   Position::ApplyFen(
       &position, "5r1k/2pbb1rp/1p6/p2Pp2q/P1P4P/2P1N1P1/R1Q1RPBK/8 w - - 0 1");
@@ -127,7 +127,7 @@ TEST_F(EvaluationTestSuite, KingPosition) {
   state = EvalState::For(position);
   score = EvalKingPosition(state);
 
-  ASSERT_EQ(score, -296);
+  ASSERT_EQ(OpeningValue(score), -296);
 }
 
 TEST_F(EvaluationTestSuite, ScoreStartingPosition) {
@@ -139,7 +139,7 @@ TEST_F(EvaluationTestSuite, RandomPositionOne) {
       &position,
       "1r3rk1/3bb1pp/2p1p3/1p2Pp1Q/2pP4/1P4P1/q3NPBP/2RR2K1 w - - 0 1");
 
-  ASSERT_EQ(Evaluate(position), -242);
+  ASSERT_EQ(Evaluate(position), -220);
 }
 
 TEST_F(EvaluationTestSuite, RandomPositionTwo) {
@@ -147,5 +147,62 @@ TEST_F(EvaluationTestSuite, RandomPositionTwo) {
       &position,
       "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
 
-  ASSERT_EQ(Evaluate(position), 224);
+  ASSERT_EQ(Evaluate(position), 231);
+}
+
+TEST_F(EvaluationTestSuite, LazyEvaluation) {
+  const char *fens[] = {
+      kStartPos,
+      "1r3rk1/3bb1pp/2p1p3/1p2Pp1Q/2pP4/1P4P1/q3NPBP/2RR2K1 w - - 0 1",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"};
+
+  for (const char *fen : fens) {
+    Position::ApplyFen(&position, fen);
+
+    int score = Evaluate(position);
+
+    // an open or tight window around the score needs every stage
+    ASSERT_EQ(Evaluate(position, -100000, 100000), score);
+    ASSERT_EQ(Evaluate(position, score - 1, score + 1), score);
+  }
+
+  // a queen up, the material alone settles a window around equality
+  Position::ApplyFen(&position, "4k3/pppppppp/8/8/8/8/PPPPPPPP/3QK3 w - - 0 1");
+
+  ASSERT_GE(Evaluate(position, -50, 50), 50 + LAZY_EVAL_MATERIAL_MARGIN);
+  ASSERT_LE(Evaluate(position, 2000, 2100), 2000 - LAZY_EVAL_MATERIAL_MARGIN);
+}
+
+TEST_F(EvaluationTestSuite, IncrementalMaterialsMatchFen) {
+  // castles, en passant, promotions & captures between them
+  const char *fens[] = {
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 b kq - 0 1",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"};
+
+  for (const char *fen : fens) {
+    Position::ApplyFen(&position, fen);
+
+    EvalState before = EvalState::For(position);
+
+    for (Move &move : position.LegalMoves()) {
+      position.Make(move);
+
+      Position copy = Position::FromFen(position.ToFen());
+      EvalState incremental = EvalState::For(position);
+      EvalState scratch = EvalState::For(copy);
+
+      ASSERT_EQ(incremental.psq, scratch.psq);
+      ASSERT_EQ(incremental.phase, scratch.phase);
+
+      position.Undo(move);
+
+      EvalState after = EvalState::For(position);
+
+      ASSERT_EQ(after.psq, before.psq);
+      ASSERT_EQ(after.phase, before.phase);
+    }
+  }
 }
@@ -1,9 +1,7 @@
-#include <cstdint>
 #include <format>
 #include <string>
 
 #include "engine/board.hpp"
-#include "engine/hash.hpp"
 #include "engine/position.hpp"
 #include "engine/square.hpp"
 #include "engine/types.hpp"
@@ -19,12 +17,10 @@ Position Position::FromFen(const std::string_view &fen) {
 }
 
 void Position::ApplyFen(Position *position, const std::string_view &fen) {
-  position->Reset();
+  position::Placement placement;
 
-  Board &board = position->board_;
-
-  PieceList &black_pieces = board.pieces[BLACK];
-  PieceList &white_pieces = board.pieces[WHITE];
+  PieceList &black_pieces = placement.pieces[BLACK];
+  PieceList &white_pieces = placement.pieces[WHITE];
 
   int rank = 7;
   int file = 0;
@@ -35,90 +31,77 @@ void Position::ApplyFen(Position *position, const std::string_view &fen) {
 
   for (const char c : fen) {
     Piece piece = NONE;
-    Color color = WHITE;
     Bitboard *bb = nullptr;
 
     switch (c) {
       case 'r':
         piece = ROOK;
-        color = BLACK;
         bb = &black_pieces[piece];
         break;
 
       case 'n':
-        color = BLACK;
         piece = KNIGHT;
         bb = &black_pieces[piece];
         break;
 
       case 'b':
-        color = BLACK;
         piece = BISHOP;
         bb = &black_pieces[piece];
-        position->turn_ = BLACK;
         en_passant_file = c;
+        if (spaces == 1) placement.turn = BLACK;
         break;
 
       case 'q':
-        color = BLACK;
         piece = QUEEN;
         bb = &black_pieces[piece];
         if (spaces == 2)
-          position->castling_rights_ |= position::CASTLE_B_QUEEN_SIDE;
+          placement.castling_rights |= position::CASTLE_B_QUEEN_SIDE;
         break;
 
       case 'k':
         piece = KING;
-        color = BLACK;
         bb = &black_pieces[piece];
         if (spaces == 2)
-          position->castling_rights_ |= position::CASTLE_B_KING_SIDE;
+          placement.castling_rights |= position::CASTLE_B_KING_SIDE;
         break;
 
       case 'p':
         piece = PAWN;
-        color = BLACK;
         bb = &black_pieces[piece];
         break;
 
       case 'R':
         piece = ROOK;
-        color = WHITE;
         bb = &white_pieces[piece];
         break;
 
       case 'N':
-        color = WHITE;
         piece = KNIGHT;
         bb = &white_pieces[piece];
         break;
 
       case 'B':
-        color = WHITE;
         piece = BISHOP;
         bb = &white_pieces[piece];
         break;
 
       case 'Q':
-        color = WHITE;
         piece = QUEEN;
         bb = &white_pieces[piece];
         if (spaces == 2)
-          position->castling_rights_ |= position::CASTLE_W_QUEEN_SIDE;
+          placement.castling_rights |= position::CASTLE_W_QUEEN_SIDE;
         break;
 
       case 'K':
         piece = KING;
-        color = WHITE;
         bb = &white_pieces[piece];
 
         if (spaces == 2)
-          position->castling_rights_ |= position::CASTLE_W_KING_SIDE;
+          placement.castling_rights |= position::CASTLE_W_KING_SIDE;
         break;
 
       case 'P':
         piece = PAWN;
-        color = WHITE;
         bb = &white_pieces[piece];
         break;
 
@@ -157,7 +140,7 @@ void Position::ApplyFen(Position *position, const std::string_view &fen) {
         break;
 
       case 'w':
-        position->turn_ = WHITE;
+        placement.turn = WHITE;
         break;
 
       case ' ':
@@ -173,37 +156,21 @@ void Position::ApplyFen(Position *position, const std::string_view &fen) {
       *bb |= square::BB(square);
 
       file++;
-      position->hash_ ^= HASH1(square, color, piece);
     } else if (spaces == 3 && (en_passant_rank == 3 || en_passant_rank == 6) &&
                en_passant_file >= 'a' && en_passant_file <= 'h') {
       int rank = en_passant_rank - 1;
       int file = en_passant_file - 97;
       int square = square::From(file, rank);
 
-      position->en_passant_sq_ = square::BB(square);
-      position->hash_ ^= kZobrist.en_passant_file[file];
+      placement.en_passant_sq = square::BB(square);
     } else if (spaces == 4) {
-      position->halfmove_clock_ = move_count;
+      placement.halfmove_clock = move_count;
     } else if (spaces == 5) {
-      position->fullmove_counter_ = move_count;
+      placement.fullmove_counter = move_count;
     }
   }
 
-  if (position->turn_ == BLACK) {
-    position->hash_ ^= kZobrist.color;
-  }
-
-  std::uint8_t copy = position->castling_rights_;
-  int index = square::Index(copy);
-
-  while (copy) {
-    position->hash_ ^= kZobrist.castling_rights[index];
-
-    copy ^= 1 << index;
-    index = square::Index(copy);
-  }
-
-  position->UpdateInternals();
+  position->Load(placement);
 }
 
 std::string Position::ToFen() const {
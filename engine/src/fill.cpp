@@ -1,9 +1,18 @@
+#include <atomic>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FILL_X86_SIMD
+#endif
+
 #include "engine/constants.hpp"
 #include "engine/fill.hpp"
 #include "engine/types.hpp"
 
 namespace engine {
 
+using SliderAttacksFn = Bitboard (*)(Bitboard, Bitboard, Bitboard);
+
 Bitboard SouthOccluded(Bitboard bb, Bitboard pro) {
   bb |= pro & (bb >> 8);
   pro &= (pro >> 8);
@@ -106,4 +115,87 @@ Bitboard SouthFill(Bitboard bb) {
   return bb;
 }
 
+static Bitboard ScalarSliderAttacks(Bitboard rooks, Bitboard bishops,
+                                    Bitboard empty) {
+  return (ROOK_ATTACKS(rooks, empty)) | (BISHOP_ATTACKS(bishops, empty));
+}
+
+#ifdef FILL_X86_SIMD
+// INFO: the lanes hold north, east, north east & north west for the left
+// shifts and their opposites for the right shifts, so one Kogge-Stone pass
+// covers all eight directions.
+__attribute__((target("avx2"))) static Bitboard Avx2SliderAttacks(
+    Bitboard rooks, Bitboard bishops, Bitboard empty) {
+  const __m256i shift = _mm256_setr_epi64x(8, 1, 9, 7);
+  const __m256i left_wrap =
+      _mm256_setr_epi64x(kUniverse, ~kAFile, ~kAFile, ~kHFile);
+  const __m256i right_wrap =
+      _mm256_setr_epi64x(kUniverse, ~kHFile, ~kHFile, ~kAFile);
+
+  __m256i gen = _mm256_setr_epi64x(rooks, rooks, bishops, bishops);
+  __m256i pro = _mm256_set1_epi64x(empty);
+
+  __m256i left = gen;
+  __m256i right = gen;
+  __m256i left_pro = _mm256_and_si256(pro, left_wrap);
+  __m256i right_pro = _mm256_and_si256(pro, right_wrap);
+  __m256i step = shift;
+
+  for (int i = 0; i < 3; i++) {
+    left = _mm256_or_si256(
+        left, _mm256_and_si256(left_pro, _mm256_sllv_epi64(left, step)));
+    right = _mm256_or_si256(
+        right, _mm256_and_si256(right_pro, _mm256_srlv_epi64(right, step)));
+
+    left_pro = _mm256_and_si256(left_pro, _mm256_sllv_epi64(left_pro, step));
+    right_pro =
+        _mm256_and_si256(right_pro, _mm256_srlv_epi64(right_pro, step));
+
+    step = _mm256_add_epi64(step, step);
+  }
+
+  // one more step past the fill onto the blockers
+  left = _mm256_and_si256(_mm256_sllv_epi64(left, shift), left_wrap);
+  right = _mm256_and_si256(_mm256_srlv_epi64(right, shift), right_wrap);
+
+  __m256i attacks = _mm256_or_si256(left, right);
+  __m128i half = _mm_or_si128(_mm256_castsi256_si128(attacks),
+                              _mm256_extracti128_si256(attacks, 1));
+
+  half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+
+  return _mm_cvtsi128_si64(half);
+}
+#endif
+
+static Bitboard ResolveSliderAttacks(Bitboard rooks, Bitboard bishops,
+                                     Bitboard empty);
+
+// INFO: starts at the resolver so it's usable during static initialization,
+// the first call swaps in the implementation for this cpu.
+static std::atomic<SliderAttacksFn> slider_attacks = ResolveSliderAttacks;
+
+static Bitboard ResolveSliderAttacks(Bitboard rooks, Bitboard bishops,
+                                     Bitboard empty) {
+  SliderAttacksFn fn = ScalarSliderAttacks;
+
+#ifdef FILL_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    fn = Avx2SliderAttacks;
+  }
+#endif
+
+  slider_attacks.store(fn, std::memory_order_relaxed);
+
+  return fn(rooks, bishops, empty);
+}
+
+Bitboard SliderAttacks(Bitboard rooks, Bitboard bishops, Bitboard empty) {
+#ifdef __AVX2__
+  return Avx2SliderAttacks(rooks, bishops, empty);
+#else
+  return slider_attacks.load(std::memory_order_relaxed)(rooks, bishops, empty);
+#endif
+}
+
 }  // namespace engine
@@ -0,0 +1,32 @@
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "engine/constants.hpp"
+#include "engine/fill.hpp"
+#include "engine/move_gen.hpp"
+#include "engine/square.hpp"
+#include "engine/types.hpp"
+
+using namespace engine;
+
+TEST(FillTestSuite, SliderAttacks) {
+  std::mt19937_64 random(7);
+
+  for (int i = 0; i < 10000; i++) {
+    Bitboard occupied_sqs = random() & random();
+    Bitboard rooks = occupied_sqs & random() & random();
+    Bitboard bishops = occupied_sqs & random() & random();
+    Bitboard expected = kEmpty;
+
+    BITLOOP(rooks) {
+      expected |= kSlidingAttacks.Rook(occupied_sqs, LOOP_INDEX);
+    }
+
+    BITLOOP(bishops) {
+      expected |= kSlidingAttacks.Bishop(occupied_sqs, LOOP_INDEX);
+    }
+
+    ASSERT_EQ(SliderAttacks(rooks, bishops, ~occupied_sqs), expected);
+  }
+}
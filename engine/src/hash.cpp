@@ -5,10 +5,17 @@
 
 namespace engine {
 
+// INFO: splitmix64, the low bits of a plain LCG repeat with a short period
+// and the keys get used to index the transposition tables.
 consteval std::uint64_t Rand(std::uint64_t &N) {
-  N = N * 1103515245 + 12345;
+  N += 0x9e3779b97f4a7c15;
 
-  return N;
+  std::uint64_t z = N;
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+
+  return z ^ (z >> 31);
 }
 
 consteval Zobrist InitZobrist() {
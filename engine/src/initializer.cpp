@@ -1,3 +1,4 @@
+#include "engine/attacks.hpp"
 #include "engine/constants.hpp"
 #include "engine/move_gen.hpp"
 #include "engine/square.hpp"
@@ -5,7 +6,7 @@
 
 namespace engine {
 
-const magic_bits::Attacks kSlidingAttacks;
+const SlidingAttacks kSlidingAttacks;
 
 consteval AttackMaps InitAttackMaps() {
   AttackMaps m{};
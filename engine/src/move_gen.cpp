@@ -1,10 +1,7 @@
 #include <cstdarg>
 #include <cstddef>
-#include <tuple>
 #include <utility>
 
-#include <magic_bits.hpp>
-
 #include "engine/board.hpp"
 #include "engine/constants.hpp"
 #include "engine/move.hpp"
@@ -21,18 +18,21 @@ inline bool PieceAt(Piece *piece, const Mailbox &mailbox, int square) {
   return *piece != NONE;
 }
 
+template <enum Color side>
 MoveList GenerateMoves(const Position &position) {
   MoveList move_list;
 
   move_list.reserve(218);
 
-  Color opp = OPP(position.turn_);
+  constexpr Color opp = OPP(side);
   Bitboard occupied_sqs = position.board_.occupied_sqs;
   const PieceList &enemy_pieces = position.Pieces(opp);
-  const PieceList &own_pieces = position.Pieces(position.turn_);
+  const PieceList &own_pieces = position.Pieces(side);
 
-  Bitboard check_mask = CheckMask(position);
-  auto [pin_hv_mask, pin_diag_mask] = PinMask(position);
+  const position::AttackInfo &info = position.Masks<side>();
+  Bitboard check_mask = info.check_mask;
+  Bitboard pin_hv_mask = info.pin_hv_mask;
+  Bitboard pin_diag_mask = info.pin_diag_mask;
   Bitboard pin_mask = pin_hv_mask | pin_diag_mask;
 
   Bitboard empty_sqs = ~occupied_sqs;
@@ -45,7 +45,7 @@ MoveList GenerateMoves(const Position &position) {
   // 1. safe king squares
   int king_sq = square::Index(own_pieces[KING]);
   Bitboard legal_king_moves =
-      kAttackMaps[KING][king_sq] & enemy_or_empty_sqs & ~position.king_ban_;
+      kAttackMaps[KING][king_sq] & enemy_or_empty_sqs & ~info.king_ban;
 
   Bitboard quiet_moves = legal_king_moves & empty_sqs;
   Bitboard captures = legal_king_moves & enemy_pieces_bb;
@@ -74,16 +74,11 @@ MoveList GenerateMoves(const Position &position) {
   Bitboard pushable_pawns = side_pawns & ~pin_diag_mask;
   Bitboard attackable_pawns = side_pawns & ~pin_hv_mask;
 
-  auto [single_push_targets, double_push_targets, pawn_east_targets,
-        pawn_west_targets, file_shift, east_shift, west_shift,
-        before_promotion_rank] =
-      position.turn_ == WHITE
-          ? std::make_tuple(PushPawn<WHITE>, DoublePushPawn<WHITE>,
-                            PawnTargets<WHITE, EAST>, PawnTargets<WHITE, WEST>,
-                            -8, -9, -7, kRank7)
-          : std::make_tuple(PushPawn<BLACK>, DoublePushPawn<BLACK>,
-                            PawnTargets<BLACK, EAST>, PawnTargets<BLACK, WEST>,
-                            8, 7, 9, kRank2);
+  // INFO: offsets from a pawn target back to the pawn
+  constexpr int file_shift = side == WHITE ? -8 : 8;
+  constexpr int east_shift = side == WHITE ? -9 : 7;
+  constexpr int west_shift = side == WHITE ? -7 : 9;
+  constexpr Bitboard before_promotion_rank = side == WHITE ? kRank7 : kRank2;
 
   // 2.1. pawn pushes
   {
@@ -94,9 +89,9 @@ MoveList GenerateMoves(const Position &position) {
         pushable_pawns & ~pin_hv_mask & ~before_promotion_rank;
 
     Bitboard free_pawns_pts =
-        single_push_targets(free_pawns) & movable_sqs_mask;
+        PushPawn<side>(free_pawns) & movable_sqs_mask;
     Bitboard pinned_pawns_pts =
-        single_push_targets(pinned_pawns) & movable_sqs_mask & pin_hv_mask;
+        PushPawn<side>(pinned_pawns) & movable_sqs_mask & pin_hv_mask;
 
     Bitboard single_targets = free_pawns_pts | pinned_pawns_pts;
 
@@ -110,9 +105,10 @@ MoveList GenerateMoves(const Position &position) {
     int dbl_file_shift = file_shift * 2;
 
     Bitboard free_pawns_dts =
-        double_push_targets(free_pawns, empty_sqs) & check_mask;
+        DoublePushPawn<side>(free_pawns, empty_sqs) & check_mask;
     Bitboard pinned_pawns_dts =
-        double_push_targets(pinned_pawns, empty_sqs) & check_mask & pin_hv_mask;
+        DoublePushPawn<side>(pinned_pawns, empty_sqs) & check_mask &
+        pin_hv_mask;
 
     Bitboard double_targets = free_pawns_dts | pinned_pawns_dts;
 
@@ -129,11 +125,13 @@ MoveList GenerateMoves(const Position &position) {
     Bitboard pinned_pawns = attackable_pawns & pin_diag_mask & non_promotable;
     Bitboard free_pawns = attackable_pawns & ~pin_diag_mask & non_promotable;
 
-    Bitboard free_pawns_wts = pawn_west_targets(free_pawns);
-    Bitboard pinned_pawns_wts = pawn_west_targets(pinned_pawns) & pin_diag_mask;
+    Bitboard free_pawns_wts = PawnTargets<side, WEST>(free_pawns);
+    Bitboard pinned_pawns_wts =
+        PawnTargets<side, WEST>(pinned_pawns) & pin_diag_mask;
 
-    Bitboard free_pawns_ets = pawn_east_targets(free_pawns);
-    Bitboard pinned_pawns_ets = pawn_east_targets(pinned_pawns) & pin_diag_mask;
+    Bitboard free_pawns_ets = PawnTargets<side, EAST>(free_pawns);
+    Bitboard pinned_pawns_ets =
+        PawnTargets<side, EAST>(pinned_pawns) & pin_diag_mask;
 
     // 2.2. pawn captures
     {
@@ -303,13 +301,15 @@ MoveList GenerateMoves(const Position &position) {
 
   // 5. castling
   {
-    auto [queen_rook, king_rook, queen_side_castling_flag,
-          king_side_castling_flag, starting_rank] =
-        position.turn_ == WHITE
-            ? std::make_tuple(a1, h1, position::CASTLE_W_QUEEN_SIDE,
-                              position::CASTLE_W_KING_SIDE, kRank1)
-            : std::make_tuple(a8, h8, position::CASTLE_B_QUEEN_SIDE,
-                              position::CASTLE_B_KING_SIDE, kRank8);
+    constexpr ESquare queen_rook = side == WHITE ? a1 : a8;
+    constexpr ESquare king_rook = side == WHITE ? h1 : h8;
+    constexpr Castling queen_side_castling_flag =
+        side == WHITE ? position::CASTLE_W_QUEEN_SIDE
+                      : position::CASTLE_B_QUEEN_SIDE;
+    constexpr Castling king_side_castling_flag =
+        side == WHITE ? position::CASTLE_W_KING_SIDE
+                      : position::CASTLE_B_KING_SIDE;
+    constexpr Bitboard starting_rank = side == WHITE ? kRank1 : kRank8;
 
     Bitboard rooks = own_pieces[ROOK];
     Bitboard king = own_pieces[KING] & starting_rank;
@@ -324,7 +324,7 @@ MoveList GenerateMoves(const Position &position) {
 
     if (check_mask == kUniverse &&
         position.CanCastle(king_side_castling_flag) && king_side_rook &&
-        right_occupied == kEmpty && !(king_side_path & position.king_ban_)) {
+        right_occupied == kEmpty && !(king_side_path & info.king_ban)) {
       Move move(square::Index(king), square::Index(king << 2), KING);
 
       move.Set(move::CASTLE_KING_SIDE);
@@ -334,7 +334,7 @@ MoveList GenerateMoves(const Position &position) {
 
     if (check_mask == kUniverse &&
         position.CanCastle(queen_side_castling_flag) && queen_side_rook &&
-        left_occupied == kEmpty && !(queen_side_path & position.king_ban_)) {
+        left_occupied == kEmpty && !(queen_side_path & info.king_ban)) {
       Move move(square::Index(king), square::Index(king >> 2), KING);
 
       move.Set(move::CASTLE_QUEEN_SIDE);
@@ -351,9 +351,9 @@ MoveList GenerateMoves(const Position &position) {
     Bitboard free_pawns = pushable_pawns & ~pin_hv_mask & before_promotion_rank;
 
     Bitboard free_pawns_pts =
-        single_push_targets(free_pawns) & movable_sqs_mask;
+        PushPawn<side>(free_pawns) & movable_sqs_mask;
     Bitboard pinned_pawns_pts =
-        single_push_targets(pinned_pawns) & movable_sqs_mask & pin_hv_mask;
+        PushPawn<side>(pinned_pawns) & movable_sqs_mask & pin_hv_mask;
 
     Bitboard single_targets = free_pawns_pts | pinned_pawns_pts;
 
@@ -378,9 +378,10 @@ MoveList GenerateMoves(const Position &position) {
       Bitboard free_pawns =
           attackable_pawns & ~pin_diag_mask & before_promotion_rank;
 
-      Bitboard free_pawns_wts = pawn_west_targets(free_pawns) & capture_mask;
+      Bitboard free_pawns_wts =
+          PawnTargets<side, WEST>(free_pawns) & capture_mask;
       Bitboard pinned_pawns_wts =
-          pawn_west_targets(pinned_pawns) & capture_mask & pin_diag_mask;
+          PawnTargets<side, WEST>(pinned_pawns) & capture_mask & pin_diag_mask;
       Bitboard west_targets = free_pawns_wts | pinned_pawns_wts;
 
       BITLOOP(west_targets) {
@@ -403,9 +404,10 @@ MoveList GenerateMoves(const Position &position) {
         }
       }
 
-      Bitboard free_pawns_ets = pawn_east_targets(free_pawns) & capture_mask;
+      Bitboard free_pawns_ets =
+          PawnTargets<side, EAST>(free_pawns) & capture_mask;
       Bitboard pinned_pawns_ets =
-          pawn_east_targets(pinned_pawns) & capture_mask & pin_diag_mask;
+          PawnTargets<side, EAST>(pinned_pawns) & capture_mask & pin_diag_mask;
       Bitboard east_targets = free_pawns_ets | pinned_pawns_ets;
 
       BITLOOP(east_targets) {
@@ -433,6 +435,11 @@ MoveList GenerateMoves(const Position &position) {
   return move_list;
 }
 
+MoveList GenerateMoves(const Position &position) {
+  return position.turn_ == WHITE ? GenerateMoves<WHITE>(position)
+                                 : GenerateMoves<BLACK>(position);
+}
+
 void AddMovesToList(MoveList &move_list, int from, Bitboard targets,
                     Piece piece, const Mailbox &mailbox, Bitboard enemy_bb) {
   BITLOOP(targets) {
@@ -449,78 +456,59 @@ void AddMovesToList(MoveList &move_list, int from, Bitboard targets,
   }
 }
 
-Bitboard CheckMask(const Position &position) {
-  Bitboard mask = kUniverse;
-  Color opp = OPP(position.turn_);
+template <enum Color side>
+Bitboard Checkers(const Position &position) {
+  constexpr Color opp = OPP(side);
   Bitboard occupied_sqs = position.board_.occupied_sqs;
   const PieceList &opp_pieces = position.Pieces(opp);
-  const PieceList &own_pieces = position.Pieces(position.turn_);
-  Bitboard king_bb = own_pieces[KING];
-
-  auto [pawn_east_targets, pawn_west_targets, inverse_east_targets,
-        inverse_west_targets] =
-      position.turn_ == BLACK
-          ? std::make_tuple(PawnTargets<WHITE, EAST>, PawnTargets<WHITE, WEST>,
-                            PawnTargets<BLACK, WEST>, PawnTargets<BLACK, EAST>)
-          : std::make_tuple(PawnTargets<BLACK, EAST>, PawnTargets<BLACK, WEST>,
-                            PawnTargets<WHITE, WEST>, PawnTargets<WHITE, EAST>);
-
-  if (pawn_east_targets(opp_pieces[PAWN]) & king_bb) {
-    mask = inverse_east_targets(king_bb);
-  } else if (pawn_west_targets(opp_pieces[PAWN]) & king_bb) {
-    mask = inverse_west_targets(king_bb);
-  }
-
+  Bitboard king_bb = position.Pieces(side)[KING];
   int king_square = square::Index(king_bb);
 
-  Bitboard knight = kAttackMaps[KNIGHT][king_square] & opp_pieces[KNIGHT];
+  Bitboard checkers = PawnTargets<side>(king_bb) & opp_pieces[PAWN];
 
-  if (knight) {
-    mask = knight;
-  }
+  checkers |= kAttackMaps[KNIGHT][king_square] & opp_pieces[KNIGHT];
 
   Bitboard enemy_bishop_queen = opp_pieces[BISHOP] | opp_pieces[QUEEN];
 
   if (kAttackMaps[BISHOP][king_square] & enemy_bishop_queen) {
-    Bitboard pieces =
+    checkers |=
         kSlidingAttacks.Bishop(occupied_sqs, king_square) & enemy_bishop_queen;
-
-    BITLOOP(pieces) {
-      int bishop = LOOP_INDEX;
-      Bitboard rays_from_attacker = kCheckBetween[BISHOP][king_square][bishop];
-
-      if (mask != kUniverse) {
-        return kEmpty;
-      }
-
-      mask = rays_from_attacker | square::BB(bishop);
-    }
   }
 
   Bitboard enemy_rook_queen = opp_pieces[ROOK] | opp_pieces[QUEEN];
 
   if (kAttackMaps[ROOK][king_square] & enemy_rook_queen) {
-    Bitboard pieces =
+    checkers |=
         kSlidingAttacks.Rook(occupied_sqs, king_square) & enemy_rook_queen;
+  }
 
-    BITLOOP(pieces) {
-      int rook = LOOP_INDEX;
-      Bitboard rays_from_attacker = kCheckBetween[ROOK][king_square][rook];
+  return checkers;
+}
 
-      if (mask != kUniverse) {
-        return kEmpty;
-      }
+Bitboard CheckMask(Bitboard checkers, int king_square) {
+  if (checkers == kEmpty) {
+    return kUniverse;
+  }
 
-      mask = rays_from_attacker | square::BB(rook);
-    }
+  // only the king can get out of a double check
+  if (checkers & (checkers - 1)) {
+    return kEmpty;
   }
 
-  return mask;
+  // INFO: empty for pawns & knights, the checker can only be captured
+  return checkers | kCheckBetween[ROOK][king_square][square::Index(checkers)];
+}
+
+template <enum Color side>
+Bitboard CheckMask(const Position &position) {
+  return CheckMask(Checkers<side>(position),
+                   square::Index(position.Pieces(side)[KING]));
 }
 
+template <enum Color side>
 std::pair<Bitboard, Bitboard> PinMask(const Position &position) {
-  Color opp = OPP(position.turn_);
-  const PieceList &own_pieces = position.Pieces(position.turn_);
+  constexpr Color opp = OPP(side);
+  const PieceList &own_pieces = position.Pieces(side);
   const PieceList &opp_pieces = position.Pieces(opp);
   Bitboard occupied_sqs = position.board_.occupied_sqs;
   Bitboard king_bb = own_pieces[KING];
@@ -569,4 +557,23 @@ std::pair<Bitboard, Bitboard> PinMask(const Position &position) {
   return {hv_mask, diag_mask};
 }
 
+Bitboard CheckMask(const Position &position) {
+  return position.turn_ == WHITE ? CheckMask<WHITE>(position)
+                                 : CheckMask<BLACK>(position);
+}
+
+std::pair<Bitboard, Bitboard> PinMask(const Position &position) {
+  return position.turn_ == WHITE ? PinMask<WHITE>(position)
+                                 : PinMask<BLACK>(position);
+}
+
+template MoveList GenerateMoves<WHITE>(const Position &position);
+template MoveList GenerateMoves<BLACK>(const Position &position);
+template Bitboard Checkers<WHITE>(const Position &position);
+template Bitboard Checkers<BLACK>(const Position &position);
+template Bitboard CheckMask<WHITE>(const Position &position);
+template Bitboard CheckMask<BLACK>(const Position &position);
+template std::pair<Bitboard, Bitboard> PinMask<WHITE>(const Position &position);
+template std::pair<Bitboard, Bitboard> PinMask<BLACK>(const Position &position);
+
 }  // namespace engine
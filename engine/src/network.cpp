@@ -0,0 +1,541 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NETWORK_X86_SIMD
+#endif
+
+#include "engine/board.hpp"
+#include "engine/constants.hpp"
+#include "engine/move_gen.hpp"
+#include "engine/network.hpp"
+#include "engine/position.hpp"
+#include "engine/square.hpp"
+#include "engine/types.hpp"
+
+namespace engine {
+
+// INFO: every dot product is over a multiple of 16 int16 values
+using DotFn = std::int32_t (*)(const std::int16_t *, const std::int16_t *,
+                               int);
+
+static std::int32_t ScalarDot(const std::int16_t *a, const std::int16_t *b,
+                              int size) {
+  std::int32_t sum = 0;
+
+  for (int i = 0; i < size; i++) {
+    sum += a[i] * b[i];
+  }
+
+  return sum;
+}
+
+#ifdef NETWORK_X86_SIMD
+__attribute__((target("avx2"))) static std::int32_t Avx2Dot(
+    const std::int16_t *a, const std::int16_t *b, int size) {
+  __m256i sum = _mm256_setzero_si256();
+
+  for (int i = 0; i < size; i += 16) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(x, y));
+  }
+
+  __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                               _mm256_extracti128_si256(sum, 1));
+
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+
+  return _mm_cvtsi128_si32(half);
+}
+#endif
+
+static std::int32_t ResolveDot(const std::int16_t *a, const std::int16_t *b,
+                               int size);
+
+// INFO: same lazy dispatch as SliderAttacks, resolved on first use
+static std::atomic<DotFn> dot_fn = ResolveDot;
+
+static std::int32_t ResolveDot(const std::int16_t *a, const std::int16_t *b,
+                               int size) {
+  DotFn fn = ScalarDot;
+
+#ifdef NETWORK_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    fn = Avx2Dot;
+  }
+#endif
+
+  dot_fn.store(fn, std::memory_order_relaxed);
+
+  return fn(a, b, size);
+}
+
+// black sees the board flipped, as if its pieces were white
+static inline int Relative(Color perspective, int square) {
+  return perspective == WHITE ? square : square ^ 56;
+}
+
+// INFO: the file is mapped as is, its fields are little-endian
+static_assert(std::endian::native == std::endian::little);
+
+static constexpr int kSizes[NETWORK_LAYERS + 1] = {
+    NETWORK_INPUTS, NETWORK_L1, NETWORK_L2, NETWORK_L3, 1};
+
+static std::uint32_t Align(std::size_t offset) {
+  return (offset + NETWORK_ALIGNMENT - 1) & ~(NETWORK_ALIGNMENT - 1);
+}
+
+// INFO: clamps before rounding, weights too large for the format saturate
+// instead of wrapping around
+template <typename T>
+static T Saturate(double value) {
+  return static_cast<T>(std::lround(
+      std::clamp<double>(value, std::numeric_limits<T>::min(),
+                         std::numeric_limits<T>::max())));
+}
+
+std::uint32_t Crc32(const std::byte *data, std::size_t size) {
+  static const auto kTable = [] {
+    std::array<std::uint32_t, 256> table;
+
+    for (std::uint32_t i = 0; i < 256; i++) {
+      std::uint32_t crc = i;
+
+      for (int bit = 0; bit < 8; bit++) {
+        crc = crc & 1 ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+      }
+
+      table[i] = crc;
+    }
+
+    return table;
+  }();
+
+  std::uint32_t crc = 0xffffffff;
+
+  for (std::size_t i = 0; i < size; i++) {
+    crc = kTable[(crc ^ std::to_integer<std::uint32_t>(data[i])) & 0xff] ^
+          (crc >> 8);
+  }
+
+  return crc ^ 0xffffffff;
+}
+
+std::vector<std::byte> Network::Quantize(const float *params) {
+  NetworkHeader header = {};
+  std::uint32_t offset = NETWORK_HEADER_SIZE;
+
+  // INFO: the first layer is an int16 accumulator, the others widen int8
+  // weights & keep int32 biases
+  for (int l = 0; l < NETWORK_LAYERS; l++) {
+    NetworkLayerHeader &layer = header.layer[l];
+
+    layer.inputs = kSizes[l];
+    layer.outputs = kSizes[l + 1];
+    layer.weights = offset;
+    layer.biases = Align(offset + layer.inputs * layer.outputs * 2);
+
+    offset = Align(layer.biases + layer.outputs * (l == 0 ? 2 : 4));
+  }
+
+  header.magic = NETWORK_MAGIC;
+  header.version = NETWORK_VERSION;
+  header.layers = NETWORK_LAYERS;
+  header.size = offset;
+
+  std::vector<std::byte> image(header.size);
+  const float *kernel = params;
+
+  for (int l = 0; l < NETWORK_LAYERS; l++) {
+    NetworkLayerHeader &layer = header.layer[l];
+    const float *bias = kernel + layer.inputs * layer.outputs;
+    auto *weights =
+        reinterpret_cast<std::int16_t *>(image.data() + layer.weights);
+    float max = 0;
+
+    for (std::uint32_t i = 0; i < layer.inputs * layer.outputs; i++) {
+      max = std::max(max, std::abs(kernel[i]));
+    }
+
+    // INFO: the largest weight decides the scale, it has to fit in an int8
+    if (l == 0) {
+      layer.scale = NETWORK_SCALE;
+    } else {
+      layer.scale = max > 0 ? std::max(1, static_cast<int>(127 / max)) : 1;
+    }
+
+    for (std::uint32_t j = 0; j < layer.outputs; j++) {
+      for (std::uint32_t i = 0; i < layer.inputs; i++) {
+        // one column per input for the accumulator, one row per output after
+        std::uint32_t index = l == 0 ? i * layer.outputs + j
+                                     : j * layer.inputs + i;
+
+        weights[index] = Saturate<std::int16_t>(
+            static_cast<double>(kernel[i * layer.outputs + j]) * layer.scale);
+      }
+
+      int scale = layer.scale * (l == 0 ? 1 : NETWORK_SCALE);
+      double value = static_cast<double>(bias[j]) * scale;
+
+      if (l == 0) {
+        reinterpret_cast<std::int16_t *>(image.data() + layer.biases)[j] =
+            Saturate<std::int16_t>(value);
+      } else {
+        reinterpret_cast<std::int32_t *>(image.data() + layer.biases)[j] =
+            Saturate<std::int32_t>(value);
+      }
+    }
+
+    kernel = bias + layer.outputs;
+  }
+
+  header.checksum = Crc32(image.data() + NETWORK_HEADER_SIZE,
+                          header.size - NETWORK_HEADER_SIZE);
+
+  std::memcpy(image.data(), &header, sizeof(header));
+
+  return image;
+}
+
+// Checks every field against the model the engine was built for, so that
+// inference never has to.
+bool Network::Bind(const std::byte *data, std::size_t size) {
+  NetworkHeader header;
+
+  if (size < NETWORK_HEADER_SIZE) {
+    return false;
+  }
+
+  std::memcpy(&header, data, sizeof(header));
+
+  if (header.magic != NETWORK_MAGIC || header.version != NETWORK_VERSION ||
+      header.layers != NETWORK_LAYERS || header.size != size ||
+      header.layer[0].scale != NETWORK_SCALE) {
+    return false;
+  }
+
+  for (int l = 0; l < NETWORK_LAYERS; l++) {
+    const NetworkLayerHeader &layer = header.layer[l];
+    std::size_t weights = std::size_t{layer.inputs} * layer.outputs * 2;
+    std::size_t biases = std::size_t{layer.outputs} * (l == 0 ? 2 : 4);
+
+    if (layer.inputs != static_cast<std::uint32_t>(kSizes[l]) ||
+        layer.outputs != static_cast<std::uint32_t>(kSizes[l + 1]) ||
+        layer.scale == 0 || layer.weights % NETWORK_ALIGNMENT != 0 ||
+        layer.biases % NETWORK_ALIGNMENT != 0 ||
+        layer.weights < NETWORK_HEADER_SIZE ||
+        layer.biases < NETWORK_HEADER_SIZE ||
+        layer.weights + weights > size || layer.biases + biases > size) {
+      return false;
+    }
+  }
+
+  if (Crc32(data + NETWORK_HEADER_SIZE, size - NETWORK_HEADER_SIZE) !=
+      header.checksum) {
+    return false;
+  }
+
+  input_weights_ =
+      reinterpret_cast<const std::int16_t *>(data + header.layer[0].weights);
+  input_biases_ =
+      reinterpret_cast<const std::int16_t *>(data + header.layer[0].biases);
+
+  for (int l = 1; l < NETWORK_LAYERS; l++) {
+    const NetworkLayerHeader &layer = header.layer[l];
+
+    hidden_[l - 1] = {
+        static_cast<int>(layer.inputs), static_cast<int>(layer.outputs),
+        static_cast<int>(layer.scale),
+        reinterpret_cast<const std::int16_t *>(data + layer.weights),
+        reinterpret_cast<const std::int32_t *>(data + layer.biases)};
+  }
+
+  return true;
+}
+
+Network::~Network() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, size_);
+  }
+}
+
+bool Network::Load(Network *network, const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat statbuf;
+
+  if (fd < 0) {
+    return false;
+  }
+
+  if (fstat(fd, &statbuf) != 0 || statbuf.st_size < NETWORK_HEADER_SIZE) {
+    close(fd);
+    return false;
+  }
+
+  std::size_t size = statbuf.st_size;
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  Network mapped;
+
+  mapped.mapping_ = mapping;
+  mapped.size_ = size;
+
+  if (!mapped.Bind(static_cast<const std::byte *>(mapping), size)) {
+    return false;
+  }
+
+  // INFO: hand the mapping over, `mapped` must not unmap it
+  if (network->mapping_ != nullptr) {
+    munmap(network->mapping_, network->size_);
+  }
+
+  network->mapping_ = std::exchange(mapped.mapping_, nullptr);
+  network->size_ = size;
+  network->input_weights_ = mapped.input_weights_;
+  network->input_biases_ = mapped.input_biases_;
+  std::copy(std::begin(mapped.hidden_), std::end(mapped.hidden_),
+            network->hidden_);
+
+  return true;
+}
+
+// Outputs of `layer` at NETWORK_SCALE, negatives are cut off when `relu`.
+static void Forward(const DenseLayer &layer, const std::int16_t *inputs,
+                    std::int32_t *outputs, bool relu) {
+  DotFn dot = dot_fn.load(std::memory_order_relaxed);
+
+  for (int j = 0; j < layer.outputs; j++) {
+    std::int32_t sum = layer.biases[j] +
+                       dot(layer.weights + j * layer.inputs, inputs,
+                           layer.inputs);
+
+    outputs[j] = relu ? std::max(sum, 0) / layer.scale : sum;
+  }
+}
+
+// INFO: plain loops over int16, the compiler vectorizes them
+void Network::AddInput(std::int16_t *values, int input) const {
+  const std::int16_t *column = &input_weights_[input * NETWORK_L1];
+
+  for (int i = 0; i < NETWORK_L1; i++) {
+    values[i] += column[i];
+  }
+}
+
+void Network::SubInput(std::int16_t *values, int input) const {
+  const std::int16_t *column = &input_weights_[input * NETWORK_L1];
+
+  for (int i = 0; i < NETWORK_L1; i++) {
+    values[i] -= column[i];
+  }
+}
+
+void Network::Refresh(Accumulator *accumulator, const Board &board) const {
+  for (int color = WHITE; color < COLOR; color++) {
+    Color perspective = static_cast<Color>(color);
+    Color opp = OPP(perspective);
+    std::int16_t *values = accumulator->values[color];
+
+    std::copy(input_biases_, input_biases_ + NETWORK_L1, values);
+
+    BITLOOP(board.pieces[color][KING]) {
+      AddInput(values, INPUT_KING + Relative(perspective, LOOP_INDEX));
+    }
+
+    BITLOOP(board.pieces[color][ROOK]) {
+      AddInput(values, INPUT_ROOK + Relative(perspective, LOOP_INDEX));
+    }
+
+    BITLOOP(board.pieces[opp][KING]) {
+      AddInput(values, INPUT_ENEMY_KING + Relative(perspective, LOOP_INDEX));
+    }
+
+    accumulator->kings[color] = board.pieces[color][KING];
+    accumulator->rooks[color] = board.pieces[color][ROOK];
+  }
+}
+
+void Network::Update(Accumulator *accumulator, const Accumulator &previous,
+                     const Board &board) const {
+  *accumulator = previous;
+
+  for (int color = WHITE; color < COLOR; color++) {
+    Color perspective = static_cast<Color>(color);
+    Color opp = OPP(perspective);
+    std::int16_t *values = accumulator->values[color];
+
+    const struct {
+      int input;
+      Bitboard before;
+      Bitboard after;
+    } groups[3] = {
+        {INPUT_KING, previous.kings[color], board.pieces[color][KING]},
+        {INPUT_ROOK, previous.rooks[color], board.pieces[color][ROOK]},
+        {INPUT_ENEMY_KING, previous.kings[opp], board.pieces[opp][KING]}};
+
+    for (const auto &group : groups) {
+      BITLOOP(group.before & ~group.after) {
+        SubInput(values, group.input + Relative(perspective, LOOP_INDEX));
+      }
+
+      BITLOOP(group.after & ~group.before) {
+        AddInput(values, group.input + Relative(perspective, LOOP_INDEX));
+      }
+    }
+
+    accumulator->kings[color] = board.pieces[color][KING];
+    accumulator->rooks[color] = board.pieces[color][ROOK];
+  }
+}
+
+float Network::Predict(const Accumulator &accumulator, Color strong,
+                       bool strong_to_move) const {
+  alignas(32) std::int16_t inputs[NETWORK_L1];
+  alignas(32) std::int16_t hidden[NETWORK_L2];
+  std::int32_t outputs[NETWORK_L2];
+  const std::int16_t *values = accumulator.values[strong];
+  const std::int16_t *turn = &input_weights_[INPUT_TURN * NETWORK_L1];
+
+  // the model was trained with the strong side as white, 1 when black moves
+  for (int i = 0; i < NETWORK_L1; i++) {
+    int value = values[i] + (strong_to_move ? 0 : turn[i]);
+
+    inputs[i] = static_cast<std::int16_t>(std::max(value, 0));
+  }
+
+  Forward(hidden_[0], inputs, outputs, true);
+
+  for (int i = 0; i < NETWORK_L2; i++) {
+    hidden[i] = static_cast<std::int16_t>(std::min(outputs[i], INT16_MAX));
+  }
+
+  Forward(hidden_[1], hidden, outputs, true);
+
+  for (int i = 0; i < NETWORK_L3; i++) {
+    hidden[i] = static_cast<std::int16_t>(std::min(outputs[i], INT16_MAX));
+  }
+
+  Forward(hidden_[2], hidden, outputs, false);
+
+  return static_cast<float>(outputs[0]) /
+         (NETWORK_SCALE * hidden_[2].scale);
+}
+
+namespace network {
+
+static std::unique_ptr<Network> current;
+
+// The only KRK draws: the lone king, to move, takes an undefended rook or is
+// stalemated. Every other position is won by the side with the rook.
+static bool Drawn(const Board &board, Color strong, bool strong_to_move) {
+  if (strong_to_move) {
+    return false;
+  }
+
+  Bitboard rook = board.pieces[strong][ROOK];
+  Bitboard enemy_king = board.pieces[OPP(strong)][KING];
+  int enemy_square = square::Index(enemy_king);
+
+  // INFO: the lone king doesn't block the rook along the line it's checked on
+  Bitboard guarded =
+      kAttackMaps[KING][square::Index(board.pieces[strong][KING])] |
+      kSlidingAttacks.Rook(board.occupied_sqs ^ enemy_king,
+                           square::Index(rook));
+  Bitboard escapes = kAttackMaps[KING][enemy_square] & ~guarded;
+  bool check = guarded & enemy_king;
+
+  return escapes & rook || (!escapes && !check);
+}
+
+bool Load(const std::string &path) {
+  auto network = std::make_unique<Network>();
+
+  if (!Network::Load(network.get(), path)) {
+    return false;
+  }
+
+  current = std::move(network);
+
+  return true;
+}
+
+void Unload() { current.reset(); }
+
+const Network *Current() { return current.get(); }
+
+bool Evaluate(Position &position, int *score) {
+  const Network *network = current.get();
+  const Board &board = position.board_;
+
+  if (network == nullptr || std::popcount(board.occupied_sqs) != 3) {
+    return false;
+  }
+
+  Color strong;
+
+  if (board.pieces[WHITE][ROOK]) {
+    strong = WHITE;
+  } else if (board.pieces[BLACK][ROOK]) {
+    strong = BLACK;
+  } else {
+    return false;
+  }
+
+  // INFO: the model was trained on draws as well, with a distance of 0, it
+  // can't tell them from immediate wins
+  if (Drawn(board, strong, position.turn_ == strong)) {
+    *score = 0;
+    return true;
+  }
+
+  std::vector<Accumulator> &accumulators = position.accumulators_;
+
+  // INFO: the stack only exists once a covered position is reached, Make &
+  // Undo keep it in step from then on.
+  if (accumulators.empty()) {
+    accumulators.reserve(MAX_DEPTH);
+    accumulators.emplace_back();
+    network->Refresh(&accumulators.back(), board);
+  }
+
+  float dtz = network->Predict(accumulators.back(), strong,
+                               position.turn_ == strong);
+  int distance = std::min(NETWORK_MAX_DTZ,
+                          static_cast<int>(std::lround(std::abs(dtz))));
+  int value = NETWORK_WIN_SCORE - NETWORK_DTZ_WEIGHT * distance;
+
+  *score = strong == WHITE ? value : -value;
+
+  return true;
+}
+
+}  // namespace network
+
+}  // namespace engine
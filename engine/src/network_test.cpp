@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/move.hpp"
+#include "engine/network.hpp"
+#include "engine/position.hpp"
+#include "engine/square.hpp"
+#include "engine/types.hpp"
+
+using namespace engine;
+
+class NetworkTestSuite : public testing::Test {
+ protected:
+  std::vector<float> params;
+  std::vector<std::byte> image;
+  std::string path;
+
+  void Write(const std::vector<std::byte> &bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  }
+
+  // INFO: a made up model, small enough weights for the distances to stay
+  // under NETWORK_MAX_DTZ
+  void SetUp() override {
+    std::mt19937 random(2024);
+    std::uniform_real_distribution<float> weight(-0.25, 0.25);
+
+    params.resize(NETWORK_PARAMS);
+
+    for (float &param : params) {
+      param = weight(random);
+    }
+
+    path = (std::filesystem::temp_directory_path() / "network_test.bin");
+    image = Network::Quantize(params.data());
+
+    Write(image);
+
+    ASSERT_TRUE(network::Load(path));
+  }
+
+  void TearDown() override {
+    network::Unload();
+    std::filesystem::remove(path);
+  }
+
+  // the model as trained, in float
+  float Reference(int turn, int king, int rook, int enemy_king) {
+    const int sizes[5] = {NETWORK_INPUTS, NETWORK_L1, NETWORK_L2, NETWORK_L3,
+                          1};
+    std::vector<float> inputs(NETWORK_INPUTS, 0);
+    const float *layer = params.data();
+
+    inputs[INPUT_TURN] = turn;
+    inputs[INPUT_KING + king] = 1;
+    inputs[INPUT_ROOK + rook] = 1;
+    inputs[INPUT_ENEMY_KING + enemy_king] = 1;
+
+    for (int l = 0; l < 4; l++) {
+      const float *bias = layer + sizes[l] * sizes[l + 1];
+      std::vector<float> outputs(bias, bias + sizes[l + 1]);
+
+      for (int i = 0; i < sizes[l]; i++) {
+        for (int j = 0; j < sizes[l + 1]; j++) {
+          outputs[j] += inputs[i] * layer[i * sizes[l + 1] + j];
+        }
+      }
+
+      if (l < 3) {
+        for (float &output : outputs) {
+          output = std::max(output, 0.0f);
+        }
+      }
+
+      inputs = outputs;
+      layer = bias + sizes[l + 1];
+    }
+
+    return inputs[0];
+  }
+};
+
+TEST_F(NetworkTestSuite, LoadValidatesFile) {
+  Network network;
+  NetworkHeader header;
+
+  std::memcpy(&header, image.data(), sizeof(header));
+
+  ASSERT_EQ(header.size, image.size());
+  ASSERT_EQ(header.layer[0].scale, static_cast<std::uint32_t>(NETWORK_SCALE));
+
+  for (const NetworkLayerHeader &layer : header.layer) {
+    ASSERT_EQ(layer.weights % NETWORK_ALIGNMENT, 0u);
+    ASSERT_EQ(layer.biases % NETWORK_ALIGNMENT, 0u);
+  }
+
+  ASSERT_TRUE(Network::Load(&network, path));
+
+  // a flipped weight bit
+  std::vector<std::byte> corrupted = image;
+
+  corrupted[header.layer[2].weights] ^= std::byte{1};
+  Write(corrupted);
+  ASSERT_FALSE(Network::Load(&network, path));
+
+  // a newer format
+  corrupted = image;
+  corrupted[4] = std::byte{NETWORK_VERSION + 1};
+  Write(corrupted);
+  ASSERT_FALSE(Network::Load(&network, path));
+
+  corrupted = image;
+  corrupted.resize(image.size() - NETWORK_ALIGNMENT);
+  Write(corrupted);
+  ASSERT_FALSE(Network::Load(&network, path));
+
+  ASSERT_FALSE(Network::Load(&network, path + ".missing"));
+}
+
+TEST_F(NetworkTestSuite, QuantizeSaturatesLargeWeights) {
+  NetworkHeader header;
+
+  // INFO: the first layer's weights & biases are int16 at NETWORK_SCALE
+  params[0] = 1e6;
+  params[1] = -1e6;
+  params[NETWORK_INPUTS * NETWORK_L1] = 1e30;
+  image = Network::Quantize(params.data());
+
+  std::memcpy(&header, image.data(), sizeof(header));
+
+  std::int16_t weights[2];
+  std::int16_t bias;
+
+  std::memcpy(weights, image.data() + header.layer[0].weights,
+              sizeof(weights));
+  std::memcpy(&bias, image.data() + header.layer[0].biases, sizeof(bias));
+
+  ASSERT_EQ(weights[0], INT16_MAX);
+  ASSERT_EQ(weights[1], INT16_MIN);
+  ASSERT_EQ(bias, INT16_MAX);
+}
+
+TEST_F(NetworkTestSuite, PredictMatchesFloatModel) {
+  const Network *network = network::Current();
+  const char *fens[] = {"4k3/8/4K3/8/8/8/8/R7 w - - 0 1",
+                        "4k3/8/4K3/8/8/8/8/R7 b - - 0 1",
+                        "8/8/8/3k4/8/8/8/R3K3 w - - 0 1",
+                        "r3k3/8/8/8/3K4/8/8/8 b - - 0 1",
+                        "r3k3/8/8/8/3K4/8/8/8 w - - 0 1"};
+
+  for (const char *fen : fens) {
+    Position position = Position::FromFen(fen);
+    Board board;
+    Accumulator accumulator;
+    char piece;
+
+    for (int square = 0; square < 64; square++) {
+      if (!position.PieceAt(&piece, square)) {
+        continue;
+      }
+
+      Color color = piece >= 'a' ? BLACK : WHITE;
+      Piece type = piece == 'r' || piece == 'R' ? ROOK : KING;
+
+      board.pieces[color][type] |= square::BB(square);
+    }
+
+    Color strong = board.pieces[WHITE][ROOK] ? WHITE : BLACK;
+    int flip = strong == WHITE ? 0 : 56;
+
+    network->Refresh(&accumulator, board);
+
+    float predicted =
+        network->Predict(accumulator, strong, position.Turn() == strong);
+    float expected = Reference(
+        position.Turn() != strong,
+        square::Index(board.pieces[strong][KING]) ^ flip,
+        square::Index(board.pieces[strong][ROOK]) ^ flip,
+        square::Index(board.pieces[OPP(strong)][KING]) ^ flip);
+
+    ASSERT_NEAR(predicted, expected, 0.05 * std::max(1.0f, std::abs(expected)))
+        << fen;
+  }
+}
+
+TEST_F(NetworkTestSuite, IncrementalUpdateMatchesRefresh) {
+  Position position = Position::FromFen("8/8/8/3k4/8/8/8/R3K3 w - - 0 1");
+  int score;
+
+  ASSERT_TRUE(network::Evaluate(position, &score));
+
+  for (Move &move : position.LegalMoves()) {
+    position.Make(move);
+
+    for (Move &reply : position.LegalMoves()) {
+      position.Make(reply);
+
+      Position fresh = Position::FromFen(position.ToFen());
+      int expected;
+      bool covered = network::Evaluate(fresh, &expected);
+
+      ASSERT_EQ(network::Evaluate(position, &score), covered);
+
+      if (covered) {
+        ASSERT_EQ(score, expected) << position.ToFen();
+      }
+
+      position.Undo(reply);
+    }
+
+    position.Undo(move);
+  }
+}
+
+TEST_F(NetworkTestSuite, OnlyScoresKingAndRookAgainstKing) {
+  int score;
+
+  Position position = Position::FromFen(kStartPos);
+  ASSERT_FALSE(network::Evaluate(position, &score));
+
+  position = Position::FromFen("4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+  ASSERT_FALSE(network::Evaluate(position, &score));
+
+  position = Position::FromFen("4k3/8/8/8/8/8/8/Q3K3 w - - 0 1");
+  ASSERT_FALSE(network::Evaluate(position, &score));
+
+  position = Position::FromFen("4k3/8/8/8/8/8/8/R3K3 w - - 0 1");
+  ASSERT_TRUE(network::Evaluate(position, &score));
+  ASSERT_GT(score, 0);
+  ASSERT_LE(score, NETWORK_WIN_SCORE);
+
+  position = Position::FromFen("r3k3/8/8/8/8/8/8/4K3 w - - 0 1");
+  ASSERT_TRUE(network::Evaluate(position, &score));
+  ASSERT_LT(score, 0);
+
+  network::Unload();
+
+  position = Position::FromFen("4k3/8/8/8/8/8/8/R3K3 w - - 0 1");
+  ASSERT_FALSE(network::Evaluate(position, &score));
+}
+
+TEST_F(NetworkTestSuite, DrawsAreNotWins) {
+  int score;
+
+  // the lone king takes the undefended rook
+  Position position = Position::FromFen("8/8/8/8/8/8/1k6/R6K b - - 0 1");
+  ASSERT_TRUE(network::Evaluate(position, &score));
+  ASSERT_EQ(score, 0);
+
+  position = Position::FromFen("k7/8/8/8/8/8/6K1/7r w - - 0 1");
+  ASSERT_TRUE(network::Evaluate(position, &score));
+  ASSERT_EQ(score, 0);
+
+  // stalemate
+  position = Position::FromFen("8/8/8/8/8/8/7R/k1K5 b - - 0 1");
+  ASSERT_TRUE(network::Evaluate(position, &score));
+  ASSERT_EQ(score, 0);
+
+  // the same rook defended, or with the side that has it to move, is a win
+  position = Position::FromFen("8/8/8/8/1K6/R7/1k6/8 b - - 0 1");
+  ASSERT_TRUE(network::Evaluate(position, &score));
+  ASSERT_GT(score, 0);
+
+  position = Position::FromFen("8/8/8/8/8/8/1k6/R6K w - - 0 1");
+  ASSERT_TRUE(network::Evaluate(position, &score));
+  ASSERT_GT(score, 0);
+
+  // checkmate is a win, even though the lone king can't move
+  position = Position::FromFen("k7/2K5/8/8/8/8/8/R7 b - - 0 1");
+  ASSERT_TRUE(network::Evaluate(position, &score));
+  ASSERT_GT(score, 0);
+}
@@ -145,7 +145,8 @@ bool Node::GetHelper(Node *master, Node *node, const Move &move) {
 
       if (!master->slaves_.empty() && master->waiting_ && !master->helping_) {
         master->helping_ = true;
-        master->help_ = new Worker(false);
+        // INFO: helpers only live for a split, they aren't pinned
+        master->help_ = new Worker(-1, false);
 
         master->help_->Assign(node, const_cast<Move *>(&move));
 
@@ -2,6 +2,10 @@
 
 namespace engine {
 
-Options options{.tasks = 1};
+Options options{.tasks = 1,
+                .affinity = Affinity::NONE,
+                .syzygy_probe_depth = 1,
+                .syzygy_probe_limit = 6,
+                .syzygy_warmup = 0};
 
 }
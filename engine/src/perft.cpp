@@ -1,68 +1,58 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
-#include <cstring>
-#include <functional>
-#include <iostream>
-#include <mutex>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 #include "engine/constants.hpp"
 #include "engine/move.hpp"
 #include "engine/move_gen.hpp"
+#include "engine/perft.hpp"
 #include "engine/position.hpp"
 #include "engine/scheduler.hpp"
+#include "engine/transposition.hpp"
 #include "engine/types.hpp"
 #include "engine/utils.hpp"
 
-using namespace engine;
-
-struct Stat {
-  std::size_t nodes = 0;
-  std::size_t checks = 0;
-  std::size_t captures = 0;
-  std::size_t checkmates = 0;
-  std::size_t en_passants = 0;
-  std::size_t discovery_checks = 0;
-  std::size_t double_checks = 0;
-  std::size_t promotions = 0;
-  std::size_t castles = 0;
-  std::unordered_map<std::string, std::size_t> map{};
-
-  Stat &operator+=(const Stat &stat) {
-    nodes += stat.nodes;
-    checks += stat.checks;
-    captures += stat.captures;
-    checkmates += stat.checkmates;
-    en_passants += stat.en_passants;
-    discovery_checks += stat.discovery_checks;
-    double_checks += stat.double_checks;
-    promotions += stat.promotions;
-    castles += stat.castles;
-
-    return *this;
-  }
-};
+namespace engine {
+
+PerftStat &PerftStat::operator+=(const PerftStat &stat) {
+  nodes += stat.nodes;
+  checks += stat.checks;
+  captures += stat.captures;
+  checkmates += stat.checkmates;
+  en_passants += stat.en_passants;
+  discovery_checks += stat.discovery_checks;
+  double_checks += stat.double_checks;
+  promotions += stat.promotions;
+  castles += stat.castles;
+  tt_probes += stat.tt_probes;
+  tt_hits += stat.tt_hits;
+
+  return *this;
+}
 
-Stat Perft(Position &position, int depth, bool divide) {
+PerftStat Perft(Position &position, int depth, bool divide) {
   if (depth == 0) {
     return {static_cast<std::uint64_t>(1)};
   }
 
-  Stat stat;
+  PerftStat stat;
   MoveList move_list = GenerateMoves(position);
 
   for (Move &move : move_list) {
     position.Make(move);
 
-    Stat result = Perft(position, depth - 1, false);
+    PerftStat result = Perft(position, depth - 1, false);
 
     stat += result;
 
     if (depth - 1 == 0) {
-      Bitboard check_mask = CheckMask(position);
+      Bitboard check_mask = position.Masks().check_mask;
       stat.checks += check_mask != kUniverse;
       stat.captures += move.Is(move::CAPTURE) + move.Is(move::EN_PASSANT);
       stat.en_passants += move.Is(move::EN_PASSANT);
@@ -88,9 +78,31 @@ Stat Perft(Position &position, int depth, bool divide) {
   return stat;
 }
 
-Stat BulkPerft(Position &position, int depth, bool divide) {
-  Stat stat;
-  MoveList move_list = GenerateMoves(position);
+static bool Stopped(const std::atomic<bool> *stop) {
+  return stop != nullptr && stop->load(std::memory_order_relaxed);
+}
+
+template <enum Color side>
+static PerftStat BulkPerft(Position &position, int depth, bool divide,
+                           PerftTT *tt, const std::atomic<bool> *stop) {
+  PerftStat stat;
+  std::uint64_t nodes;
+
+  if (depth > 1 && Stopped(stop)) {
+    return stat;
+  }
+
+  if (tt != nullptr && depth > 1 && !divide) {
+    stat.tt_probes++;
+
+    if (tt->Probe(position, depth, &nodes)) {
+      stat.tt_hits++;
+      stat.nodes = nodes;
+      return stat;
+    }
+  }
+
+  MoveList move_list = GenerateMoves<side>(position);
 
   if (depth == 1) {
     stat.nodes = move_list.size();
@@ -98,13 +110,14 @@ Stat BulkPerft(Position &position, int depth, bool divide) {
   }
 
   for (Move &move : move_list) {
-    position.Make(move);
+    position.Make<side>(move);
 
-    Stat result = BulkPerft(position, depth - 1, false);
+    PerftStat result =
+        BulkPerft<OPP(side)>(position, depth - 1, false, tt, stop);
 
     stat += result;
 
-    position.Undo(move);
+    position.Undo<side>(move);
 
     if (divide) {
       char s[6];
@@ -115,101 +128,161 @@ Stat BulkPerft(Position &position, int depth, bool divide) {
     }
   }
 
+  // INFO: a stopped count is partial, it mustn't be reused
+  if (tt != nullptr && !divide && !Stopped(stop)) {
+    tt->Add(position, depth, stat.nodes);
+  }
+
   return stat;
 }
 
-Stat ThreadedPerft(Scheduler *scheduler, Position &position, int depth,
-                   bool divide) {
-  Stat stat;
-  std::mutex m;
-  std::vector<Status *> jobs;
+static PerftStat BulkPerft(Position &position, int depth, bool divide,
+                           PerftTT *tt, const std::atomic<bool> *stop) {
+  return position.Turn() == WHITE
+             ? BulkPerft<WHITE>(position, depth, divide, tt, stop)
+             : BulkPerft<BLACK>(position, depth, divide, tt, stop);
+}
+
+PerftStat BulkPerft(Position &position, int depth, bool divide, PerftTT *tt) {
+  return BulkPerft(position, depth, divide, tt, nullptr);
+}
+
+static std::atomic<std::uint64_t> runs = 0;
+
+// INFO: every worker keeps its own copy of the root & replays the split path on
+// it, so a job only carries the moves instead of a position.
+static thread_local Position local_position;
+static thread_local std::uint64_t local_run = 0;
+
+static void CollectSplits(Position &position, int plies, PerftSplit *split,
+                          std::vector<PerftSplit> *splits) {
+  if (split->size == plies) {
+    splits->push_back(*split);
+    return;
+  }
+
   MoveList move_list = GenerateMoves(position);
 
-  if (depth == 1) {
-    stat.nodes = move_list.size();
-    return stat;
+  for (Move &move : move_list) {
+    split->path[split->size++] = move;
+
+    position.Make(move);
+    CollectSplits(position, plies, split, splits);
+    position.Undo(move);
+
+    split->size--;
+  }
+}
+
+PerftStat ThreadedPerft(Scheduler *scheduler, Position &position, int depth,
+                        bool divide, bool bulk, PerftTT *tt, int split_depth,
+                        const std::atomic<bool> *stop) {
+  if (depth <= 1) {
+    return bulk ? BulkPerft(position, depth, divide)
+                : Perft(position, depth, divide);
   }
 
-  auto callback = [](Position position, int depth, bool divide, Move *move,
-                     Stat *stat, std::mutex *m) {
-    Stat result = BulkPerft(position, depth, false);
+  int max_split = std::min(depth - 1, PERFT_MAX_SPLIT_DEPTH);
+  std::size_t min_jobs = 16 * scheduler->Size();
+  std::vector<PerftSplit> splits;
+  PerftSplit split;
 
-    std::lock_guard<std::mutex> lock_guard(*m);
+  // INFO: an explicit split depth is used as is, only 0 is tuned
+  bool tune = split_depth <= 0;
 
-    *stat += result;
+  split_depth = tune ? 1 : std::min(split_depth, max_split);
 
-    if (divide) {
-      char s[6];
+  while (true) {
+    splits.clear();
+    CollectSplits(position, split_depth, &split, &splits);
 
-      if (ToString(s, *move)) {
-        (*stat).map.insert({s, result.nodes});
-      }
+    if (!tune || splits.size() >= min_jobs || split_depth == max_split) {
+      break;
     }
-  };
 
-  for (Move &move : move_list) {
-    position.Make(move);
+    split_depth++;
+  }
 
-    Status *status = scheduler->Dispatch([&, position]() {
-      callback(position, depth - 1, divide, &move, &stat, &m);
-    });
+  std::uint64_t run = ++runs;
+  std::vector<PerftStat> results(splits.size());
 
-    jobs.push_back(status);
+  scheduler->ParallelFor(
+      0, splits.size(),
+      [&](std::size_t i) {
+        const PerftSplit &split = splits[i];
+        int remaining = depth - split.size;
 
-    position.Undo(move);
-  }
+        if (Stopped(stop)) {
+          return;
+        }
 
-  for (Status *s : jobs) {
-    s->Wait();
-    delete s;
-  }
+        if (local_run != run) {
+          local_position = position;
+          local_run = run;
+        }
 
-  return stat;
-}
+        for (int j = 0; j < split.size; j++) {
+          local_position.Make(split.path[j]);
+        }
 
-using PerftFun = std::function<Stat(Position &, int, bool)>;
+        results[i] = bulk ? BulkPerft(local_position, remaining, false, tt,
+                                      stop)
+                          : Perft(local_position, remaining, false);
 
-void Run(Position &position, PerftFun perft, int depth, bool divide) {
-  Stat stat = perft(position, depth, divide);
+        for (int j = split.size - 1; j >= 0; j--) {
+          local_position.Undo(split.path[j]);
+        }
+      },
+      1);
 
-  for (auto [k, v] : stat.map) {
-    std::cout << k << ": " << v << std::endl;
-  }
+  PerftStat stat;
 
-  std::printf(
-      "stats for depth %d is nodes=%lu, captures=%lu, e.p=%lu, castles=%lu, "
-      "promotions=%lu, checks=%lu, discovery checks=%lu, double checks=%lu, "
-      "checkmates=%lu\n",
-      depth, stat.nodes, stat.captures, stat.en_passants, stat.castles,
-      stat.promotions, stat.checks, stat.discovery_checks, stat.double_checks,
-      stat.checkmates);
+  for (std::size_t i = 0; i < splits.size(); i++) {
+    stat += results[i];
+
+    if (divide) {
+      char s[6];
 
-  if (divide) {
-    std::cout << std::endl;
+      if (ToString(s, splits[i].path[0])) {
+        stat.map[s] += results[i].nodes;
+      }
+    }
   }
+
+  return stat;
 }
 
-int main() {
-  std::printf("============================================\n");
-  std::printf("starting perf tests\n");
-  std::printf("============================================\n");
+bool ParseEPD(PerftCase *perft_case, const std::string_view &line) {
+  std::size_t end = line.find(';');
+  std::string_view fen = line.substr(0, end);
 
-  PerftFun perft = BulkPerft;
-  Position position = Position::FromFen(kStartPos);
+  while (!fen.empty() && std::isspace(fen.back())) {
+    fen.remove_suffix(1);
+  }
 
-  // TODO: allow workers count to be configurable
-  Scheduler scheduler;
+  if (fen.empty() || fen.front() == '#') {
+    return false;
+  }
 
-  scheduler.Init();
+  perft_case->fen = fen;
+  perft_case->expected.clear();
 
-  // ApplyFen(position, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R
-  // w KQkq -");
+  while (end != std::string_view::npos) {
+    std::size_t start = end + 1;
+    int depth;
+    unsigned long long nodes;
 
-  perft = [&scheduler](Position &position, int depth, bool divide) {
-    return ThreadedPerft(&scheduler, position, depth, divide);
-  };
+    end = line.find(';', start);
 
-  Run(position, perft, 8 - 2, true);
+    std::string s(line.substr(start, end - start));
 
-  return 0;
+    if (std::sscanf(s.c_str(), " D%d %llu", &depth, &nodes) == 2 &&
+        depth > 0) {
+      perft_case->expected.emplace_back(depth, nodes);
+    }
+  }
+
+  return true;
 }
+
+}  // namespace engine
@@ -0,0 +1,242 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "engine/affinity.hpp"
+#include "engine/attacks.hpp"
+#include "engine/constants.hpp"
+#include "engine/perft.hpp"
+#include "engine/position.hpp"
+#include "engine/scheduler.hpp"
+#include "engine/transposition.hpp"
+#include "engine/types.hpp"
+
+using namespace engine;
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  std::string fen = kStartPos;
+  std::string epd;
+  int depth = 0;
+  int threads = std::thread::hardware_concurrency();
+  int split = 0;
+  std::size_t hash = PERFT_TRANSPOSITION_SIZE;
+  bool divide = false;
+  bool bulk = true;
+  Affinity affinity = Affinity::NONE;
+};
+
+struct Result {
+  int depth;
+  std::uint64_t expected;
+  std::uint64_t nodes;
+  double seconds;
+};
+
+static void Usage(const char *program) {
+  std::printf(
+      "usage: %s [options]\n"
+      "  --fen <fen>      position to count, defaults to the start position\n"
+      "  --epd <file>     run every position of an EPD perft suite\n"
+      "  --depth <n>      depth to count, caps the suite depths with --epd\n"
+      "  --threads <n>    worker threads, defaults to the hardware threads\n"
+      "  --split <plies>  ply to split the tree into jobs at, 0 picks one\n"
+      "  --hash <mb>      perft hash size, 0 disables hashing\n"
+      "  --affinity <p>   pin workers to cpus: none, compact or spread\n"
+      "  --divide         print the node count of every root move\n"
+      "  --full           collect captures, checks, etc. instead of bulk "
+      "counting\n",
+      program);
+}
+
+static bool ParseArgs(Config *config, int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--fen" && has_value) {
+      config->fen = argv[++i];
+    } else if (arg == "--epd" && has_value) {
+      config->epd = argv[++i];
+    } else if (arg == "--depth" && has_value) {
+      config->depth = std::atoi(argv[++i]);
+    } else if (arg == "--threads" && has_value) {
+      config->threads = std::atoi(argv[++i]);
+    } else if (arg == "--split" && has_value) {
+      config->split = std::atoi(argv[++i]);
+    } else if (arg == "--hash" && has_value) {
+      config->hash = std::strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+    } else if (arg == "--affinity" && has_value) {
+      if (!affinity::Parse(&config->affinity, argv[++i])) {
+        return false;
+      }
+    } else if (arg == "--divide") {
+      config->divide = true;
+    } else if (arg == "--full") {
+      config->bulk = false;
+    } else {
+      return false;
+    }
+  }
+
+  return config->threads > 0 && config->depth >= 0 && config->split >= 0;
+}
+
+static double Elapsed(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void PrintStat(const PerftStat &stat, int depth, double seconds) {
+  std::map<std::string, std::size_t> divide(stat.map.begin(), stat.map.end());
+
+  for (const auto &[move, nodes] : divide) {
+    std::printf("%s: %zu\n", move.c_str(), nodes);
+  }
+
+  if (!divide.empty()) {
+    std::printf("\n");
+  }
+
+  std::printf(
+      "stats for depth %d is nodes=%zu, captures=%zu, e.p=%zu, castles=%zu, "
+      "promotions=%zu, checks=%zu, discovery checks=%zu, double checks=%zu, "
+      "checkmates=%zu\n",
+      depth, stat.nodes, stat.captures, stat.en_passants, stat.castles,
+      stat.promotions, stat.checks, stat.discovery_checks, stat.double_checks,
+      stat.checkmates);
+
+  if (stat.tt_probes) {
+    std::printf("hash hits=%zu/%zu (%.1f%%)\n", stat.tt_hits, stat.tt_probes,
+                100.0 * stat.tt_hits / stat.tt_probes);
+  }
+
+  std::printf("time=%.3fs nps=%.0f\n", seconds, stat.nodes / seconds);
+}
+
+static int RunPosition(const Config &config, Scheduler *scheduler,
+                       PerftTT *tt) {
+  int depth = config.depth ? config.depth : 6;
+  Position position = Position::FromFen(config.fen);
+
+  std::printf("%s\n", config.fen.c_str());
+
+  Clock::time_point start = Clock::now();
+  PerftStat stat = ThreadedPerft(scheduler, position, depth, config.divide,
+                                 config.bulk, tt, config.split);
+
+  PrintStat(stat, depth, Elapsed(start));
+
+  return 0;
+}
+
+static int RunSuite(const Config &config, Scheduler *scheduler, PerftTT *tt) {
+  std::string line;
+  std::ifstream file(config.epd);
+  std::vector<PerftCase> cases;
+
+  if (!file) {
+    std::fprintf(stderr, "unable to open %s\n", config.epd.c_str());
+    return 1;
+  }
+
+  while (std::getline(file, line)) {
+    PerftCase perft_case;
+
+    if (ParseEPD(&perft_case, line)) {
+      cases.push_back(perft_case);
+    }
+  }
+
+  std::vector<std::vector<Result>> results(cases.size());
+  Clock::time_point start = Clock::now();
+
+  // INFO: every position is counted on a single worker, the suite is spread
+  // across the scheduler instead.
+  scheduler->ParallelFor(
+      0, cases.size(),
+      [&](std::size_t i) {
+        Position position = Position::FromFen(cases[i].fen);
+
+        for (auto [depth, expected] : cases[i].expected) {
+          if (config.depth && depth > config.depth) {
+            continue;
+          }
+
+          Clock::time_point start = Clock::now();
+          PerftStat stat = config.bulk ? BulkPerft(position, depth, false, tt)
+                                       : Perft(position, depth, false);
+
+          results[i].push_back({depth, expected, stat.nodes, Elapsed(start)});
+        }
+      },
+      1);
+
+  int failures = 0;
+  std::uint64_t total = 0;
+
+  for (std::size_t i = 0; i < cases.size(); i++) {
+    std::printf("#%zu %s\n", i + 1, cases[i].fen.c_str());
+
+    for (const Result &result : results[i]) {
+      bool ok = result.nodes == result.expected;
+
+      failures += !ok;
+      total += result.nodes;
+
+      std::printf("  %s depth %d nodes=%" PRIu64 " expected=%" PRIu64
+                  " time=%.3fs nps=%.0f\n",
+                  ok ? "ok  " : "FAIL", result.depth, result.nodes,
+                  result.expected, result.seconds,
+                  result.nodes / result.seconds);
+    }
+  }
+
+  double seconds = Elapsed(start);
+
+  std::printf("%d failure(s), nodes=%" PRIu64 " time=%.3fs nps=%.0f\n",
+              failures, total, seconds, total / seconds);
+
+  return failures != 0;
+}
+
+int main(int argc, char **argv) {
+  Config config;
+
+  if (!ParseArgs(&config, argc, argv)) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  std::printf("============================================\n");
+  std::printf("starting perf tests\n");
+  std::printf("============================================\n");
+
+  std::printf("%s\n",
+              affinity::Describe(config.threads, config.affinity).c_str());
+  std::printf("sliding attacks %s\n",
+              kSlidingAttacks.Type() == SlidingAttacks::Backend::PEXT
+                  ? "pext"
+                  : "magic");
+
+  Scheduler scheduler(config.threads, config.affinity);
+  PerftTT tt(config.hash);
+  PerftTT *table = config.hash && config.bulk ? &tt : nullptr;
+
+  scheduler.Init();
+
+  if (!config.epd.empty()) {
+    return RunSuite(config, &scheduler, table);
+  }
+
+  return RunPosition(config, &scheduler, table);
+}
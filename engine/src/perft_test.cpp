@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "engine/perft.hpp"
+#include "engine/position.hpp"
+#include "engine/scheduler.hpp"
+#include "engine/transposition.hpp"
+
+using namespace engine;
+
+class PerftTestSuite : public testing::Test {};
+
+TEST_F(PerftTestSuite, TestParseEPD) {
+  PerftCase perft_case;
+
+  ASSERT_TRUE(ParseEPD(&perft_case,
+                       "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 ;D1 14 "
+                       ";D2 191 ;D3 2812"));
+  ASSERT_EQ(perft_case.fen, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+  ASSERT_EQ(perft_case.expected.size(), 3);
+  ASSERT_EQ(perft_case.expected[2].first, 3);
+  ASSERT_EQ(perft_case.expected[2].second, 2812);
+
+  ASSERT_FALSE(ParseEPD(&perft_case, ""));
+  ASSERT_FALSE(ParseEPD(&perft_case, "# comment"));
+}
+
+TEST_F(PerftTestSuite, TestFullPerft) {
+  Position position = Position::FromFen(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+  PerftStat stat = Perft(position, 2, true);
+
+  ASSERT_EQ(stat.nodes, 2039);
+  ASSERT_EQ(stat.captures, 351);
+  ASSERT_EQ(stat.en_passants, 1);
+  ASSERT_EQ(stat.castles, 91);
+  ASSERT_EQ(stat.map.size(), 48);
+}
+
+TEST_F(PerftTestSuite, TestHashedBulkPerft) {
+  PerftTT tt(1 << 20);
+  Position position = Position::FromFen(
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+
+  ASSERT_EQ(BulkPerft(position, 4, false).nodes, 422333);
+  ASSERT_EQ(BulkPerft(position, 4, false, &tt).nodes, 422333);
+
+  PerftStat stat = BulkPerft(position, 4, false, &tt);
+
+  ASSERT_EQ(stat.nodes, 422333);
+  ASSERT_EQ(stat.tt_hits, 1);
+}
+
+TEST_F(PerftTestSuite, TestThreadedPerftSplitsBelowRoot) {
+  Scheduler scheduler(2);
+  Position position = Position::FromFen(
+      "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8");
+
+  scheduler.Init();
+
+  for (int split_depth : {0, 1, 2, 3}) {
+    PerftStat stat = ThreadedPerft(&scheduler, position, 4, true, true, nullptr,
+                                   split_depth);
+
+    ASSERT_EQ(stat.nodes, 2103487);
+    ASSERT_EQ(stat.map.size(), 44);
+  }
+
+  PerftStat stat = ThreadedPerft(&scheduler, position, 3, false, false);
+
+  ASSERT_EQ(stat.nodes, 62379);
+  ASSERT_EQ(stat.captures, 8517);
+}
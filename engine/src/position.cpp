@@ -1,14 +1,17 @@
+#include <bit>
 #include <cassert>
-#include <tuple>
 #include <utility>
 
 #include "engine/board.hpp"
 #include "engine/constants.hpp"
+#include "engine/evaluation.hpp"
 #include "engine/fill.hpp"
 #include "engine/hash.hpp"
 #include "engine/move.hpp"
 #include "engine/move_gen.hpp"
+#include "engine/network.hpp"
 #include "engine/position.hpp"
+#include "engine/psqt.hpp"
 #include "engine/square.hpp"
 #include "engine/types.hpp"
 #include "engine/utils.hpp"
@@ -16,18 +19,126 @@
 namespace engine {
 namespace position {
 
+void AttackMaps(const Board &board, AttackInfo *info) {
+  Bitboard empty_sqs = ~board.occupied_sqs;
+
+  for (Color color : {WHITE, BLACK}) {
+    const PieceList &pieces = board.pieces[color];
+    Bitboard *attacks = info->piece_attacks[color];
+
+    attacks[PAWN] = color == WHITE ? PawnTargets<WHITE>(pieces[PAWN])
+                                   : PawnTargets<BLACK>(pieces[PAWN]);
+    attacks[KNIGHT] = KNIGHT_ATTACKS(pieces[KNIGHT]);
+    attacks[BISHOP] = SliderAttacks(kEmpty, pieces[BISHOP], empty_sqs);
+    attacks[ROOK] = SliderAttacks(pieces[ROOK], kEmpty, empty_sqs);
+    attacks[QUEEN] = SliderAttacks(pieces[QUEEN], pieces[QUEEN], empty_sqs);
+    attacks[KING] = KING_ATTACKS(pieces[KING]);
+
+    info->attacks[color] = attacks[PAWN] | attacks[KNIGHT] | attacks[BISHOP] |
+                           attacks[ROOK] | attacks[QUEEN] | attacks[KING];
+  }
+}
+
+// INFO: squares the king & the rook stand on while the right is kept
+static constexpr struct {
+  Castling flag;
+  Color color;
+  int king;
+  int rook;
+} kCastlings[] = {{CASTLE_W_KING_SIDE, WHITE, e1, h1},
+                  {CASTLE_W_QUEEN_SIDE, WHITE, e1, a1},
+                  {CASTLE_B_KING_SIDE, BLACK, e8, h8},
+                  {CASTLE_B_QUEEN_SIDE, BLACK, e8, a8}};
+
+bool Placement::Add(Color color, Piece piece, int square) {
+  Bitboard bb = square::BB(square);
+
+  for (const PieceList &side : pieces) {
+    for (Bitboard placed : side) {
+      if (placed & bb) {
+        return false;
+      }
+    }
+  }
+
+  pieces[color][piece] |= bb;
+
+  return true;
+}
+
+bool Placement::Valid() const {
+  const PieceList &white = pieces[WHITE];
+  const PieceList &black = pieces[BLACK];
+  Board board;
+  AttackInfo info;
+
+  for (Color color : {WHITE, BLACK}) {
+    for (Bitboard placed : pieces[color]) {
+      // a square can't hold two pieces
+      if (board.occupied_sqs & placed) {
+        return false;
+      }
+
+      board.occupied_sqs |= placed;
+    }
+
+    board.pieces[color] = pieces[color];
+  }
+
+  if (std::popcount(white[KING]) != 1 || std::popcount(black[KING]) != 1 ||
+      (white[PAWN] | black[PAWN]) & (kRank1 | kRank8)) {
+    return false;
+  }
+
+  // the side that just moved can't be left in check
+  AttackMaps(board, &info);
+
+  if (info.attacks[turn] & pieces[OPP(turn)][KING]) {
+    return false;
+  }
+
+  for (const auto &castling : kCastlings) {
+    const PieceList &side = pieces[castling.color];
+
+    if (castling_rights & castling.flag &&
+        (!(side[KING] & square::BB(castling.king)) ||
+         !(side[ROOK] & square::BB(castling.rook)))) {
+      return false;
+    }
+  }
+
+  if (castling_rights & ~(CASTLE_W_KING_SIDE | CASTLE_W_QUEEN_SIDE |
+                          CASTLE_B_KING_SIDE | CASTLE_B_QUEEN_SIDE)) {
+    return false;
+  }
+
+  if (en_passant_sq == kEmpty) {
+    return true;
+  }
+
+  // INFO: the pawn that was just pushed two squares sits in front of the en
+  // passant square & the square it came from is empty.
+  Bitboard rank = turn == WHITE ? kRank6 : kRank3;
+  Bitboard pawn = turn == WHITE ? en_passant_sq >> 8 : en_passant_sq << 8;
+  Bitboard origin = turn == WHITE ? en_passant_sq << 8 : en_passant_sq >> 8;
+
+  return std::popcount(en_passant_sq) == 1 && en_passant_sq & rank &&
+         pawn & pieces[OPP(turn)][PAWN] &&
+         !((en_passant_sq | origin) & board.occupied_sqs);
+}
+
 State State::From(Position &position) {
-  return {position.king_ban_,
-          position.board_.occupied_sqs,
+  return {position.board_.occupied_sqs,
           position.en_passant_sq_,
           position.en_passant_target_,
           position.castling_rights_,
           position.halfmove_clock_,
-          position.hash_};
+          position.hash_,
+          position.psq_,
+          position.phase_};
 }
 
 void State::Apply(Position &position, State &state) {
-  position.king_ban_ = state.king_ban;
   position.halfmove_clock_ = state.halfmove_clock;
   position.castling_rights_ = state.castling_rights;
   position.en_passant_sq_ = state.en_passant_square;
@@ -35,6 +146,8 @@ void State::Apply(Position &position, State &state) {
   position.board_.occupied_sqs = state.occupied_sqs;
 
   position.hash_ = state.hash;
+  position.psq_ = state.psq;
+  position.phase_ = state.phase;
 }
 
 }  // namespace position
@@ -42,11 +155,13 @@ void State::Apply(Position &position, State &state) {
 Position::Position()
     : turn_(WHITE),
       hash_(0),
-      king_ban_(kEmpty),
       en_passant_sq_(kEmpty),
       castling_rights_(0),
       fullmove_counter_(1),
-      halfmove_clock_(0) {};
+      halfmove_clock_(0),
+      psq_(0),
+      phase_(0),
+      attack_info_level_(position::ATTACK_NONE) {};
 
 Position::Position(const Position &src) { Clone(src); }
 
@@ -58,7 +173,6 @@ Position &Position::operator=(const Position &src) {
 
 void Position::Clone(const Position &src) {
   turn_ = src.turn_;
-  king_ban_ = src.king_ban_;
   en_passant_sq_ = src.en_passant_sq_;
   en_passant_target_ = src.en_passant_target_;
   castling_rights_ = src.castling_rights_;
@@ -69,6 +183,12 @@ void Position::Clone(const Position &src) {
   history_ = src.history_;
   mailbox_ = src.mailbox_;
   hash_ = src.hash_;
+  psq_ = src.psq_;
+  phase_ = src.phase_;
+  accumulators_ = src.accumulators_;
+
+  attack_info_ = src.attack_info_;
+  attack_info_level_ = src.attack_info_level_;
 }
 
 MoveList Position::LegalMoves() const { return GenerateMoves(*this); }
@@ -102,17 +222,70 @@ bool Position::PieceAt(char *c, int index) const {
 void Position::Reset() {
   board_.Reset();
 
-  king_ban_ = kEmpty;
   castling_rights_ = 0;
   en_passant_sq_ = kEmpty;
   history_ = kEmptyStack;
   hash_ = 0;
+  psq_ = 0;
+  phase_ = 0;
+  accumulators_.clear();
 
   for (int i = 0; i < 64; i++) {
     mailbox_[i] = NONE;
   }
 }
 
+bool Position::ApplyPlacement(Position *position,
+                              const position::Placement &placement) {
+  if (!placement.Valid()) {
+    return false;
+  }
+
+  position->Load(placement);
+
+  return true;
+}
+
+// INFO: the hash & the scores are summed from the bitboards, the rest of the
+// internals only get computed once everything is in place.
+void Position::Load(const position::Placement &placement) {
+  turn_ = placement.turn;
+  castling_rights_ = placement.castling_rights;
+  en_passant_sq_ = placement.en_passant_sq;
+  halfmove_clock_ = placement.halfmove_clock;
+  fullmove_counter_ = placement.fullmove_counter;
+  history_ = kEmptyStack;
+  hash_ = 0;
+  psq_ = 0;
+  phase_ = 0;
+
+  for (Color color : {WHITE, BLACK}) {
+    board_.pieces[color] = placement.pieces[color];
+
+    for (int i = 0; i < PIECES; i++) {
+      Piece piece = static_cast<Piece>(i);
+
+      BITLOOP(board_.pieces[color][piece]) {
+        hash_ ^= HASH1(LOOP_INDEX, color, piece);
+        AddScore(color, piece, LOOP_INDEX);
+      }
+    }
+  }
+
+  if (turn_ == BLACK) {
+    hash_ ^= kZobrist.color;
+  }
+
+  BITLOOP(castling_rights_) { hash_ ^= kZobrist.castling_rights[LOOP_INDEX]; }
+
+  if (en_passant_sq_) {
+    hash_ ^= kZobrist.en_passant_file[square::File(
+        square::Index(en_passant_sq_))];
+  }
+
+  UpdateInternals();
+}
+
 void Position::SetPieceAt(Color color, Piece piece, int square) {
   assert(piece != engine::NONE);
 
@@ -122,6 +295,7 @@ void Position::SetPieceAt(Color color, Piece piece, int square) {
   pieces |= bb;
 
   mailbox_[square] = piece;
+  AddScore(color, piece, square);
 
   UpdateInternals();
 }
@@ -137,6 +311,8 @@ void Position::UnsetPieceAt(int square) {
         pieces ^= bb;
         bb ^= bb;
         mailbox_[square] = engine::NONE;
+        RemoveScore(static_cast<Color>(color), static_cast<Piece>(piece),
+                    square);
 
         break;
       }
@@ -146,11 +322,12 @@ void Position::UnsetPieceAt(int square) {
   UpdateInternals();
 }
 
+template <enum Color side>
 void Position::Make(const Move &move) {
   history_.push(position::State::From(*this));
 
-  Color opp = OPP(turn_);
-  Bitboard &piece = board_.pieces[turn_][move.piece];
+  constexpr Color opp = OPP(side);
+  Bitboard &piece = board_.pieces[side][move.piece];
   Bitboard to = square::BB(move.to);
   Bitboard from = square::BB(move.from);
 
@@ -160,19 +337,24 @@ void Position::Make(const Move &move) {
   mailbox_[move.to] = move.piece;
 
   hash_ ^= kZobrist.color;
-  hash_ ^= HASH2(move.from, move.to, turn_, move.piece);
+  hash_ ^= HASH2(move.from, move.to, side, move.piece);
+
+  RemoveScore(side, move.piece, move.from);
+  AddScore(side, move.piece, move.to);
 
   if (move.Is(move::CAPTURE)) {
     Bitboard &piece = board_.pieces[opp][move.captured];
 
     piece ^= to;
     hash_ ^= HASH1(move.to, opp, move.captured);
+
+    RemoveScore(opp, move.captured, move.to);
   }
 
   if (move.piece == KING && move.Is(move::CASTLE_KING_SIDE)) [[unlikely]] {
     int king_square = square::Index(piece);
     Bitboard rank = square::RankMask(king_square);
-    Bitboard &rooks = board_.pieces[turn_][ROOK];
+    Bitboard &rooks = board_.pieces[side][ROOK];
     Bitboard rook = rooks & rank & kKingSide;
     Bitboard new_position = rook >> 2;
 
@@ -184,13 +366,16 @@ void Position::Make(const Move &move) {
     mailbox_[old_index] = NONE;
     mailbox_[new_index] = ROOK;
 
-    hash_ ^= HASH2(old_index, new_index, turn_, ROOK);
+    hash_ ^= HASH2(old_index, new_index, side, ROOK);
+
+    RemoveScore(side, ROOK, old_index);
+    AddScore(side, ROOK, new_index);
   }
 
   if (move.piece == KING && move.Is(move::CASTLE_QUEEN_SIDE)) [[unlikely]] {
     int king_square = square::Index(piece);
     Bitboard rank = square::RankMask(king_square);
-    Bitboard &rooks = board_.pieces[turn_][ROOK];
+    Bitboard &rooks = board_.pieces[side][ROOK];
     Bitboard rook = rooks & rank & kQueenSide;
     Bitboard new_position = rook << 3;
 
@@ -202,16 +387,20 @@ void Position::Make(const Move &move) {
     mailbox_[old_index] = NONE;
     mailbox_[new_index] = ROOK;
 
-    hash_ ^= HASH2(old_index, new_index, turn_, ROOK);
+    hash_ ^= HASH2(old_index, new_index, side, ROOK);
+
+    RemoveScore(side, ROOK, old_index);
+    AddScore(side, ROOK, new_index);
   }
 
-  auto [queen_side_rook, king_side_rook, queen_side_castling_flag,
-        king_side_castling_flag, single_push] =
-      turn_ == WHITE
-          ? std::make_tuple(a1, h1, position::CASTLE_W_QUEEN_SIDE,
-                            position::CASTLE_W_KING_SIDE, PushPawn<WHITE>)
-          : std::make_tuple(a8, h8, position::CASTLE_B_QUEEN_SIDE,
-                            position::CASTLE_B_KING_SIDE, PushPawn<BLACK>);
+  constexpr ESquare queen_side_rook = side == WHITE ? a1 : a8;
+  constexpr ESquare king_side_rook = side == WHITE ? h1 : h8;
+  constexpr Castling queen_side_castling_flag =
+      side == WHITE ? position::CASTLE_W_QUEEN_SIDE
+                    : position::CASTLE_B_QUEEN_SIDE;
+  constexpr Castling king_side_castling_flag =
+      side == WHITE ? position::CASTLE_W_KING_SIDE
+                    : position::CASTLE_B_KING_SIDE;
 
   {
     if ((move.piece == KING ||
@@ -226,7 +415,7 @@ void Position::Make(const Move &move) {
     if ((move.piece == KING ||
          (move.piece == ROOK && move.from == king_side_rook)) &&
         castling_rights_ & king_side_castling_flag) [[unlikely]] {
-      int index = square::Index(queen_side_castling_flag);
+      int index = square::Index(king_side_castling_flag);
 
       castling_rights_ ^= king_side_castling_flag;
       hash_ ^= kZobrist.castling_rights[index];
@@ -240,12 +429,13 @@ void Position::Make(const Move &move) {
     piece ^= en_passant_target_;
 
     mailbox_[index] = NONE;
-    hash_ ^=
-        HASH1(index, opp, PAWN) ^ kZobrist.en_passant_file[square::File(index)];
+    hash_ ^= HASH1(index, opp, PAWN);
+
+    RemoveScore(opp, PAWN, index);
   }
 
   if (move.Is(move::PROMOTION)) [[unlikely]] {
-    Bitboard &new_piece = board_.pieces[turn_][move.promoted];
+    Bitboard &new_piece = board_.pieces[side][move.promoted];
 
     // unset the old piece & set the index on the promoted piece
     piece ^= to;
@@ -254,8 +444,11 @@ void Position::Make(const Move &move) {
     mailbox_[move.to] = move.promoted;
 
     // INFO: unset the pawn move before the promotion.
-    hash_ ^= HASH1(move.to, turn_, move.piece);
-    hash_ ^= HASH1(move.to, turn_, move.promoted);
+    hash_ ^= HASH1(move.to, side, move.piece);
+    hash_ ^= HASH1(move.to, side, move.promoted);
+
+    RemoveScore(side, move.piece, move.to);
+    AddScore(side, move.promoted, move.to);
   }
 
   if (en_passant_sq_) {
@@ -272,7 +465,7 @@ void Position::Make(const Move &move) {
       ((from & kRank2) | (from & kRank7)) && ((to & kRank4) | (to & kRank5));
 
   if (move.piece == PAWN && is_double_push) {
-    en_passant_sq_ = single_push(from);
+    en_passant_sq_ = PushPawn<side>(from);
     int index = square::Index(en_passant_sq_);
     int file = square::File(index);
 
@@ -286,18 +479,35 @@ void Position::Make(const Move &move) {
     halfmove_clock_++;
   }
 
-  if (opp == WHITE) {
+  if constexpr (opp == WHITE) {
     fullmove_counter_++;
   }
 
-  UpdateInternals();
+  UpdateInternals<opp>();
+
+  if (!accumulators_.empty()) {
+    const Network *network = network::Current();
+
+    if (network == nullptr) {
+      accumulators_.clear();
+    } else {
+      accumulators_.emplace_back();
+      network->Update(&accumulators_.back(),
+                      accumulators_[accumulators_.size() - 2], board_);
+    }
+  }
 }
 
+void Position::Make(const Move &move) {
+  turn_ == WHITE ? Make<WHITE>(move) : Make<BLACK>(move);
+}
+
+template <enum Color side>
 void Position::Undo(const Move &move) {
   position::State::Apply(*this, history_.top());
 
-  Color opp = OPP(turn_);
-  Bitboard &piece = board_.pieces[opp][move.piece];
+  constexpr Color opp = OPP(side);
+  Bitboard &piece = board_.pieces[side][move.piece];
   Bitboard to = square::BB(move.to);
   Bitboard from = square::BB(move.from);
 
@@ -306,7 +516,7 @@ void Position::Undo(const Move &move) {
   mailbox_[move.from] = move.piece;
 
   if (move.Is(move::PROMOTION)) [[unlikely]] {
-    Bitboard &new_piece = board_.pieces[opp][move.promoted];
+    Bitboard &new_piece = board_.pieces[side][move.promoted];
 
     // reset the old piece & unset the promoted piece
     piece ^= to;
@@ -316,7 +526,7 @@ void Position::Undo(const Move &move) {
   }
 
   if (move.Is(move::CAPTURE)) {
-    PieceList &pieces = board_.pieces[turn_];
+    PieceList &pieces = board_.pieces[opp];
 
     pieces[move.captured] |= to;
 
@@ -326,7 +536,7 @@ void Position::Undo(const Move &move) {
   if (move.piece == KING && move.Is(move::CASTLE_KING_SIDE)) [[unlikely]] {
     int king_square = square::Index(piece);
     Bitboard rank = square::RankMask(king_square);
-    Bitboard &rooks = board_.pieces[opp][ROOK];
+    Bitboard &rooks = board_.pieces[side][ROOK];
     Bitboard rook = rooks & rank & kKingSide;
     Bitboard old_position = (rook << 2);
 
@@ -339,7 +549,7 @@ void Position::Undo(const Move &move) {
   if (move.piece == KING && move.Is(move::CASTLE_QUEEN_SIDE)) [[unlikely]] {
     int king_square = square::Index(piece);
     Bitboard rank = square::RankMask(king_square);
-    Bitboard &rooks = board_.pieces[opp][ROOK];
+    Bitboard &rooks = board_.pieces[side][ROOK];
     Bitboard rook = rooks & rank & kQueenSide;
     Bitboard old_position = (rook >> 3);
 
@@ -350,118 +560,181 @@ void Position::Undo(const Move &move) {
   }
 
   if (move.Is(move::EN_PASSANT)) [[unlikely]] {
-    PieceList &pieces = board_.pieces[turn_];
+    PieceList &pieces = board_.pieces[opp];
 
     pieces[PAWN] |= en_passant_target_;
 
     mailbox_[square::Index(en_passant_target_)] = PAWN;
   }
 
-  if (opp == BLACK) {
+  if constexpr (side == BLACK) {
     fullmove_counter_--;
   }
 
-  turn_ = opp;
+  turn_ = side;
+  attack_info_level_ = position::ATTACK_NONE;
 
   history_.pop();
+
+  if (!accumulators_.empty()) {
+    accumulators_.pop_back();
+  }
+}
+
+void Position::Undo(const Move &move) {
+  // INFO: the side to move is the opponent of the one that made the move
+  turn_ == WHITE ? Undo<BLACK>(move) : Undo<WHITE>(move);
 }
 
+void Position::UpdateInternals() {
+  // INFO: the board was edited by hand, the network refreshes on its next use
+  accumulators_.clear();
+
+  turn_ == WHITE ? UpdateInternals<WHITE>() : UpdateInternals<BLACK>();
+}
+
+template <enum Color side>
 void Position::UpdateInternals() {
   board_.UpdateOccupiedSqs();
 
-  UpdateKingBan();
-  UpdateEnPassantSq();
+  attack_info_level_ = position::ATTACK_NONE;
+
+  UpdateEnPassantSq<side>();
   UpdateMailbox();
 }
 
-void Position::UpdateKingBan() {
-  king_ban_ = kEmpty;
-  Color opp = OPP(turn_);
+void Position::AddScore(Color color, Piece piece, int square) {
+  Score score = kWeights[piece] + kPieceSquare.scores[color][piece][square];
 
-  Bitboard enemy_pawns = board_.pieces[opp][PAWN];
-  Bitboard enemy_bishop_queen =
-      board_.pieces[opp][BISHOP] | board_.pieces[opp][QUEEN];
-  Bitboard enemy_rook_queen =
-      board_.pieces[opp][ROOK] | board_.pieces[opp][QUEEN];
+  psq_ += color == WHITE ? score : -score;
+  phase_ += kPhaseWeights[piece];
+}
 
-  auto [pawn_east_targets, pawn_west_targets] =
-      turn_ == WHITE
-          ? std::make_pair(PawnTargets<BLACK, EAST>, PawnTargets<BLACK, WEST>)
-          : std::make_pair(PawnTargets<WHITE, EAST>, PawnTargets<WHITE, WEST>);
-
-  king_ban_ |=
-      (KING_ATTACKS(board_.pieces[opp][KING])) |
-      (KNIGHT_ATTACKS(board_.pieces[opp][KNIGHT])) |
-      (BISHOP_ATTACKS(enemy_bishop_queen,
-                      ~board_.occupied_sqs | board_.pieces[turn_][KING])) |
-      (ROOK_ATTACKS(enemy_rook_queen,
-                    ~board_.occupied_sqs | board_.pieces[turn_][KING])) |
-      pawn_east_targets(enemy_pawns) | pawn_west_targets(enemy_pawns);
+void Position::RemoveScore(Color color, Piece piece, int square) {
+  Score score = kWeights[piece] + kPieceSquare.scores[color][piece][square];
+
+  psq_ -= color == WHITE ? score : -score;
+  phase_ -= kPhaseWeights[piece];
 }
 
+template <enum Color side>
 void Position::UpdateEnPassantSq() {
   en_passant_target_ = (PushPawn<WHITE>(en_passant_sq_) & kRank4) |
                        (PushPawn<BLACK>(en_passant_sq_) & kRank5);
 
-  Color opp = OPP(turn_);
+  constexpr Color opp = OPP(side);
   Bitboard enemy_rook_queen =
       board_.pieces[opp][ROOK] | board_.pieces[opp][QUEEN];
 
-  Bitboard pawns = board_.pieces[turn_][PAWN];
-  Bitboard king = board_.pieces[turn_][KING];
+  Bitboard pawns = board_.pieces[side][PAWN];
+  Bitboard king = board_.pieces[side][KING];
   int ep_sq = square::Index(en_passant_target_);
   Bitboard ep_rank = square::RankMask(ep_sq);
   int king_sq = square::Index(king);
 
   if (en_passant_target_ && (ep_rank & king) && (ep_rank & enemy_rook_queen) &&
       (ep_rank & pawns)) {
-    auto [pawn_west_targets, pawn_east_targets] =
-        turn_ == WHITE
-            ? std::make_pair(PawnTargets<BLACK, WEST>, PawnTargets<BLACK, EAST>)
-            : std::make_pair(PawnTargets<WHITE, WEST>,
-                             PawnTargets<WHITE, EAST>);
-
-    Bitboard west_targets = pawn_west_targets(en_passant_sq_) & pawns;
-    Bitboard east_targets = pawn_east_targets(en_passant_sq_) & pawns;
+    Bitboard west_targets = PawnTargets<opp, WEST>(en_passant_sq_) & pawns;
+    Bitboard east_targets = PawnTargets<opp, EAST>(en_passant_sq_) & pawns;
+    bool exposes_king = false;
 
     if (west_targets) {
       Bitboard occupied_sqs_after_ep =
           board_.occupied_sqs & ~(en_passant_target_ | west_targets);
 
-      if (kSlidingAttacks.Rook(occupied_sqs_after_ep, king_sq) &
-          enemy_rook_queen) {
-        en_passant_sq_ = kEmpty;
-      }
+      exposes_king |= (kSlidingAttacks.Rook(occupied_sqs_after_ep, king_sq) &
+                       enemy_rook_queen) != kEmpty;
     }
 
     if (east_targets) {
       Bitboard occupied_sqs_after_ep =
           board_.occupied_sqs & ~(en_passant_target_ | east_targets);
 
-      if (kSlidingAttacks.Rook(occupied_sqs_after_ep, king_sq) &
-          enemy_rook_queen) {
-        en_passant_sq_ = kEmpty;
-      }
+      exposes_king |= (kSlidingAttacks.Rook(occupied_sqs_after_ep, king_sq) &
+                       enemy_rook_queen) != kEmpty;
+    }
+
+    // INFO: the en passant file was hashed when the square got set, it has to
+    // be removed as well so transpositions hash the same.
+    if (exposes_king) {
+      hash_ ^= kZobrist.en_passant_file[square::File(square::Index(
+          en_passant_sq_))];
+      en_passant_sq_ = kEmpty;
     }
   }
 }
 
-void Position::UpdateMailbox() {
-  for (int i = 0; i < 64; i++) {
-    Bitboard bb = square::BB(i);
+template <enum Color side>
+const position::AttackInfo &Position::Masks() const {
+  if (attack_info_level_ >= position::ATTACK_MASKS) {
+    return attack_info_;
+  }
+
+  constexpr Color opp = OPP(side);
+  const PieceList &enemy = board_.pieces[opp];
+  Bitboard king = board_.pieces[side][KING];
+  auto [pin_hv_mask, pin_diag_mask] = PinMask<side>(*this);
+
+  attack_info_.checkers = Checkers<side>(*this);
+  attack_info_.check_mask =
+      CheckMask(attack_info_.checkers, square::Index(king));
+  attack_info_.pin_hv_mask = pin_hv_mask;
+  attack_info_.pin_diag_mask = pin_diag_mask;
+
+  // INFO: the king doesn't block the sliders, it can't step back along the
+  // checking ray.
+  attack_info_.king_ban =
+      (KING_ATTACKS(enemy[KING])) | (KNIGHT_ATTACKS(enemy[KNIGHT])) |
+      SliderAttacks(enemy[ROOK] | enemy[QUEEN], enemy[BISHOP] | enemy[QUEEN],
+                    ~board_.occupied_sqs | king) |
+      PawnTargets<opp>(enemy[PAWN]);
+
+  attack_info_level_ = position::ATTACK_MASKS;
 
-    if (bb & board_.occupied_sqs) {
-      for (int j = 0; j < PIECES; j++) {
-        Piece piece = static_cast<Piece>(j);
+  return attack_info_;
+}
+
+template <enum Color side>
+const position::AttackInfo &Position::Attacks() const {
+  if (attack_info_level_ >= position::ATTACK_MAPS) {
+    return attack_info_;
+  }
+
+  Masks<side>();
+  position::AttackMaps(board_, &attack_info_);
 
-        if ((board_.pieces[WHITE][j] & bb) | (board_.pieces[BLACK][j] & bb)) {
-          mailbox_[i] = piece;
-        }
+  attack_info_level_ = position::ATTACK_MAPS;
+
+  return attack_info_;
+}
+
+const position::AttackInfo &Position::Masks() const {
+  return turn_ == WHITE ? Masks<WHITE>() : Masks<BLACK>();
+}
+
+const position::AttackInfo &Position::Attacks() const {
+  return turn_ == WHITE ? Attacks<WHITE>() : Attacks<BLACK>();
+}
+
+void Position::UpdateMailbox() {
+  mailbox_.fill(NONE);
+
+  for (Color color : {WHITE, BLACK}) {
+    for (int i = 0; i < PIECES; i++) {
+      BITLOOP(board_.pieces[color][i]) {
+        mailbox_[LOOP_INDEX] = static_cast<Piece>(i);
       }
-    } else {
-      mailbox_[i] = NONE;
     }
   }
 }
 
+template void Position::Make<WHITE>(const Move &move);
+template void Position::Make<BLACK>(const Move &move);
+template void Position::Undo<WHITE>(const Move &move);
+template void Position::Undo<BLACK>(const Move &move);
+template const position::AttackInfo &Position::Masks<WHITE>() const;
+template const position::AttackInfo &Position::Masks<BLACK>() const;
+template const position::AttackInfo &Position::Attacks<WHITE>() const;
+template const position::AttackInfo &Position::Attacks<BLACK>() const;
+
 }  // namespace engine
@@ -3,7 +3,10 @@
 
 #include <gtest/gtest.h>
 
+#include "engine/evaluation.hpp"
+#include "engine/move_gen.hpp"
 #include "engine/position.hpp"
+#include "engine/transposition.hpp"
 #include "engine/types.hpp"
 #include "engine/utils.hpp"
 
@@ -167,3 +170,110 @@ TEST(PositionTestSuite, TestPiecePlacementMethods) {
 
   ASSERT_EQ(position.ToFen(), "8/8/8/8/8/8/8/8 w - - 0 1");
 }
+
+TEST(PositionTestSuite, TestApplyPlacementMatchesFen) {
+  TT tt(1 << 16);
+  TTEntry entry;
+
+  for (const char *fen :
+       {kStartPos,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b Kq - 0 1",
+        "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 1"}) {
+    Position expected = Position::FromFen(fen);
+    Position position;
+    position::Placement placement;
+
+    for (Color color : {WHITE, BLACK}) {
+      placement.pieces[color] = expected.Pieces(color);
+    }
+
+    placement.turn = expected.Turn();
+    placement.en_passant_sq = expected.EnPassantSquare();
+
+    for (Castling flag :
+         {position::CASTLE_W_KING_SIDE, position::CASTLE_W_QUEEN_SIDE,
+          position::CASTLE_B_KING_SIDE, position::CASTLE_B_QUEEN_SIDE}) {
+      placement.castling_rights |= expected.CanCastle(flag) ? flag : 0;
+    }
+
+    ASSERT_TRUE(Position::ApplyPlacement(&position, placement));
+    ASSERT_EQ(position.ToFen(), fen);
+    ASSERT_EQ(position.LegalMoves().size(), expected.LegalMoves().size());
+    ASSERT_EQ(Evaluate(position), Evaluate(expected));
+
+    // both hash the same
+    tt.Add(position, 1, 0, Move(), NodeType::PV);
+
+    ASSERT_TRUE(tt.Probe(expected, &entry));
+  }
+}
+
+TEST(PositionTestSuite, TestApplyPlacementValidates) {
+  position::Placement placement;
+
+  ASSERT_TRUE(placement.Add(WHITE, KING, e1));
+  ASSERT_TRUE(placement.Add(WHITE, ROOK, a2));
+  ASSERT_TRUE(placement.Add(BLACK, KING, e8));
+  ASSERT_FALSE(placement.Add(BLACK, ROOK, a2));
+  ASSERT_TRUE(placement.Valid());
+
+  Position position = Position::FromFen(kStartPos);
+
+  auto rejects = [&](auto edit) {
+    position::Placement invalid = placement;
+
+    edit(invalid);
+
+    return !invalid.Valid() &&
+           !Position::ApplyPlacement(&position, invalid) &&
+           position.ToFen() == kStartPos;
+  };
+
+  ASSERT_TRUE(rejects([](auto &p) { p.pieces[BLACK][KING] = kEmpty; }));
+  ASSERT_TRUE(rejects([](auto &p) { p.Add(WHITE, KING, h1); }));
+  ASSERT_TRUE(rejects([](auto &p) { p.Add(BLACK, PAWN, c1); }));
+  ASSERT_TRUE(rejects([](auto &p) { p.pieces[BLACK][ROOK] |= 1ULL << a2; }));
+  // black is in check with white to move
+  ASSERT_TRUE(rejects([](auto &p) { p.Add(WHITE, QUEEN, e4); }));
+  ASSERT_TRUE(rejects([](auto &p) {
+    p.pieces[BLACK][KING] = 1ULL << e2;
+    p.turn = BLACK;
+  }));
+  ASSERT_TRUE(rejects([](auto &p) {
+    p.castling_rights = position::CASTLE_W_QUEEN_SIDE;
+  }));
+  ASSERT_TRUE(rejects([](auto &p) { p.en_passant_sq = 1ULL << d6; }));
+
+  placement.Add(WHITE, ROOK, a1);
+  placement.Add(BLACK, PAWN, d5);
+  placement.castling_rights = position::CASTLE_W_QUEEN_SIDE;
+  placement.en_passant_sq = 1ULL << d6;
+
+  ASSERT_TRUE(Position::ApplyPlacement(&position, placement));
+  ASSERT_EQ(position.ToFen(), "4k3/8/8/3p4/8/8/R7/R3K3 w Q d6 0 1");
+}
+
+TEST(PositionTestSuite, TestCachedAttackInfo) {
+  Position position = Position::FromFen("4k3/8/8/1b6/8/8/3P4/4K2r w - - 0 1");
+  auto [pin_hv_mask, pin_diag_mask] = PinMask(position);
+
+  const position::AttackInfo &masks = position.Masks();
+
+  ASSERT_EQ(masks.check_mask, CheckMask(position));
+  ASSERT_EQ(masks.pin_hv_mask, pin_hv_mask);
+  ASSERT_EQ(masks.pin_diag_mask, pin_diag_mask);
+  ASSERT_TRUE(masks.king_ban & Bitboard(1) << f1);
+
+  const position::AttackInfo &maps = position.Attacks();
+
+  ASSERT_EQ(&maps, &masks);
+  ASSERT_TRUE(maps.piece_attacks[BLACK][ROOK] & Bitboard(1) << e1);
+  ASSERT_TRUE(maps.attacks[BLACK] & Bitboard(1) << d3);
+
+  Move move(e1, f2, KING);
+
+  position.Make(move);
+
+  ASSERT_EQ(position.Masks().check_mask, CheckMask(position));
+  ASSERT_EQ(position.Masks().checkers, kEmpty);
+}
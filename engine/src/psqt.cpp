@@ -0,0 +1,127 @@
+#include "engine/psqt.hpp"
+#include "engine/score.hpp"
+#include "engine/types.hpp"
+
+namespace engine {
+
+using Table = int[64];
+
+// INFO: tables are laid out as seen from white, a8 first & h1 last.
+static constexpr Table kRookTable = {
+    0,  0, 0, 0, 0, 0, 0, 0,   //
+    2,  5, 5, 5, 5, 5, 5, 2,   //
+    -2, 0, 0, 0, 0, 0, 0, -2,  //
+    -2, 0, 0, 0, 0, 0, 0, -2,  //
+    -2, 0, 0, 0, 0, 0, 0, -2,  //
+    -2, 0, 0, 0, 0, 0, 0, -2,  //
+    -2, 0, 0, 0, 0, 0, 0, -2,  //
+    0,  0, 0, 2, 2, 0, 0, 0,   //
+};
+
+static constexpr Table kBishopTable = {
+    -10, -5, -5, -5, -5, -5, -5, -10,  //
+    -5,  0,  0,  0,  0,  0,  0,  -5,   //
+    -5,  0,  2,  5,  5,  2,  0,  -5,   //
+    -5,  2,  2,  5,  5,  2,  2,  -5,   //
+    -5,  0,  5,  5,  5,  5,  0,  -5,   //
+    -5,  5,  5,  5,  5,  5,  5,  -5,   //
+    -5,  2,  0,  0,  0,  0,  2,  -5,   //
+    -10, -5, -5, -5, -5, -5, -5, -10,  //
+};
+
+static constexpr Table kKnightTable = {
+    -25, -20, -15, -15, -15, -15, -20, -25,  //
+    -20, -10, 0,   0,   0,   0,   -10, -20,  //
+    -15, 0,   5,   8,   8,   5,   0,   -15,  //
+    -15, 2,   8,   10,  10,  8,   2,   -15,  //
+    -15, 0,   8,   10,  10,  8,   0,   -15,  //
+    -15, 2,   5,   8,   8,   5,   2,   -15,  //
+    -20, -10, 0,   2,   2,   0,   -10, -20,  //
+    -25, -20, -15, -15, -15, -15, -20, -25,  //
+};
+
+static constexpr Table kKingOpeningTable = {
+    -15, -20, -20, -25, -25, -20, -20, -15,  //
+    -15, -20, -20, -25, -25, -20, -20, -15,  //
+    -15, -20, -20, -25, -25, -20, -20, -15,  //
+    -15, -20, -20, -25, -25, -20, -20, -15,  //
+    -10, -15, -15, -20, -20, -15, -15, -10,  //
+    -5,  -10, -10, -10, -10, -10, -10, -5,   //
+    10,  10,  0,   0,   0,   0,   10,  10,   //
+    10,  15,  5,   0,   0,   5,   15,  10,   //
+};
+
+static constexpr Table kKingEndgameTable = {
+    -25, -20, -15, -10, -10, -15, -20, -25,  //
+    -15, -10, -5,  0,   0,   -5,  -10, -15,  //
+    -15, -5,  10,  15,  15,  10,  -5,  -15,  //
+    -15, -5,  15,  20,  20,  15,  -5,  -15,  //
+    -15, -5,  15,  20,  20,  15,  -5,  -15,  //
+    -15, -5,  10,  15,  15,  10,  -5,  -15,  //
+    -15, -15, 0,   0,   0,   0,   -15, -15,  //
+    -25, -15, -15, -15, -15, -15, -15, -25,  //
+};
+
+static constexpr Table kQueenTable = {
+    -10, -5, -5, -2, -2, -5, -5, -10,  //
+    -5,  0,  0,  0,  0,  0,  0,  -5,   //
+    -5,  0,  2,  2,  2,  2,  0,  -5,   //
+    -2,  0,  2,  2,  2,  2,  0,  -2,   //
+    -2,  0,  2,  2,  2,  2,  0,  -2,   //
+    -5,  0,  2,  2,  2,  2,  0,  -5,   //
+    -5,  0,  0,  0,  0,  0,  0,  -5,   //
+    -10, -5, -5, -2, -2, -5, -5, -10,  //
+};
+
+static constexpr Table kPawnOpeningTable = {
+    0,  0,  0,  0,   0,   0,  0,  0,   //
+    10, 10, 10, 10,  10,  10, 10, 10,  //
+    4,  4,  6,  10,  10,  6,  4,  4,   //
+    2,  2,  4,  12,  12,  4,  2,  2,   //
+    0,  0,  2,  10,  10,  2,  0,  0,   //
+    2,  -2, -4, 0,   0,   -4, -2, 2,   //
+    2,  4,  4,  -10, -10, 4,  4,  2,   //
+    0,  0,  0,  0,   0,   0,  0,  0,   //
+};
+
+static constexpr Table kPawnEndgameTable = {
+    0,  0,  0,  0,  0,  0,  0,  0,   //
+    20, 20, 20, 20, 20, 20, 20, 20,  //
+    12, 12, 12, 12, 12, 12, 12, 12,  //
+    6,  6,  6,  6,  6,  6,  6,  6,   //
+    2,  2,  2,  2,  2,  2,  2,  2,   //
+    0,  0,  0,  0,  0,  0,  0,  0,   //
+    0,  0,  0,  0,  0,  0,  0,  0,   //
+    0,  0,  0,  0,  0,  0,  0,  0,   //
+};
+
+// INFO: same order as `enum Piece`
+static constexpr const int *kTables[PIECES][2] = {
+    {kRookTable, kRookTable},
+    {kBishopTable, kBishopTable},
+    {kKnightTable, kKnightTable},
+    {kKingOpeningTable, kKingEndgameTable},
+    {kQueenTable, kQueenTable},
+    {kPawnOpeningTable, kPawnEndgameTable}};
+
+consteval PieceSquare InitPieceSquare() {
+  PieceSquare psqt{};
+
+  for (int piece = 0; piece < PIECES; piece++) {
+    const int *opening = kTables[piece][0];
+    const int *endgame = kTables[piece][1];
+
+    for (int sq = 0; sq < 64; sq++) {
+      // a1 is the first square, flip the rank to read a table as white
+      psqt.scores[WHITE][piece][sq] =
+          MakeScore(opening[sq ^ 56], endgame[sq ^ 56]);
+      psqt.scores[BLACK][piece][sq] = MakeScore(opening[sq], endgame[sq]);
+    }
+  }
+
+  return psqt;
+}
+
+const PieceSquare kPieceSquare = InitPieceSquare();
+
+}  // namespace engine
@@ -1,234 +1,313 @@
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <mutex>
+#include <new>
 #include <thread>
+#include <vector>
 
+#include "engine/affinity.hpp"
 #include "engine/scheduler.hpp"
-
-using namespace std::chrono_literals;
+#include "engine/types.hpp"
 
 namespace engine {
 
-int Worker::ID = 1;
+// INFO: lets Dispatch & Wait know whether they run on one of the workers, jobs
+// dispatched by a worker go to its own deque.
+static thread_local Scheduler *current_scheduler = nullptr;
+static thread_local int current_index = -1;
+static thread_local std::uint32_t victim_seed = 0x9e3779b9;
 
-Scheduler::Scheduler() : Scheduler(std::thread::hardware_concurrency()) {}
+struct StatusPool {
+  std::vector<void *> blocks;
+
+  ~StatusPool() {
+    for (void *block : blocks) {
+      ::operator delete(block);
+    }
+  }
+};
 
-Scheduler::Scheduler(int workers)
-    : size_(workers), ready_(false), stopped_(false), workers_(size_) {}
+static thread_local StatusPool status_pool;
 
-void Scheduler::Init() {
-  std::unique_lock lock(mutex_);
+void *Status::operator new(std::size_t size) {
+  std::vector<void *> &blocks = status_pool.blocks;
 
-  for (Worker &worker : workers_) {
-    worker.Init(this);
+  if (blocks.empty()) {
+    return ::operator new(size);
   }
 
-  thread_ = std::thread(&Scheduler::Monitor, this);
+  void *block = blocks.back();
 
-  cv_.wait(lock, [this] { return ready_; });
-  lock.unlock();
+  blocks.pop_back();
+
+  return block;
 }
 
-void Scheduler::Monitor() {
-  std::unique_lock lock(mutex_);
+void Status::operator delete(void *ptr) {
+  std::vector<void *> &blocks = status_pool.blocks;
 
-  ready_ = true;
+  if (blocks.size() >= SCHEDULER_STATUS_POOL_SIZE) {
+    ::operator delete(ptr);
+    return;
+  }
 
-  lock.unlock();
-  cv_.notify_all();
+  blocks.push_back(ptr);
+}
 
-  while (true) {
-    lock.lock();
+void Status::Execute() {
+  callback_();
 
-    if (stopped_) {
-      lock.unlock();
-      break;
-    }
+  scheduler_->active_.fetch_sub(1, std::memory_order_relaxed);
 
-    cv_.wait(lock, [this] { return !free_.empty() || stopped_; });
+  done_.store(true, std::memory_order_release);
+  done_.notify_all();
 
-    while (!free_.empty()) {
-      Worker *worker = free_.front();
+  // INFO: the waiter may delete the status once it sees this flag, nothing
+  // can touch it afterwards.
+  released_.store(true, std::memory_order_release);
+}
 
-      free_.pop();
+void Status::Wait() {
+  int index = current_scheduler == scheduler_ ? current_index : -1;
 
-      if (pending_.empty()) {
-        busy_.erase(worker->id_);
-        continue;
-      }
+  // help with pending jobs instead of blocking, the job waited on might be
+  // one of them.
+  while (!done_.load(std::memory_order_acquire)) {
+    Status *status = scheduler_->FindJob(index);
 
-      Job *job = pending_.front();
+    if (status != nullptr) {
+      status->Execute();
+      continue;
+    }
 
-      pending_.pop();
-      worker->Run(job);
+    if (scheduler_->pending_.load() > 0) {
+      std::this_thread::yield();
+      continue;
     }
 
-    lock.unlock();
-    cv_.notify_all();
+    // nothing is queued, so the job is running on another thread
+    done_.wait(false, std::memory_order_acquire);
   }
-}
 
-void Scheduler::Stop() {
-  std::unique_lock lock(mutex_);
-
-  if (stopped_) {
-    lock.unlock();
-    return;
+  while (!released_.load(std::memory_order_acquire)) {
+    std::this_thread::yield();
   }
+}
 
-  // INFO: unlock the mutex so that any busy worker can call the scheduler
-  // without leading to a deadlock
-  lock.unlock();
+bool Worker::Push(Status *status) {
+  std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+  std::int64_t top = top_.load(std::memory_order_acquire);
 
-  for (Worker &worker : workers_) {
-    worker.Stop();
+  if (bottom - top >= SCHEDULER_DEQUE_SIZE) {
+    return false;
   }
 
-  lock.lock();
+  buffer_[bottom & (SCHEDULER_DEQUE_SIZE - 1)].store(status,
+                                                     std::memory_order_relaxed);
 
-  stopped_ = true;
+  std::atomic_thread_fence(std::memory_order_release);
+  bottom_.store(bottom + 1, std::memory_order_relaxed);
 
-  lock.unlock();
-  cv_.notify_all();
-  thread_.join();
+  return true;
 }
 
-void Scheduler::MakeAvailable(Worker *worker) {
-  std::unique_lock lock(mutex_);
+Status *Worker::Take() {
+  std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
 
-  free_.push(worker);
+  bottom_.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
 
-  lock.unlock();
-  cv_.notify_all();
-}
-
-std::size_t Scheduler::Busy() {
-  std::unique_lock lock(mutex_);
+  std::int64_t top = top_.load(std::memory_order_relaxed);
 
-  std::size_t size = busy_.size();
+  if (top > bottom) {
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
 
-  lock.unlock();
+  Status *status = buffer_[bottom & (SCHEDULER_DEQUE_SIZE - 1)].load(
+      std::memory_order_relaxed);
 
-  return size;
-}
+  if (top == bottom) {
+    // last job, race the thieves for it
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      status = nullptr;
+    }
 
-Status *Scheduler::Dispatch(Callback callback) {
-  // NOTE: random selection or even distribution?!
-  // TODO: lock worker to confirm actual state. instead of find, maybe push to
-  // another container
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
 
-  std::unique_lock lock(mutex_);
+  return status;
+}
 
-  auto it = std::find_if(workers_.begin(), workers_.end(), [&](Worker &worker) {
-    return !worker.stopped_ && !busy_.contains(worker.id_);
-  });
+Status *Worker::Steal() {
+  std::int64_t top = top_.load(std::memory_order_acquire);
 
-  Status *status = new Status(callback);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
 
-  if (it != workers_.end()) {
-    Worker *worker = &(*it);
+  std::int64_t bottom = bottom_.load(std::memory_order_acquire);
 
-    busy_.insert(worker->id_);
-    lock.unlock();
+  if (top >= bottom) {
+    return nullptr;
+  }
 
-    it->Run(&status->job_);
+  Status *status =
+      buffer_[top & (SCHEDULER_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
 
-    return status;
+  if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed)) {
+    return nullptr;
   }
 
-  pending_.push(&status->job_);
-  lock.unlock();
-  cv_.notify_all();
-
   return status;
 }
 
-void Status::Wait() {
-  while (!job_.done_) {
-    Worker *worker = job_.worker_;
+Scheduler::Scheduler() : Scheduler(std::thread::hardware_concurrency()) {}
 
-    if (worker == nullptr) {
-      continue;
-    }
+Scheduler::Scheduler(int workers, Affinity affinity)
+    : size_(std::max(workers, 1)),
+      ready_(false),
+      affinity_(affinity),
+      stopped_(false),
+      workers_(size_),
+      pending_(0),
+      active_(0),
+      sleeping_(0) {}
 
-    std::unique_lock lock(worker->mutex_);
+void Scheduler::Init() {
+  if (ready_) {
+    return;
+  }
 
-    worker->cv_.wait(lock, [this] { return job_.done_; });
-    lock.unlock();
+  for (int i = 0; i < size_; i++) {
+    workers_[i].thread_ = std::thread(&Scheduler::Loop, this, i);
   }
+
+  ready_ = true;
 }
 
-void Worker::Init(Scheduler *scheduler) {
+void Scheduler::Stop() {
   std::unique_lock lock(mutex_);
 
-  scheduler_ = scheduler;
-  thread_ = std::thread(&Worker::Wait, this);
+  stopped_ = true;
 
-  // wait for the ready signal
-  cv_.wait(lock, [this] { return ready_; });
   lock.unlock();
+  cv_.notify_all();
+
+  for (Worker &worker : workers_) {
+    if (worker.thread_.joinable()) {
+      worker.thread_.join();
+    }
+  }
 }
 
-void Worker::Stop() {
-  std::unique_lock lock(mutex_);
+std::size_t Scheduler::Busy() {
+  std::int64_t active = active_.load(std::memory_order_relaxed);
+
+  return std::min<std::size_t>(std::max<std::int64_t>(active, 0), size_);
+}
+
+void Scheduler::Submit(Status *status) {
+  active_.fetch_add(1, std::memory_order_relaxed);
+
+  // INFO: counted before it's visible so that pending_ never understates the
+  // queued jobs.
+  pending_.fetch_add(1);
+
+  if (current_scheduler == this && workers_[current_index].Push(status)) {
+    if (sleeping_.load() > 0) {
+      std::lock_guard lock(mutex_);
+      cv_.notify_one();
+    }
 
-  if (stopped_) {
-    lock.unlock();
     return;
   }
 
-  // set this to true so that so that the thread can stop running
-  stopped_ = true;
+  std::unique_lock lock(mutex_);
+
+  injected_.push_back(status);
 
   lock.unlock();
-  cv_.notify_all();
-  thread_.join();
+  cv_.notify_one();
 }
 
-void Worker::Wait() {
-  std::unique_lock lock(mutex_);
+Status *Scheduler::FindJob(int index) {
+  Status *status = nullptr;
 
-  ready_ = true;
+  if (index >= 0) {
+    status = workers_[index].Take();
+  }
 
-  lock.unlock();
-  cv_.notify_all();
+  if (status == nullptr && pending_.load(std::memory_order_relaxed) > 0) {
+    std::unique_lock lock(mutex_);
 
-  while (true) {
-    lock.lock();
-
-    if (stopped_) {
-      lock.unlock();
-      break;
+    if (!injected_.empty()) {
+      status = injected_.front();
+      injected_.pop_front();
     }
+  }
 
-    cv_.wait(lock, [this] { return job_ != nullptr || stopped_; });
+  if (status == nullptr) {
+    victim_seed ^= victim_seed << 13;
+    victim_seed ^= victim_seed >> 17;
+    victim_seed ^= victim_seed << 5;
 
-    if (job_ != nullptr) {
-      job_->Execute();
+    int start = victim_seed % size_;
 
-      job_ = nullptr;
+    for (int i = 0; status == nullptr && i < size_; i++) {
+      int victim = (start + i) % size_;
 
-      // there is no need telling the scheduler it's free if it's asked to stop
-      // after its last job
-      if (!stopped_) {
-        scheduler_->MakeAvailable(this);
+      if (victim != index) {
+        status = workers_[victim].Steal();
       }
     }
+  }
 
-    lock.unlock();
-    cv_.notify_all();
+  if (status != nullptr) {
+    pending_.fetch_sub(1);
   }
+
+  return status;
 }
 
-void Worker::Run(Job *job) {
-  std::unique_lock lock(mutex_);
+void Scheduler::Loop(int index) {
+  if (affinity_ != Affinity::NONE) {
+    affinity::Pin(index, affinity_);
+  }
 
-  job_ = job;
-  job_->worker_ = this;
+  current_scheduler = this;
+  current_index = index;
+  victim_seed += index;
 
-  lock.unlock();
-  cv_.notify_all();
+  while (true) {
+    Status *status = FindJob(index);
+
+    if (status != nullptr) {
+      status->Execute();
+      continue;
+    }
+
+    if (pending_.load() > 0) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock lock(mutex_);
+
+    if (stopped_ && pending_.load() <= 0) {
+      break;
+    }
+
+    sleeping_.fetch_add(1);
+    cv_.wait(lock, [this] { return pending_.load() > 0 || stopped_; });
+    sleeping_.fetch_sub(1);
+  }
+
+  current_scheduler = nullptr;
+  current_index = -1;
 }
 
 }  // namespace engine
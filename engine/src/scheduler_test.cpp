@@ -1,11 +1,16 @@
+#include <atomic>
 #include <cstddef>
 #include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "engine/affinity.hpp"
 #include "engine/scheduler.hpp"
+#include "engine/types.hpp"
 
 using namespace engine;
 using namespace std::chrono_literals;
@@ -75,3 +80,74 @@ TEST_F(SchedulerTestSuite, OutOfWorkers) {
 
   delete status;
 }
+
+TEST_F(SchedulerTestSuite, NestedDispatch) {
+  std::atomic<int> count = 0;
+  std::vector<Status *> jobs;
+
+  for (int i = 0; i < 100; i++) {
+    jobs.push_back(scheduler_.Dispatch([&] {
+      Status *status = scheduler_.Dispatch([&] { count++; });
+
+      status->Wait();
+      delete status;
+
+      count++;
+    }));
+  }
+
+  for (Status *status : jobs) {
+    status->Wait();
+    delete status;
+  }
+
+  ASSERT_EQ(count, 200);
+  ASSERT_EQ(scheduler_.Busy(), 0);
+}
+
+TEST_F(SchedulerTestSuite, ParallelFor) {
+  std::vector<int> values(10000, 0);
+
+  scheduler_.ParallelFor(0, values.size(),
+                         [&](std::size_t i) { values[i] = i * 2; });
+
+  for (std::size_t i = 0; i < values.size(); i++) {
+    ASSERT_EQ(values[i], i * 2);
+  }
+}
+
+TEST(SchedulerAffinityTestSuite, PinnedWorkers) {
+  std::atomic<int> count = 0;
+  Scheduler scheduler(4, Affinity::SPREAD);
+
+  scheduler.Init();
+  scheduler.ParallelFor(0, 100, [&](std::size_t) { count++; });
+
+  ASSERT_EQ(count, 100);
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_GE(affinity::Place(i, Affinity::COMPACT).cpu, 0);
+    ASSERT_GE(affinity::Place(i, Affinity::SPREAD).node, 0);
+  }
+}
+
+TEST(SchedulerAffinityTestSuite, SparseNodeIds) {
+  std::filesystem::path root =
+      std::filesystem::path(testing::TempDir()) / "sparse_nodes";
+
+  // INFO: node 1 has memory only and node 2 is missing
+  std::filesystem::create_directories(root / "node0");
+  std::filesystem::create_directories(root / "node1");
+  std::filesystem::create_directories(root / "node3");
+  std::ofstream(root / "online") << "0-1,3\n";
+  std::ofstream(root / "node0" / "cpulist") << "0-1023\n";
+  std::ofstream(root / "node1" / "cpulist") << "\n";
+  std::ofstream(root / "node3" / "cpulist") << "0-1023\n";
+
+  affinity::Topology topology = affinity::Topology::Read(root.string());
+
+  std::filesystem::remove_all(root);
+
+  ASSERT_THAT(topology.ids, testing::ElementsAre(0, 3));
+  ASSERT_EQ(topology.nodes.size(), topology.ids.size());
+}
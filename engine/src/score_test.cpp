@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include "engine/score.hpp"
+
+using namespace engine;
+
+TEST(ScoreTestSuite, PackedArithmetic) {
+  int values[] = {-32000, -975, -1, 0, 1, 90, 2000, 32000};
+
+  for (int opening : values) {
+    for (int endgame : values) {
+      Score score = MakeScore(opening, endgame);
+
+      ASSERT_EQ(OpeningValue(score), opening);
+      ASSERT_EQ(EndgameValue(score), endgame);
+    }
+  }
+
+  Score score = MakeScore(-10, 20) * 3 - MakeScore(5, -40);
+
+  ASSERT_EQ(OpeningValue(score), -35);
+  ASSERT_EQ(EndgameValue(score), 100);
+  ASSERT_EQ(OpeningValue(-score), 35);
+  ASSERT_EQ(EndgameValue(-score), -100);
+}
+
+TEST(ScoreTestSuite, Taper) {
+  Score score = MakeScore(100, -60);
+
+  ASSERT_EQ(Taper(score, 0), 100);
+  ASSERT_EQ(Taper(score, 256), -60);
+  ASSERT_EQ(Taper(score, 128), 20);
+}
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdio>
@@ -8,18 +9,25 @@
 #include "engine/move.hpp"
 #include "engine/move_gen.hpp"
 #include "engine/search.hpp"
+#include "engine/syzygy.hpp"
+#include "engine/threads.hpp"
 #include "engine/types.hpp"
 
 namespace engine {
 
+LockSite Search::lock_site_("search children");
+
 Search::Search(search::WorkerRegistry *workers)
     : tt(nullptr),
       position(nullptr),
       state(search::State::END),
       allow_node_splitting(false),
+      max_depth(MAX_DEPTH),
       workers(workers),
+      stop(nullptr),
       depth_(0),
       height_(0),
+      completed_depth_(0),
       parent_(nullptr),
       master_(this) {}
 
@@ -29,7 +37,9 @@ void Search::Clone(Search *master) {
   tt = master->tt;
   *position = *master->position;
   allow_node_splitting = master->allow_node_splitting;
+  max_depth = master->max_depth;
   workers = master->workers;
+  stop = master->stop;
 
   depth_ = master->depth_;
   height_ = master->height_;
@@ -64,24 +74,62 @@ void Search::RemoveChild(Search *child) {
   spin_.Unlock();
 }
 
-void Search::Run() {
-  int score;
+int Search::Run() {
+  int score = 0;
+  int wdl;
   state = search::State::RUNNING;
+  completed_depth_ = 0;
+  best_move_ = Move();
+
+  // INFO: the counters are global, start every report from a clean slate
+#ifdef LOCK_STATS
+  if (parent_ == nullptr) {
+    LockSite::Reset();
+  }
+#endif
+
+#ifdef EVAL_STATS
+  if (parent_ == nullptr) {
+    LazyEvalStats::Reset();
+  }
+#endif
+
+  root_moves_ = GenerateMoves(*position);
+
+  if (!syzygy::FilterRoot(*position, &root_moves_, &wdl)) {
+    root_moves_.clear();
+  }
 
   // INFO: maybe do aspiration/widen search?
-  for (depth_ = 1; depth_ <= MAX_DEPTH; depth_++) {
-    score = search<NodeType::PV>(MIN_SCORE, MAX_SCORE, depth_, nullptr);
+  for (depth_ = 1; depth_ <= max_depth; depth_++) {
+    int iteration =
+        search<NodeType::PV>(MIN_SCORE, MAX_SCORE, depth_, nullptr);
 
     if (!Continue()) {
       break;
     }
+
+    score = iteration;
+    completed_depth_ = depth_;
   }
 
   if (state == search::State::RUNNING) {
     state = search::State::END;
   }
 
-  std::printf("got score %d\n", score);
+#ifdef LOCK_STATS
+  if (parent_ == nullptr) {
+    std::printf("%s", LockSite::Report().c_str());
+  }
+#endif
+
+#ifdef EVAL_STATS
+  if (parent_ == nullptr) {
+    std::printf("%s", LazyEvalStats::Report().c_str());
+  }
+#endif
+
+  return score;
 }
 
 template <enum NodeType T>
@@ -89,22 +137,44 @@ int Search::search(int alpha, int beta, int depth, search::Node *parent) {
   // assert(alpha <= beta);
   assert(depth >= 0);
 
+  if (stop != nullptr && stop->load(std::memory_order_relaxed)) {
+    state = search::State::END;
+  }
+
   if (depth == 0) {
     return Quiesce(alpha, beta);
   }
 
-  ++height_;
   search::Node node(this, alpha, beta, depth, parent);
+  int wdl;
 
   node.type = T;
 
   // TODO: increase depth when position king is in check
-  if (tt->CutOff(*position, node.depth, node.alpha, node.beta, &node.best_move,
-                 &node.best_score)) {
+  // INFO: the root always searches, a stored entry may carry no move, e.g. a
+  // tablebase probe from an earlier search
+  if (parent != nullptr &&
+      tt->CutOff(*position, node.depth, node.alpha, node.beta,
+                 &node.best_move, &node.best_score)) {
     return node.best_score;
   }
 
-  MoveList moves_list = GenerateMoves(*position);
+  // INFO: the result is exact whatever the depth, the root moves were
+  // filtered by DTZ instead
+  if (parent != nullptr && syzygy::Probe(*position, node.depth, &wdl)) {
+    node.best_score = syzygy::Score(wdl, height_);
+
+    tt->Add(*position, MAX_DEPTH, node.best_score, node.best_move,
+            NodeType::PV);
+
+    return node.best_score;
+  }
+
+  ++height_;
+
+  MoveList moves_list = parent == nullptr && !root_moves_.empty()
+                            ? root_moves_
+                            : GenerateMoves(*position);
 
   OrderMoves(moves_list);
 
@@ -166,6 +236,11 @@ int Search::search(int alpha, int beta, int depth, search::Node *parent) {
 
   if (state == search::State::RUNNING) {
     tt->Add(*position, node.depth, node.best_score, node.best_move, node.type);
+
+    // INFO: the root's entry can be replaced before the search returns
+    if (parent == nullptr) {
+      best_move_ = node.best_move;
+    }
   }
 
   --height_;
@@ -205,7 +280,7 @@ void Search::StopAll(search::State new_state) {
 }
 
 int Search::Quiesce(int alpha, int beta) {
-  int standing_pat = Evaluate(*position);
+  int standing_pat = Evaluate(*position, alpha, beta);
   int best_value = standing_pat;
 
   if (best_value >= beta) {
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "engine/config.hpp"
+#include "engine/move.hpp"
+#include "engine/options.hpp"
+#include "engine/position.hpp"
+#include "engine/syzygy.hpp"
+#include "tb/tbprobe.h"
+
+namespace engine {
+namespace syzygy {
+
+static constexpr Castling kAnyCastling =
+    position::CASTLE_W_KING_SIDE | position::CASTLE_W_QUEEN_SIDE |
+    position::CASTLE_B_KING_SIDE | position::CASTLE_B_QUEEN_SIDE;
+
+using Clock = std::chrono::steady_clock;
+
+struct CacheEntry {
+  std::uint64_t key;
+  std::uint32_t generation;
+  int wdl;
+};
+
+// INFO: every thread counts its hits on a cache line of its own, the counts
+// of the threads that exited are kept in `retired_hits`
+struct alignas(64) HitCounter {
+  std::atomic<std::uint64_t> hits = 0;
+
+  HitCounter();
+  ~HitCounter();
+
+  inline void Add(std::uint64_t count) {
+    hits.store(hits.load(std::memory_order_relaxed) + count,
+               std::memory_order_relaxed);
+  }
+};
+
+static std::mutex counters_mutex;
+static std::vector<HitCounter *> counters;
+static std::uint64_t retired_hits = 0;
+static thread_local HitCounter hit_counter;
+
+// INFO: only counted when built with TB_STATS, the threads share them
+static std::atomic<std::uint64_t> cache_hits = 0;
+static std::atomic<std::uint64_t> table_probes = 0;
+static std::atomic<std::uint64_t> table_nanoseconds = 0;
+
+HitCounter::HitCounter() {
+  std::lock_guard<std::mutex> lock(counters_mutex);
+
+  counters.push_back(this);
+}
+
+HitCounter::~HitCounter() {
+  std::lock_guard<std::mutex> lock(counters_mutex);
+
+  retired_hits += hits.load(std::memory_order_relaxed);
+  std::erase(counters, this);
+}
+
+// INFO: bumped by Init, the entries of an older generation are empty
+static std::atomic<std::uint32_t> generation = 1;
+static thread_local CacheEntry cache[SYZYGY_WDL_CACHE_SIZE];
+
+// INFO: joined when the program exits, the tables can't be unmapped under it
+static struct WarmupThread {
+  std::thread thread;
+  std::atomic<bool> stop = false;
+  int warmed = 0;
+
+  ~WarmupThread() {
+    stop = true;
+    JoinWarmup();
+  }
+} warmup;
+
+static std::function<void(std::string_view)> logger;
+
+static void Log(const char *message) { logger(message); }
+
+int Init(std::string_view paths) {
+  std::string copy(paths);
+
+  Warmup(0);
+
+  generation.fetch_add(1, std::memory_order_relaxed);
+  init_tablebases(copy.data());
+
+  if (options.syzygy_warmup > 0) {
+    Warmup(options.syzygy_warmup);
+  }
+
+  return TBlargest;
+}
+
+void SetLogger(std::function<void(std::string_view)> function) {
+  logger = std::move(function);
+  tb_set_logger(logger ? Log : nullptr);
+}
+
+void Warmup(int pieces) {
+  warmup.stop = true;
+  JoinWarmup();
+  warmup.warmed = 0;
+
+  if (pieces <= 0 || TBlargest == 0) {
+    return;
+  }
+
+  warmup.stop = false;
+  warmup.thread = std::thread([pieces]() {
+    warmup.warmed = tb_warmup(pieces, []() -> int { return warmup.stop; });
+  });
+}
+
+int JoinWarmup() {
+  if (warmup.thread.joinable()) {
+    warmup.thread.join();
+  }
+
+  return warmup.warmed;
+}
+
+int Cardinality() { return std::min(TBlargest, options.syzygy_probe_limit); }
+
+bool Probe(const Position &position, int depth, int *wdl) {
+  int cardinality = Cardinality();
+  int pieces = position.PieceCount();
+  int success;
+
+  // INFO: the tables don't cover castling & their WDL assumes a fresh 50-move
+  // counter, reached right after a capture or a pawn move.
+  if (pieces > cardinality ||
+      (pieces == cardinality && depth < options.syzygy_probe_depth) ||
+      position.HalfmoveClock() != 0 || position.CanCastle(kAnyCastling)) {
+    return false;
+  }
+
+  std::uint32_t current = generation.load(std::memory_order_relaxed);
+  CacheEntry &entry = cache[position.Hash() & (SYZYGY_WDL_CACHE_SIZE - 1)];
+
+  if (entry.generation == current && entry.key == position.Hash()) {
+    *wdl = entry.wdl;
+
+#ifdef TB_STATS
+    cache_hits.fetch_add(1, std::memory_order_relaxed);
+#endif
+    hit_counter.Add(1);
+
+    return true;
+  }
+
+#ifdef TB_STATS
+  Clock::time_point start = Clock::now();
+#endif
+
+  *wdl = probe_wdl(position, &success);
+
+#ifdef TB_STATS
+  table_probes.fetch_add(1, std::memory_order_relaxed);
+  table_nanoseconds.fetch_add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start)
+          .count(),
+      std::memory_order_relaxed);
+#endif
+
+  if (!success) {
+    return false;
+  }
+
+  entry = {position.Hash(), current, *wdl};
+
+  hit_counter.Add(1);
+
+  return true;
+}
+
+bool FilterRoot(Position &position, MoveList *moves, int *wdl) {
+  if (position.PieceCount() > Cardinality() ||
+      position.CanCastle(kAnyCastling)) {
+    return false;
+  }
+
+  // INFO: the probes only rewrite the move scores until every one succeeded
+  if (!root_probe(position, *moves, wdl) &&
+      !root_probe_wdl(position, *moves, wdl)) {
+    return false;
+  }
+
+  hit_counter.Add(moves->size());
+
+  return true;
+}
+
+int Score(int wdl, int height) {
+  // INFO: a cursed win or a blessed loss is a draw by the 50-move rule, it's
+  // only nudged so that the search still prefers the better side of it
+  if (wdl == 2) {
+    return TB_WIN_SCORE - height;
+  }
+
+  if (wdl == -2) {
+    return -TB_WIN_SCORE + height;
+  }
+
+  return wdl;
+}
+
+std::uint64_t Hits() {
+  std::lock_guard<std::mutex> lock(counters_mutex);
+  std::uint64_t total = retired_hits;
+
+  for (const HitCounter *counter : counters) {
+    total += counter->hits.load(std::memory_order_relaxed);
+  }
+
+  return total;
+}
+
+Stats GetStats() {
+  unsigned long long block_hits;
+  unsigned long long block_misses;
+
+  tb_block_stats(&block_hits, &block_misses);
+
+  return {cache_hits.load(std::memory_order_relaxed),
+          table_probes.load(std::memory_order_relaxed),
+          table_nanoseconds.load(std::memory_order_relaxed), block_hits,
+          block_misses};
+}
+
+void ResetStats() {
+  std::lock_guard<std::mutex> lock(counters_mutex);
+
+  retired_hits = 0;
+
+  for (HitCounter *counter : counters) {
+    counter->hits.store(0, std::memory_order_relaxed);
+  }
+
+  cache_hits.store(0, std::memory_order_relaxed);
+  table_probes.store(0, std::memory_order_relaxed);
+  table_nanoseconds.store(0, std::memory_order_relaxed);
+  tb_reset_block_stats();
+}
+
+}  // namespace syzygy
+}  // namespace engine
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/config.hpp"
+#include "engine/datagen.hpp"
+#include "engine/move.hpp"
+#include "engine/move_gen.hpp"
+#include "engine/position.hpp"
+#include "engine/search.hpp"
+#include "engine/syzygy.hpp"
+#include "engine/transposition.hpp"
+#include "tb/tbprobe.h"
+
+using namespace engine;
+
+class SyzygyTestSuite : public testing::Test {
+ protected:
+  void SetUp() override {
+    syzygy::Init("<empty>");
+    syzygy::ResetStats();
+  }
+
+  void TearDown() override { syzygy::Init("<empty>"); }
+
+  // The move `go depth` would answer with.
+  static Move SearchBestMove(TT *tt, Position *position, int depth) {
+    search::WorkerRegistry workers(0);
+    Search search(&workers);
+
+    search.tt = tt;
+    search.position = position;
+    search.max_depth = depth;
+    search.Run();
+
+    return search.BestMove();
+  }
+
+  static bool IsLegal(const Position &position, const Move &move) {
+    MoveList moves = GenerateMoves(position);
+
+    return move.piece != NONE &&
+           std::find(moves.begin(), moves.end(), move) != moves.end();
+  }
+
+  // Random legal positions of the signatures, the same ones on every run.
+  static std::vector<Position> RandomPositions(
+      const std::vector<const char *> &signatures, std::size_t count) {
+    std::vector<Position> positions;
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int> squares(0, 63);
+
+    while (positions.size() < count) {
+      const char *signature = signatures[positions.size() % signatures.size()];
+      Material material;
+      position::Placement placement;
+      Position position;
+
+      ParseMaterial(&material, signature);
+
+      for (int i = 0; i < material.size;) {
+        i += placement.Add(material.colors[i], material.pieces[i],
+                           squares(rng));
+      }
+
+      placement.turn = rng() & 1 ? BLACK : WHITE;
+
+      if (Position::ApplyPlacement(&position, placement)) {
+        positions.push_back(position);
+      }
+    }
+
+    return positions;
+  }
+};
+
+TEST_F(SyzygyTestSuite, NothingProbedWithoutTables) {
+  Position position = Position::FromFen("8/8/8/3k4/8/8/8/R3K3 w - - 0 1");
+  MoveList moves = GenerateMoves(position);
+  MoveList root = moves;
+  int wdl;
+
+  ASSERT_EQ(syzygy::Cardinality(), 0);
+  ASSERT_FALSE(syzygy::Probe(position, MAX_DEPTH, &wdl));
+  ASSERT_FALSE(syzygy::FilterRoot(position, &root, &wdl));
+  ASSERT_EQ(root.size(), moves.size());
+  ASSERT_EQ(syzygy::Hits(), 0u);
+  ASSERT_EQ(syzygy::GetStats().table_probes, 0u);
+}
+
+TEST_F(SyzygyTestSuite, LoaderReportsToTheLogger) {
+  std::vector<std::string> messages;
+
+  testing::internal::CaptureStdout();
+  syzygy::Init("/nonexistent");
+
+  ASSERT_EQ(testing::internal::GetCapturedStdout(), "");
+
+  syzygy::SetLogger([&messages](std::string_view message) {
+    messages.emplace_back(message);
+  });
+  syzygy::Init("/nonexistent");
+  syzygy::SetLogger(nullptr);
+
+  ASSERT_EQ(messages, std::vector<std::string>{"Found 0 tablebases."});
+}
+
+TEST_F(SyzygyTestSuite, ScoresPreferFasterWins) {
+  ASSERT_GT(syzygy::Score(2, 1), syzygy::Score(2, 5));
+  ASSERT_LT(syzygy::Score(-2, 1), syzygy::Score(-2, 5));
+  ASSERT_EQ(syzygy::Score(0, 3), 0);
+
+  // 50-move draws stay close to a draw
+  ASSERT_GT(syzygy::Score(1, 3), 0);
+  ASSERT_LT(syzygy::Score(1, 3), syzygy::Score(2, MAX_DEPTH));
+  ASSERT_LT(syzygy::Score(-1, 3), 0);
+}
+
+// INFO: needs the 3-5 piece tables in $SYZYGY_PATH
+TEST_F(SyzygyTestSuite, CachedProbesAgree) {
+  const char *path = std::getenv("SYZYGY_PATH");
+
+  if (path == nullptr || syzygy::Init(path) < 5) {
+    GTEST_SKIP() << "SYZYGY_PATH has no 5-piece tables";
+  }
+
+  std::vector<Position> positions =
+      RandomPositions({"KRvK", "KBNvK", "KRPvKR"}, 1024);
+  std::vector<int> expected(positions.size());
+
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    ASSERT_TRUE(syzygy::Probe(positions[i], MAX_DEPTH, &expected[i]));
+  }
+
+  // INFO: most of the second pass comes from the WDL cache, the rest shares
+  // blocks with positions probed a moment ago
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    int wdl;
+
+    ASSERT_TRUE(syzygy::Probe(positions[i], MAX_DEPTH, &wdl));
+    ASSERT_EQ(wdl, expected[i]);
+  }
+
+  ASSERT_EQ(syzygy::Hits(), 2 * positions.size());
+
+#ifdef TB_STATS
+  syzygy::Stats stats = syzygy::GetStats();
+
+  ASSERT_GT(stats.cache_hits, 0u);
+  ASSERT_EQ(stats.cache_hits + stats.table_probes, 2 * positions.size());
+  ASSERT_GT(stats.block_hits + stats.block_misses, 0u);
+#endif
+}
+
+TEST_F(SyzygyTestSuite, CaptureProbesMatchReference) {
+  const char *path = std::getenv("SYZYGY_PATH");
+
+  if (path == nullptr || syzygy::Init(path) < 5) {
+    GTEST_SKIP() << "SYZYGY_PATH has no 5-piece tables";
+  }
+
+  // INFO: without en passant rights, the only captures the reference sees
+  std::vector<Position> positions = RandomPositions(
+      {"KQvK", "KRvKB", "KRvKN", "KQvKR", "KRPvKR", "KPvKP"}, 2048);
+
+  for (Position &position : positions) {
+    std::uint64_t hash = position.Hash();
+    int success;
+    int reference;
+    int wdl = probe_wdl(position, &success);
+
+    ASSERT_TRUE(success);
+    ASSERT_EQ(position.Hash(), hash);
+
+    reference = probe_wdl_reference(position, &success);
+
+    ASSERT_TRUE(success);
+    ASSERT_EQ(wdl, reference) << position.ToFen();
+  }
+}
+
+TEST_F(SyzygyTestSuite, EnPassantCaptures) {
+  const char *path = std::getenv("SYZYGY_PATH");
+
+  if (path == nullptr || syzygy::Init(path) < 5) {
+    GTEST_SKIP() << "SYZYGY_PATH has no 5-piece tables";
+  }
+
+  struct Case {
+    const char *fen;
+    std::size_t moves;
+    int wdl;
+  };
+
+  // INFO: the reference doesn't see en passant captures, it isn't compared
+  const Case cases[] = {
+      // exd6 wins outright, the pawn can't be caught
+      {"8/8/8/3pP3/8/8/8/K6k w - d6 0 1", 5, 2},
+      // fxg6 is the only legal move, without it white is stalemated
+      {"8/8/5k2/5Pp1/8/8/5q2/7K w - g6 0 1", 1, -2},
+  };
+
+  for (const Case &test : cases) {
+    Position position = Position::FromFen(test.fen);
+    MoveList moves = GenerateMoves(position);
+    int success;
+
+    ASSERT_EQ(moves.size(), test.moves) << test.fen;
+    ASSERT_TRUE(std::any_of(moves.begin(), moves.end(), [](const Move &move) {
+      return move.Is(move::EN_PASSANT);
+    })) << test.fen;
+    ASSERT_EQ(probe_wdl(position, &success), test.wdl) << test.fen;
+    ASSERT_EQ(success, 2) << test.fen;
+  }
+}
+
+// INFO: the entry an earlier probe left behind has no move, the root must
+// still be searched
+TEST_F(SyzygyTestSuite, RootIgnoresMovelessEntries) {
+  Position position = Position::FromFen("8/8/8/3k4/8/8/8/R3K3 w - - 0 1");
+  TT tt(1 << 20);
+
+  tt.Add(position, MAX_DEPTH, syzygy::Score(2, 0), Move(), NodeType::PV);
+
+  ASSERT_TRUE(IsLegal(position, SearchBestMove(&tt, &position, 3)));
+}
+
+TEST_F(SyzygyTestSuite, RepeatedSearchesAnswerWithAMove) {
+  const char *path = std::getenv("SYZYGY_PATH");
+
+  if (path == nullptr || syzygy::Init(path) < 5) {
+    GTEST_SKIP() << "SYZYGY_PATH has no 5-piece tables";
+  }
+
+  Position position = Position::FromFen("8/8/8/3k4/8/8/8/R3K3 w - - 0 1");
+  TT tt(1 << 20);
+
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(IsLegal(position, SearchBestMove(&tt, &position, 4)))
+        << "search " << i;
+  }
+}
+
+TEST_F(SyzygyTestSuite, ConcurrentProbesAgree) {
+  const char *path = std::getenv("SYZYGY_PATH");
+
+  if (path == nullptr || syzygy::Init(path) < 5) {
+    GTEST_SKIP() << "SYZYGY_PATH has no 5-piece tables";
+  }
+
+  std::vector<Position> positions = RandomPositions(
+      {"KQvK", "KRvK", "KPvK", "KBNvK", "KRvKB", "KQvKR", "KRPvKR"}, 4096);
+  std::vector<int> expected(positions.size());
+  int success;
+
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    expected[i] = probe_wdl(positions[i], &success);
+
+    ASSERT_TRUE(success);
+  }
+
+  // INFO: every table is mapped again & the threads race to its first probe,
+  // each one starting at a different offset of the shared positions
+  for (int round = 0; round < 4; round++) {
+    syzygy::Init(path);
+
+    constexpr int kThreads = 8;
+    std::vector<std::thread> threads;
+    std::vector<std::size_t> mismatches(kThreads);
+
+    for (int t = 0; t < kThreads; t++) {
+      threads.emplace_back([&, t]() {
+        for (std::size_t j = 0; j < positions.size(); j++) {
+          std::size_t i = (j + t * positions.size() / kThreads) %
+                          positions.size();
+          int success;
+          int wdl = probe_wdl(positions[i], &success);
+
+          mismatches[t] += !success || wdl != expected[i];
+        }
+      });
+    }
+
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+
+    for (int t = 0; t < kThreads; t++) {
+      ASSERT_EQ(mismatches[t], 0u) << "thread " << t << " round " << round;
+    }
+  }
+}
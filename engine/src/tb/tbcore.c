@@ -7,6 +7,7 @@
   a particular engine, provided the engine is written in C or C++.
 */
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdint.h>
@@ -16,6 +17,7 @@
 #include <fcntl.h>
 #ifndef __WIN32__
 #include <sys/mman.h>
+#include <dirent.h>
 #endif
 #include "tb/tbcore.h"
 
@@ -35,8 +37,6 @@
 #define TB_WPAWN TB_PAWN
 #define TB_BPAWN (TB_PAWN | 8)
 
-static LOCK_T TB_mutex;
-
 static int initialized = 0;
 static int num_paths = 0;
 static char *path_string = NULL;
@@ -48,35 +48,156 @@ static struct TBEntry_pawn TB_pawn[TBMAX_PAWN];
 
 static struct TBHashEntry TB_hash[1 << TBHASHBITS][HSHMAX];
 
+// A table file found while scanning the paths, with the path it was found in.
+struct TBFile {
+  char name[16];
+  int path;
+};
+
+static struct TBFile *TB_files = NULL;
+static int TBnum_files = 0;
+
+// Receives the loader's messages, nothing is printed without one.
+static void (*tb_logger)(const char *message) = NULL;
+
+void tb_set_logger(void (*logger)(const char *message))
+{
+  tb_logger = logger;
+}
+
+static void tb_log(const char *format, ...)
+{
+  char message[256];
+  va_list args;
+
+  if (!tb_logger)
+    return;
+
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+
+  tb_logger(message);
+}
+
 #define DTZ_ENTRIES 64
 
 static struct DTZTableEntry DTZ_table[DTZ_ENTRIES];
 
+// Bumped whenever a table is unmapped, the block caches of every thread are
+// dropped on their next probe.
+static uint32 TB_generation = 1;
+// Only counted when built with TB_STATS, the threads share them.
+static uint64 TB_block_hits = 0;
+static uint64 TB_block_misses = 0;
+
 static void init_indices(void);
 static uint64 calc_key_from_pcs(int *pcs, int mirror);
 static void free_wdl_entry(struct TBEntry *entry);
 static void free_dtz_entry(struct TBEntry *entry);
 
+static int compare_names(const void *a, const void *b)
+{
+  return strcmp(((const struct TBFile *)a)->name,
+		((const struct TBFile *)b)->name);
+}
+
+static int compare_files(const void *a, const void *b)
+{
+  const struct TBFile *x = (const struct TBFile *)a;
+  const struct TBFile *y = (const struct TBFile *)b;
+  int cmp = strcmp(x->name, y->name);
+  return cmp ? cmp : x->path - y->path;
+}
+
+static void add_file(const char *name, int path, int *capacity)
+{
+  size_t len = strlen(name);
+
+  if (len < 6 || len >= sizeof(TB_files->name)
+      || (strcmp(name + len - 5, WDLSUFFIX)
+	  && strcmp(name + len - 5, DTZSUFFIX)))
+    return;
+
+  if (TBnum_files == *capacity) {
+    *capacity = *capacity ? 2 * *capacity : 256;
+    TB_files = (struct TBFile *)realloc(TB_files,
+					*capacity * sizeof(struct TBFile));
+  }
+
+  strcpy(TB_files[TBnum_files].name, name);
+  TB_files[TBnum_files++].path = path;
+}
+
+// Lists every path once instead of trying to open each possible table in
+// each of them. A table found in several paths is taken from the first one.
+static void scan_paths(void)
+{
+  int i, j, capacity = 0;
+
+  TBnum_files = 0;
+  for (i = 0; i < num_paths; i++) {
+#ifndef __WIN32__
+    DIR *dir = opendir(paths[i]);
+    struct dirent *ent;
+    if (!dir) continue;
+    while ((ent = readdir(dir)))
+      add_file(ent->d_name, i, &capacity);
+    closedir(dir);
+#else
+    WIN32_FIND_DATA data;
+    char pattern[256];
+    snprintf(pattern, sizeof(pattern), "%s\\*", paths[i]);
+    HANDLE find = FindFirstFile(pattern, &data);
+    if (find == INVALID_HANDLE_VALUE) continue;
+    do
+      add_file(data.cFileName, i, &capacity);
+    while (FindNextFile(find, &data));
+    FindClose(find);
+#endif
+  }
+
+  if (!TBnum_files) return;
+
+  qsort(TB_files, TBnum_files, sizeof(struct TBFile), compare_files);
+  for (i = j = 1; i < TBnum_files; i++)
+    if (strcmp(TB_files[i].name, TB_files[j - 1].name))
+      TB_files[j++] = TB_files[i];
+  TBnum_files = j;
+}
+
+static struct TBFile *find_file(const char *str, const char *suffix)
+{
+  struct TBFile key;
+
+  if (strlen(str) + strlen(suffix) >= sizeof(key.name))
+    return NULL;
+  strcpy(key.name, str);
+  strcat(key.name, suffix);
+  key.path = 0;
+
+  return (struct TBFile *)bsearch(&key, TB_files, TBnum_files,
+				  sizeof(struct TBFile), compare_names);
+}
+
 static FD open_tb(const char *str, const char *suffix)
 {
-  int i;
   FD fd;
   char file[256];
+  struct TBFile *found = find_file(str, suffix);
 
-  for (i = 0; i < num_paths; i++) {
-    strcpy(file, paths[i]);
-    strcat(file, "/");
-    strcat(file, str);
-    strcat(file, suffix);
+  if (!found) return FD_ERR;
+
+  strcpy(file, paths[found->path]);
+  strcat(file, "/");
+  strcat(file, found->name);
 #ifndef __WIN32__
-    fd = open(file, O_RDONLY);
+  fd = open(file, O_RDONLY);
 #else
-    fd = CreateFile(file, GENERIC_READ, FILE_SHARE_READ, NULL,
-			  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  fd = CreateFile(file, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 #endif
-    if (fd != FD_ERR) return fd;
-  }
-  return FD_ERR;
+  return fd;
 }
 
 static void close_tb(FD fd)
@@ -100,7 +221,7 @@ static char *map_file(const char *name, const char *suffix, uint64 *mapping)
   char *data = (char *)mmap(NULL, statbuf.st_size, PROT_READ,
 			      MAP_SHARED, fd, 0);
   if (data == (char *)(-1)) {
-    printf("Could not mmap() %s.\n", name);
+    fprintf(stderr, "Could not mmap() %s.\n", name);
     exit(1);
   }
 #else
@@ -109,13 +230,13 @@ static char *map_file(const char *name, const char *suffix, uint64 *mapping)
   HANDLE map = CreateFileMapping(fd, NULL, PAGE_READONLY, size_high, size_low,
 				  NULL);
   if (map == NULL) {
-    printf("CreateFileMapping() failed.\n");
+    fprintf(stderr, "CreateFileMapping() failed.\n");
     exit(1);
   }
   *mapping = (uint64)map;
   char *data = (char *)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
   if (data == NULL) {
-    printf("MapViewOfFile() failed, name = %s%s, error = %lu.\n", name, suffix, GetLastError());
+    fprintf(stderr, "MapViewOfFile() failed, name = %s%s, error = %lu.\n", name, suffix, GetLastError());
     exit(1);
   }
 #endif
@@ -147,7 +268,7 @@ static void add_to_hash(struct TBEntry *ptr, uint64 key)
   while (i < HSHMAX && TB_hash[hshidx][i].ptr)
     i++;
   if (i == HSHMAX) {
-    printf("HSHMAX too low!\n");
+    fprintf(stderr, "HSHMAX too low!\n");
     exit(1);
   } else {
     TB_hash[hshidx][i].key = key;
@@ -157,18 +278,10 @@ static void add_to_hash(struct TBEntry *ptr, uint64 key)
 
 static char pchr[] = {'K', 'Q', 'R', 'B', 'N', 'P'};
 
-static void init_tb(char *str)
+static void parse_pcs(const char *str, int *pcs)
 {
-  FD fd;
-  struct TBEntry *entry;
-  int i, j, pcs[16];
-  uint64 key, key2;
-  int color;
-  char *s;
-
-  fd = open_tb(str, WDLSUFFIX);
-  if (fd == FD_ERR) return;
-  close_tb(fd);
+  int i, color;
+  const char *s;
 
   for (i = 0; i < 16; i++)
     pcs[i] = 0;
@@ -197,23 +310,34 @@ static void init_tb(char *str)
       color = 0x08;
       break;
     }
+}
+
+static void init_tb(char *str)
+{
+  struct TBEntry *entry;
+  int i, j, pcs[16];
+  uint64 key, key2;
+
+  if (!find_file(str, WDLSUFFIX)) return;
+
+  parse_pcs(str, pcs);
   key = calc_key_from_pcs(pcs, 0);
   key2 = calc_key_from_pcs(pcs, 1);
   if (pcs[TB_WPAWN] + pcs[TB_BPAWN] == 0) {
     if (TBnum_piece == TBMAX_PIECE) {
-      printf("TBMAX_PIECE limit too low!\n");
+      fprintf(stderr, "TBMAX_PIECE limit too low!\n");
       exit(1);
     }
     entry = (struct TBEntry *)&TB_piece[TBnum_piece++];
   } else {
     if (TBnum_pawn == TBMAX_PAWN) {
-      printf("TBMAX_PAWN limit too low!\n");
+      fprintf(stderr, "TBMAX_PAWN limit too low!\n");
       exit(1);
     }
     entry = (struct TBEntry *)&TB_pawn[TBnum_pawn++];
   }
   entry->key = key;
-  entry->ready = 0;
+  entry->ready = TB_UNINIT;
   entry->num = 0;
   for (i = 0; i < 16; i++)
     entry->num += pcs[i];
@@ -259,16 +383,20 @@ void init_tablebases(char *path)
     struct TBEntry *entry;
     for (i = 0; i < TBnum_piece; i++) {
       entry = (struct TBEntry *)&TB_piece[i];
-      free_wdl_entry(entry);
+      if (entry->ready == TB_READY)
+	free_wdl_entry(entry);
     }
     for (i = 0; i < TBnum_pawn; i++) {
       entry = (struct TBEntry *)&TB_pawn[i];
-      free_wdl_entry(entry);
+      if (entry->ready == TB_READY)
+	free_wdl_entry(entry);
     }
     for (i = 0; i < DTZ_ENTRIES; i++)
       if (DTZ_table[i].entry)
 	free_dtz_entry(DTZ_table[i].entry);
-    LOCK_DESTROY(TB_mutex);
+    free(TB_files);
+    TB_files = NULL;
+    TBnum_files = 0;
     path_string = NULL;
   }
 
@@ -294,7 +422,7 @@ void init_tablebases(char *path)
     while (path_string[j]) j++;
   }
 
-  LOCK_INIT(TB_mutex);
+  scan_paths();
 
   TBnum_piece = TBnum_pawn = 0;
   TBlargest = 0;
@@ -363,7 +491,7 @@ void init_tablebases(char *path)
 	  init_tb(str);
 	}
 
-  printf("Found %d tablebases.\n", TBnum_piece + TBnum_pawn);
+  tb_log("Found %d tablebases.", TBnum_piece + TBnum_pawn);
 }
 
 static const signed char offdiag[] = {
@@ -997,13 +1125,13 @@ static int init_table_wdl(struct TBEntry *entry, char *str)
   // first mmap the table into memory
   entry->data = map_file(str, WDLSUFFIX, &entry->mapping);
   if (!entry->data) {
-    printf("Could not find %s" WDLSUFFIX "\n", str);
+    tb_log("Could not find %s" WDLSUFFIX, str);
     return 0;
   }
 
   ubyte *data = (ubyte *)entry->data;
   if (((uint32 *)data)[0] != WDL_MAGIC) {
-    printf("Corrupted table.\n");
+    tb_log("Corrupted table %s" WDLSUFFIX ".", str);
     unmap_file(entry->data, entry->mapping);
     entry->data = 0;
     return 0;
@@ -1113,7 +1241,7 @@ static int init_table_dtz(struct TBEntry *entry)
     return 0;
 
   if (((uint32 *)data)[0] != DTZ_MAGIC) {
-    printf("Corrupted table.\n");
+    tb_log("Corrupted table.");
     return 0;
   }
 
@@ -1195,24 +1323,29 @@ static int init_table_dtz(struct TBEntry *entry)
   return 1;
 }
 
-static ubyte decompress_pairs(struct PairsData *d, uint64 idx)
-{
-  if (!d->idxbits)
-    return d->min_len;
+struct BlockCacheEntry {
+  struct PairsData *d;
+  uint32 block;
+  uint32 stamp;
+  int size; // -1 when the block has too many symbols
+  ushort sym[TBCACHE_SYMBOLS];
+  ushort last[TBCACHE_SYMBOLS]; // last literal of each symbol
+};
 
-  uint32 mainidx = idx >> d->idxbits;
-  int litidx = (idx & ((1 << d->idxbits) - 1)) - (1 << (d->idxbits - 1));
-  uint32 block = *(uint32 *)(d->indextable + 6 * mainidx);
-  litidx += *(ushort *)(d->indextable + 6 * mainidx + 4);
-  if (litidx < 0) {
-    do {
-      litidx += d->sizetable[--block] + 1;
-    } while (litidx < 0);
-  } else {
-    while (litidx > d->sizetable[block])
-      litidx -= d->sizetable[block++] + 1;
-  }
+struct BlockCache {
+  uint32 generation;
+  uint32 stamp;
+  struct BlockCacheEntry entries[TBCACHE_BLOCKS];
+};
+
+static __thread struct BlockCache block_cache;
 
+// Walks the symbols of a block up to the one holding literal `*litidx`, left
+// relative to that symbol. Every symbol on the way is recorded in `entry`
+// when one is given.
+static int walk_block(struct PairsData *d, uint32 block, int *litidx,
+		      struct BlockCacheEntry *entry)
+{
   uint32 *ptr = (uint32 *)(d->data + (block << d->blocksize));
 
   int m = d->min_len;
@@ -1220,6 +1353,7 @@ static ubyte decompress_pairs(struct PairsData *d, uint64 idx)
   base_t *base = d->base - m;
   ubyte *symlen = d->symlen;
   int sym, bitcnt;
+  int lit = 0;
 
 #ifdef DECOMP64
   uint64 code = __builtin_bswap64(*((uint64 *)ptr));
@@ -1229,8 +1363,16 @@ static ubyte decompress_pairs(struct PairsData *d, uint64 idx)
     int l = m;
     while (code < base[l]) l++;
     sym = offset[l] + ((code - base[l]) >> (64 - l));
-    if (litidx < (int)symlen[sym] + 1) break;
-    litidx -= (int)symlen[sym] + 1;
+    if (entry && entry->size < TBCACHE_SYMBOLS) {
+      lit += symlen[sym];
+      entry->sym[entry->size] = sym;
+      entry->last[entry->size++] = lit++;
+    } else if (entry) {
+      entry->size = -1;
+      entry = NULL;
+    }
+    if (*litidx < (int)symlen[sym] + 1) break;
+    *litidx -= (int)symlen[sym] + 1;
     code <<= l;
     bitcnt += l;
     if (bitcnt >= 32) {
@@ -1246,8 +1388,16 @@ static ubyte decompress_pairs(struct PairsData *d, uint64 idx)
     int l = m;
     while (code < base[l]) l++;
     sym = offset[l] + ((code - base[l]) >> (32 - l));
-    if (litidx < (int)symlen[sym] + 1) break;
-    litidx -= (int)symlen[sym] + 1;
+    if (entry && entry->size < TBCACHE_SYMBOLS) {
+      lit += symlen[sym];
+      entry->sym[entry->size] = sym;
+      entry->last[entry->size++] = lit++;
+    } else if (entry) {
+      entry->size = -1;
+      entry = NULL;
+    }
+    if (*litidx < (int)symlen[sym] + 1) break;
+    *litidx -= (int)symlen[sym] + 1;
     code <<= l;
     if (bitcnt < l) {
       if (bitcnt) {
@@ -1263,6 +1413,91 @@ static ubyte decompress_pairs(struct PairsData *d, uint64 idx)
   }
 #endif
 
+  return sym;
+}
+
+// Symbol holding literal `*litidx` of a block, decoded from this thread's
+// cache. The least recently used block makes room for a missing one.
+static int cached_symbol(struct PairsData *d, uint32 block, int *litidx)
+{
+  struct BlockCache *cache = &block_cache;
+  struct BlockCacheEntry *entry = &cache->entries[0];
+  uint32 generation = __atomic_load_n(&TB_generation, __ATOMIC_ACQUIRE);
+  int i;
+
+  if (cache->generation != generation) {
+    for (i = 0; i < TBCACHE_BLOCKS; i++) {
+      cache->entries[i].d = NULL;
+      cache->entries[i].stamp = 0;
+    }
+    cache->generation = generation;
+  }
+
+  for (i = 0; i < TBCACHE_BLOCKS; i++) {
+    if (cache->entries[i].d == d && cache->entries[i].block == block)
+      break;
+    if (cache->entries[i].stamp < entry->stamp)
+      entry = &cache->entries[i];
+  }
+
+  if (i < TBCACHE_BLOCKS) {
+    entry = &cache->entries[i];
+#ifdef TB_STATS
+    __atomic_fetch_add(&TB_block_hits, 1, __ATOMIC_RELAXED);
+#endif
+  } else {
+    int last = d->sizetable[block];
+    entry->d = d;
+    entry->block = block;
+    entry->size = 0;
+    walk_block(d, block, &last, entry);
+#ifdef TB_STATS
+    __atomic_fetch_add(&TB_block_misses, 1, __ATOMIC_RELAXED);
+#endif
+  }
+
+  entry->stamp = ++cache->stamp;
+
+  if (entry->size < 0)
+    return walk_block(d, block, litidx, NULL);
+
+  // first symbol ending at or after the literal
+  int lo = 0, hi = entry->size - 1;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (entry->last[mid] < *litidx)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo > 0)
+    *litidx -= entry->last[lo - 1] + 1;
+
+  return entry->sym[lo];
+}
+
+static ubyte decompress_pairs(struct PairsData *d, uint64 idx)
+{
+  if (!d->idxbits)
+    return d->min_len;
+
+  uint32 mainidx = idx >> d->idxbits;
+  int litidx = (idx & ((1 << d->idxbits) - 1)) - (1 << (d->idxbits - 1));
+  uint32 block = *(uint32 *)(d->indextable + 6 * mainidx);
+  litidx += *(ushort *)(d->indextable + 6 * mainidx + 4);
+  if (litidx < 0) {
+    do {
+      litidx += d->sizetable[--block] + 1;
+    } while (litidx < 0);
+  } else {
+    while (litidx > d->sizetable[block])
+      litidx -= d->sizetable[block++] + 1;
+  }
+
+  ubyte *symlen = d->symlen;
+  int sym = cached_symbol(d, block, &litidx);
+
   ubyte *sympat = d->sympat;
   while (symlen[sym] != 0) {
     int w = *(int *)(sympat + 3 * sym);
@@ -1278,6 +1513,18 @@ static ubyte decompress_pairs(struct PairsData *d, uint64 idx)
   return *(sympat + 3 * sym);
 }
 
+void tb_block_stats(uint64 *hits, uint64 *misses)
+{
+  *hits = __atomic_load_n(&TB_block_hits, __ATOMIC_RELAXED);
+  *misses = __atomic_load_n(&TB_block_misses, __ATOMIC_RELAXED);
+}
+
+void tb_reset_block_stats(void)
+{
+  __atomic_store_n(&TB_block_hits, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&TB_block_misses, 0, __ATOMIC_RELAXED);
+}
+
 void load_dtz_table(char *str, uint64 key1, uint64 key2)
 {
   int i;
@@ -1318,8 +1565,77 @@ void load_dtz_table(char *str, uint64 key1, uint64 key2)
     DTZ_table[0].entry = ptr3;
 }
 
+// Maps a WDL table on its first probe, concurrent probes of other tables go
+// on undisturbed. Every probe after that costs a single acquire load.
+static int init_table_wdl_once(struct TBEntry *entry, char *str)
+{
+  ubyte state = __atomic_load_n(&entry->ready, __ATOMIC_ACQUIRE);
+  ubyte expected = TB_UNINIT;
+
+  if (state == TB_UNINIT
+      && __atomic_compare_exchange_n(&entry->ready, &expected, TB_LOADING, 0,
+				     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    state = init_table_wdl(entry, str) ? TB_READY : TB_FAILED;
+    __atomic_store_n(&entry->ready, state, __ATOMIC_RELEASE);
+    return state == TB_READY;
+  }
+
+  while ((state = __atomic_load_n(&entry->ready, __ATOMIC_ACQUIRE))
+	 == TB_LOADING)
+    YIELD();
+
+  return state == TB_READY;
+}
+
+// Maps the WDL tables of up to `pieces` pieces & faults their pages in, the
+// smaller tables first as the search probes those the most. Returns early
+// once `stopped` returns non-zero, the number of tables warmed otherwise.
+int tb_warmup(int pieces, int (*stopped)(void))
+{
+  int i, n, warmed = 0;
+
+  for (n = 3; n <= pieces; n++)
+    for (i = 0; i < TBnum_files; i++) {
+      char str[16];
+      int pcs[16];
+      size_t len = strlen(TB_files[i].name) - strlen(WDLSUFFIX);
+
+      if (strcmp(TB_files[i].name + len, WDLSUFFIX) || (int)len - 1 != n)
+	continue;
+      if (stopped()) return warmed;
+
+      memcpy(str, TB_files[i].name, len);
+      str[len] = 0;
+      parse_pcs(str, pcs);
+
+      uint64 key = calc_key_from_pcs(pcs, 0);
+      struct TBHashEntry *ptr2 = TB_hash[key >> (64 - TBHASHBITS)];
+      int j;
+      for (j = 0; j < HSHMAX; j++)
+	if (ptr2[j].key == key) break;
+      if (j == HSHMAX || !init_table_wdl_once(ptr2[j].ptr, str))
+	continue;
+
+#ifndef __WIN32__
+      struct TBEntry *entry = ptr2[j].ptr;
+      volatile char sink;
+      uint64 offset;
+      madvise(entry->data, entry->mapping, MADV_WILLNEED);
+      for (offset = 0; offset < entry->mapping; offset += 4096) {
+	if (!(offset & ((1 << 24) - 1)) && stopped()) return warmed;
+	sink = entry->data[offset];
+      }
+      (void)sink;
+#endif
+      warmed++;
+    }
+
+  return warmed;
+}
+
 static void free_wdl_entry(struct TBEntry *entry)
 {
+  __atomic_fetch_add(&TB_generation, 1, __ATOMIC_RELEASE);
   unmap_file(entry->data, entry->mapping);
   if (!entry->has_pawns) {
     struct TBEntry_piece *ptr = (struct TBEntry_piece *)entry;
@@ -1339,6 +1655,7 @@ static void free_wdl_entry(struct TBEntry *entry)
 
 static void free_dtz_entry(struct TBEntry *entry)
 {
+  __atomic_fetch_add(&TB_generation, 1, __ATOMIC_RELEASE);
   unmap_file(entry->data, entry->mapping);
   if (!entry->has_pawns) {
     struct DTZEntry_piece *ptr = (struct DTZEntry_piece *)entry;
@@ -13,6 +13,8 @@
 // 32-bit is only supported for 5-piece tables, because tables are mmap()ed
 // into memory.
 #include <bit>
+#include <cstdint>
+#include <vector>
 
 #include "tb/tbcore.h"
 #include "tb/tbprobe.h"
@@ -42,7 +44,8 @@ static const engine::Piece kPieceMap[6] = {
 // of the form KQPvKRP, where "KQP" represents the white pieces if
 // mirror == 0 and the black pieces if mirror == 1.
 // No need to make this very efficient.
-static void prt_str(Position &pos, char *str, int mirror) {
+template <typename Board>
+static void prt_str(const Board &pos, char *str, int mirror) {
   int color;
   int i;
 
@@ -76,7 +79,8 @@ static void prt_str(Position &pos, char *str, int mirror) {
 // Given a position, produce a 64-bit material signature key.
 // If the engine supports such a key, it should equal the engine's key.
 // Again no need to make this very efficient.
-static uint64 calc_key(Position &pos, int mirror) {
+template <typename Board>
+static uint64 calc_key(const Board &pos, int mirror) {
   int color;
   int i;
   uint64 key = 0;
@@ -144,10 +148,14 @@ static uint64 calc_key_from_pcs(int *pcs, int mirror) {
 }
 
 // TODO: implement a material key concept
-static uint64 material_key(Position &pos) { return calc_key(pos, 0); }
+template <typename Board>
+static uint64 material_key(const Board &pos) {
+  return calc_key(pos, 0);
+}
 
 // probe_wdl_table and probe_dtz_table require similar adaptations.
-static int probe_wdl_table(Position &pos, int *success) {
+template <typename Board>
+static int probe_wdl_table(const Board &pos, int *success) {
   struct TBEntry *ptr;
   struct TBHashEntry *ptr2;
   uint64 idx;
@@ -176,22 +184,13 @@ static int probe_wdl_table(Position &pos, int *success) {
   }
 
   ptr = ptr2[i].ptr;
-  if (!ptr->ready) {
-    LOCK(TB_mutex);
-    if (!ptr->ready) {
-      char str[16];
-      prt_str(pos, str, ptr->key != key);
-      if (!init_table_wdl(ptr, str)) {
-        ptr2[i].key = 0ULL;
-        *success = 0;
-        UNLOCK(TB_mutex);
-        return 0;
-      }
-      // Memory barrier to ensure ptr->ready = 1 is not reordered.
-      __asm__ __volatile__("" ::: "memory");
-      ptr->ready = 1;
+  if (__atomic_load_n(&ptr->ready, __ATOMIC_ACQUIRE) != TB_READY) {
+    char str[16];
+    prt_str(pos, str, ptr->key != key);
+    if (!init_table_wdl_once(ptr, str)) {
+      *success = 0;
+      return 0;
     }
-    UNLOCK(TB_mutex);
   }
 
   int bside, mirror, cmirror;
@@ -363,18 +362,245 @@ static int probe_dtz_table(Position &pos, int wdl, int *success) {
   return res;
 }
 
-static int probe_ab(Position &pos, int alpha, int beta, int *success) {
+// INFO: the pieces & the side to move, all that the WDL probes look at. The
+// captures are made on copies, probing never writes to the caller's position.
+struct TBBoard {
+  engine::PieceList pieces[COLOR];
+  engine::Bitboard occupied[COLOR];
+  engine::Bitboard en_passant_sq;
+  engine::Color turn;
+
+  const engine::PieceList &Pieces(engine::Color color) const {
+    return pieces[color];
+  }
+
+  engine::Color Turn() const { return turn; }
+};
+
+struct TBCapture {
+  std::uint8_t from;
+  std::uint8_t to;
+  engine::Piece piece;
+  engine::Piece captured;
+  // INFO: the piece standing on `to` after the capture
+  engine::Piece result;
+  bool en_passant;
+};
+
+static TBBoard to_board(const Position &pos) {
+  TBBoard board;
+
+  for (engine::Color color : {engine::WHITE, engine::BLACK}) {
+    board.pieces[color] = pos.Pieces(color);
+    board.occupied[color] = engine::square::Occupancy(pos.Pieces(color));
+  }
+
+  board.en_passant_sq = pos.EnPassantSquare();
+  board.turn = pos.Turn();
+
+  return board;
+}
+
+static engine::Bitboard pawn_attacks(engine::Color color,
+                                     engine::Bitboard pawns) {
+  return color == engine::WHITE ? engine::PawnTargets<engine::WHITE>(pawns)
+                                : engine::PawnTargets<engine::BLACK>(pawns);
+}
+
+static engine::Bitboard attacks(engine::Piece piece, int square,
+                                engine::Bitboard occupied) {
+  switch (piece) {
+    case engine::ROOK:
+      return engine::kSlidingAttacks.Rook(occupied, square);
+    case engine::BISHOP:
+      return engine::kSlidingAttacks.Bishop(occupied, square);
+    case engine::QUEEN:
+      return engine::kSlidingAttacks.Queen(occupied, square);
+    default:
+      return engine::kAttackMaps[piece][square];
+  }
+}
+
+// Whether the king of the side that just moved was left in check.
+static bool king_attacked(const TBBoard &board) {
+  engine::Color us = OPP(board.turn);
+  const engine::PieceList &them = board.pieces[board.turn];
+  engine::Bitboard occupied = board.occupied[0] | board.occupied[1];
+  int king = engine::square::Index(board.pieces[us][engine::KING]);
+
+  return (pawn_attacks(us, board.pieces[us][engine::KING]) &
+          them[engine::PAWN]) ||
+         (engine::kAttackMaps[engine::KNIGHT][king] & them[engine::KNIGHT]) ||
+         (engine::kAttackMaps[engine::KING][king] & them[engine::KING]) ||
+         (engine::kSlidingAttacks.Bishop(occupied, king) &
+          (them[engine::BISHOP] | them[engine::QUEEN])) ||
+         (engine::kSlidingAttacks.Rook(occupied, king) &
+          (them[engine::ROOK] | them[engine::QUEEN]));
+}
+
+static constexpr engine::Piece kPieces[] = {engine::KNIGHT, engine::BISHOP,
+                                            engine::ROOK, engine::QUEEN,
+                                            engine::KING};
+
+// Pseudo-legal captures, en passant & capturing promotions included, the
+// caller drops the ones leaving its king in check.
+static int generate_captures(const TBBoard &board, TBCapture *captures) {
+  static constexpr engine::Piece kPromotions[] = {
+      engine::QUEEN, engine::ROOK, engine::BISHOP, engine::KNIGHT};
+
+  engine::Color us = board.turn;
+  engine::Color them = OPP(us);
+  engine::Bitboard occupied = board.occupied[0] | board.occupied[1];
+  engine::Bitboard targets =
+      board.occupied[them] & ~board.pieces[them][engine::KING];
+  int count = 0;
+
+  auto captured = [&](int square) {
+    engine::Bitboard bb = engine::square::BB(square);
+    int piece = 0;
+
+    while (!(board.pieces[them][piece] & bb)) {
+      piece++;
+    }
+
+    return static_cast<engine::Piece>(piece);
+  };
+
+  for (engine::Piece piece : kPieces) {
+    BITLOOP(board.pieces[us][piece]) {
+      int from = LOOP_INDEX;
+      engine::Bitboard to = attacks(piece, from, occupied) & targets;
+
+      BITLOOP(to) {
+        engine::Piece victim = captured(LOOP_INDEX);
+
+        captures[count++] = {static_cast<std::uint8_t>(from),
+                             static_cast<std::uint8_t>(LOOP_INDEX), piece,
+                             victim, piece, false};
+      }
+    }
+  }
+
+  BITLOOP(board.pieces[us][engine::PAWN]) {
+    int from = LOOP_INDEX;
+    engine::Bitboard to =
+        pawn_attacks(us, engine::square::BB(from)) &
+        (targets | board.en_passant_sq);
+
+    BITLOOP(to) {
+      bool en_passant = engine::square::BB(LOOP_INDEX) & board.en_passant_sq;
+      engine::Piece victim = en_passant ? engine::PAWN : captured(LOOP_INDEX);
+      TBCapture capture = {static_cast<std::uint8_t>(from),
+                           static_cast<std::uint8_t>(LOOP_INDEX), engine::PAWN,
+                           victim, engine::PAWN, en_passant};
+
+      if (!(engine::square::BB(LOOP_INDEX) &
+            (engine::kRank1 | engine::kRank8))) {
+        captures[count++] = capture;
+        continue;
+      }
+
+      for (engine::Piece promoted : kPromotions) {
+        capture.result = promoted;
+        captures[count++] = capture;
+      }
+    }
+  }
+
+  return count;
+}
+
+static void make_capture(TBBoard *board, const TBCapture &capture) {
+  engine::Color us = board->turn;
+  engine::Color them = OPP(us);
+  // INFO: the pawn taken en passant stands behind the target square
+  int square = capture.en_passant ? capture.to ^ 8 : capture.to;
+  engine::Bitboard victim = engine::square::BB(square);
+  engine::Bitboard from = engine::square::BB(capture.from);
+  engine::Bitboard to = engine::square::BB(capture.to);
+
+  board->pieces[them][capture.captured] ^= victim;
+  board->occupied[them] ^= victim;
+  board->pieces[us][capture.piece] ^= from;
+  board->pieces[us][capture.result] |= to;
+  board->occupied[us] ^= from | to;
+  board->en_passant_sq = engine::kEmpty;
+  board->turn = them;
+}
+
+// Whether the side to move has a legal move that isn't a capture. Castling
+// is left out, it's only legal when the king can step aside as well.
+static bool has_quiet_move(const TBBoard &board) {
+  engine::Color us = board.turn;
+  engine::Bitboard occupied = board.occupied[0] | board.occupied[1];
+
+  auto legal = [&](engine::Piece piece, int from, int to) {
+    TBBoard next = board;
+    engine::Bitboard move = engine::square::BB(from) | engine::square::BB(to);
+
+    next.pieces[us][piece] ^= move;
+    next.occupied[us] ^= move;
+    next.turn = OPP(us);
+
+    return !king_attacked(next);
+  };
+
+  for (engine::Piece piece : kPieces) {
+    BITLOOP(board.pieces[us][piece]) {
+      int from = LOOP_INDEX;
+      engine::Bitboard to = attacks(piece, from, occupied) & ~occupied;
+
+      BITLOOP(to) {
+        if (legal(piece, from, LOOP_INDEX)) {
+          return true;
+        }
+      }
+    }
+  }
+
+  int push = us == engine::WHITE ? 8 : -8;
+  engine::Bitboard start =
+      us == engine::WHITE ? engine::kRank2 : engine::kRank7;
+
+  BITLOOP(board.pieces[us][engine::PAWN]) {
+    int from = LOOP_INDEX;
+    int to = from + push;
+
+    if (occupied & engine::square::BB(to)) {
+      continue;
+    }
+
+    if (legal(engine::PAWN, from, to)) {
+      return true;
+    }
+
+    if (engine::square::BB(from) & start &&
+        !(occupied & engine::square::BB(to + push)) &&
+        legal(engine::PAWN, from, to + push)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// INFO: a capture can't give en passant rights, so they only matter at the
+// position probe_wdl was called with
+static int probe_ab(const TBBoard &board, int alpha, int beta, int *success) {
+  TBCapture captures[MAX_MOVES_BUFFER_SIZE];
+  int count = generate_captures(board, captures);
   int v;
-  const auto move_list = pos.LegalMoves();
 
-  for (auto const &move : move_list) {
-    if (!move.Is(engine::move::CAPTURE)) {
+  for (int i = 0; i < count; i++) {
+    TBBoard next = board;
+
+    make_capture(&next, captures[i]);
+
+    if (king_attacked(next)) {
       continue;
     }
 
-    pos.Make(move);
-    v = -probe_ab(pos, -beta, -alpha, success);
-    pos.Undo(move);
+    v = -probe_ab(next, -beta, -alpha, success);
 
     if (*success == 0) {
       return 0;
@@ -389,7 +615,7 @@ static int probe_ab(Position &pos, int alpha, int beta, int *success) {
     }
   }
 
-  v = probe_wdl_table(pos, success);
+  v = probe_wdl_table(board, success);
 
   return alpha >= v ? alpha : v;
 }
@@ -409,10 +635,12 @@ static int probe_ab(Position &pos, int alpha, int beta, int *success) {
 //  0 : draw
 //  1 : win, but draw under 50-move rule
 //  2 : win
-int probe_wdl(Position &pos, int *success) {
+int probe_wdl(const Position &pos, int *success) {
   *success = 1;
 
-  const auto move_list = pos.LegalMoves();
+  TBBoard board = to_board(pos);
+  TBCapture captures[MAX_MOVES_BUFFER_SIZE];
+  int count = generate_captures(board, captures);
 
   int best_cap = -3, best_ep = -3;
 
@@ -420,14 +648,16 @@ int probe_wdl(Position &pos, int *success) {
   // capture without ep rights and letting best_ep keep track of still
   // better ep captures if they exist.
 
-  for (const auto &move : move_list) {
-    if (!move.Is(engine::move::CAPTURE)) {
+  for (int i = 0; i < count; i++) {
+    TBBoard next = board;
+
+    make_capture(&next, captures[i]);
+
+    if (king_attacked(next)) {
       continue;
     }
 
-    pos.Make(move);
-    int v = -probe_ab(pos, -2, -best_cap, success);
-    pos.Undo(move);
+    int v = -probe_ab(next, -2, -best_cap, success);
 
     if (*success == 0) return 0;
     if (v > best_cap) {
@@ -436,7 +666,7 @@ int probe_wdl(Position &pos, int *success) {
         return 2;
       }
 
-      if (!move.Is(engine::move::EN_PASSANT)) {
+      if (!captures[i].en_passant) {
         best_cap = v;
       } else if (v > best_ep) {
         best_ep = v;
@@ -444,7 +674,10 @@ int probe_wdl(Position &pos, int *success) {
     }
   }
 
-  int v = probe_wdl_table(pos, success);
+  // INFO: a legal capture without ep rights rules out the stalemate below
+  bool other_captures = best_cap > -3;
+
+  int v = probe_wdl_table(board, success);
   if (*success == 0) return 0;
 
   // Now max(v, best_cap) is the WDL value of the position without ep rights.
@@ -471,35 +704,90 @@ int probe_wdl(Position &pos, int *success) {
     return best_cap;
   }
 
-  // TODO: handle stalemate case
-  // Now handle the stalemate case.
-  // if (best_ep > -3 && v == 0) {
-  //   // Check for stalemate in the position with ep captures.
-  //   for (const auto &move : move_list) {
-  //     if (move.Is(engine::move::EN_PASSANT)) {
-  //       continue;
-  //     }
-  //     if (pos.legal(move, ci.pinned)) break;
-  //   }
-  //
-  //   if (moves == end && !pos.checkers()) {
-  //     end = generate<QUIETS>(pos, end);
-  //     for (; moves < end; moves++) {
-  //       Move move = moves->move;
-  //       if (pos.legal(move, ci.pinned)) break;
-  //     }
-  //   }
-  //   if (moves == end) {  // Stalemate detected.
-  //     *success = 2;
-  //     return best_ep;
-  //   }
-  // }
+  // Now handle the stalemate case: without its ep rights the position has
+  // no legal move.
+  if (best_ep > -3 && v == 0 && !other_captures && !has_quiet_move(board)) {
+    *success = 2;
+    return best_ep;
+  }
 
   // Stalemate / en passant not an issue, so v is the correct value.
 
   return v;
 }
 
+// The previous probe_wdl on the full legal move generator & Make/Undo, kept
+// as the baseline of tb_bench & the tests. Its en passant captures are never
+// flagged as captures, so it ignores them.
+static int probe_ab_reference(Position &pos, int alpha, int beta,
+                              int *success) {
+  int v;
+  const auto move_list = pos.LegalMoves();
+
+  for (auto const &move : move_list) {
+    if (!move.Is(engine::move::CAPTURE)) {
+      continue;
+    }
+
+    pos.Make(move);
+    v = -probe_ab_reference(pos, -beta, -alpha, success);
+    pos.Undo(move);
+
+    if (*success == 0) {
+      return 0;
+    }
+
+    if (v > alpha) {
+      if (v >= beta) {
+        return v;
+      }
+
+      alpha = v;
+    }
+  }
+
+  v = probe_wdl_table(pos, success);
+
+  return alpha >= v ? alpha : v;
+}
+
+int probe_wdl_reference(Position &pos, int *success) {
+  *success = 1;
+
+  const auto move_list = pos.LegalMoves();
+  int best_cap = -3;
+
+  for (const auto &move : move_list) {
+    if (!move.Is(engine::move::CAPTURE)) {
+      continue;
+    }
+
+    pos.Make(move);
+    int v = -probe_ab_reference(pos, -2, -best_cap, success);
+    pos.Undo(move);
+
+    if (*success == 0) return 0;
+    if (v > best_cap) {
+      if (v == 2) {
+        *success = 2;
+        return 2;
+      }
+
+      best_cap = v;
+    }
+  }
+
+  int v = probe_wdl_table(pos, success);
+  if (*success == 0) return 0;
+
+  if (best_cap >= v) {
+    *success = 1 + (best_cap > 0);
+    return best_cap;
+  }
+
+  return v;
+}
+
 static int wdl_to_dtz[] = {-1, -101, 0, 101, 1};
 
 // Probe the DTZ table for a particular position.
@@ -618,3 +906,117 @@ int probe_dtz(Position &pos, int *success) {
   }
   return best;
 }
+
+// Use the DTZ tables to filter out moves that don't preserve the win or draw.
+// If the position is lost, but DTZ is fairly high, only keep moves that
+// maximise DTZ.
+//
+// A return value of 0 indicates that not all probes were successful and that
+// no moves were filtered out. Otherwise *wdl is the value of the position from
+// the point of view of the side to move, taking the 50-move counter into
+// account.
+int root_probe(Position &pos, engine::MoveList &moves, int *wdl) {
+  int success;
+
+  int dtz = probe_dtz(pos, &success);
+  if (!success) return 0;
+
+  // Probe each move.
+  for (auto &move : moves) {
+    pos.Make(move);
+    int v = 0;
+
+    if (pos.Masks().checkers && dtz > 0) {
+      if (pos.LegalMoves().empty()) v = 1;
+    }
+
+    if (!v) {
+      if (pos.HalfmoveClock() != 0) {
+        v = -probe_dtz(pos, &success);
+        if (v > 0)
+          v++;
+        else if (v < 0)
+          v--;
+      } else {
+        v = -probe_wdl(pos, &success);
+        v = wdl_to_dtz[v + 2];
+      }
+    }
+
+    pos.Undo(move);
+    if (!success) return 0;
+    move.score = v;
+  }
+
+  // Obtain 50-move counter for the root position.
+  int cnt50 = pos.HalfmoveClock();
+
+  // Use 50-move counter to determine whether the root position is
+  // won, lost or drawn.
+  *wdl = 0;
+  if (dtz > 0)
+    *wdl = (dtz + cnt50 <= 100) ? 2 : 1;
+  else if (dtz < 0)
+    *wdl = (-dtz + cnt50 <= 100) ? -2 : -1;
+
+  // Now be a bit smart about filtering out moves.
+  if (dtz > 0) {  // winning (or 50-move rule draw)
+    int best = 0xffff;
+    for (const auto &move : moves) {
+      if (move.score > 0 && move.score < best) best = move.score;
+    }
+
+    // The search doesn't detect repetitions, so instead of every move that
+    // stays within the 50-move budget only the ones making progress are kept.
+    std::erase_if(moves, [best](const engine::Move &move) {
+      return move.score <= 0 || move.score > best;
+    });
+  } else if (dtz < 0) {
+    int best = 0;
+    for (const auto &move : moves) {
+      if (move.score < best) best = move.score;
+    }
+
+    // Try all moves, unless we approach or have a 50-move rule draw.
+    if (-best * 2 + cnt50 < 100) return 1;
+
+    std::erase_if(moves, [best](const engine::Move &move) {
+      return move.score != best;
+    });
+  } else {  // drawing
+    // Try all moves that preserve the draw.
+    std::erase_if(moves,
+                  [](const engine::Move &move) { return move.score != 0; });
+  }
+
+  return 1;
+}
+
+// Use the WDL tables to filter out moves that don't preserve the win or draw.
+// This is a fallback for the case that some or all DTZ tables are missing.
+//
+// A return value of 0 indicates that not all probes were successful and that
+// no moves were filtered out.
+int root_probe_wdl(Position &pos, engine::MoveList &moves, int *wdl) {
+  int success;
+
+  int best = probe_wdl(pos, &success);
+  if (!success) return 0;
+
+  // Probe each move.
+  for (auto &move : moves) {
+    pos.Make(move);
+    int v = -probe_wdl(pos, &success);
+    pos.Undo(move);
+    if (!success) return 0;
+    move.score = v;
+  }
+
+  *wdl = best;
+
+  std::erase_if(moves, [best](const engine::Move &move) {
+    return move.score != best;
+  });
+
+  return 1;
+}
@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "engine/datagen.hpp"
+#include "engine/options.hpp"
+#include "engine/position.hpp"
+#include "engine/syzygy.hpp"
+#include "engine/types.hpp"
+#include "tb/tbprobe.h"
+
+using namespace engine;
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  std::string tb;
+  std::string material = "KQvK,KRvK,KPvK,KBNvK,KRvKB,KRvKN,KQvKR,KRPvKR,KQPvKQ";
+  std::string threads = "1,2,4,8";
+  std::size_t positions = 1 << 16;
+  int rounds = 4;
+  int warmup = 0;
+};
+
+static void Usage(const char *program) {
+  std::printf(
+      "usage: %s --tb <paths> [options]\n"
+      "  --tb <paths>        syzygy directories, separated by ':'\n"
+      "  --material <sigs>   signatures to probe, separated by ','\n"
+      "  --threads <list>    thread counts to compare, separated by ','\n"
+      "  --positions <n>     random positions, spread over the signatures\n"
+      "  --rounds <n>        times every thread probes the positions\n"
+      "  --warmup <pieces>   pre-faults the tables before probing them\n",
+      program);
+}
+
+static bool ParseArgs(Config *config, int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--tb" && has_value) {
+      config->tb = argv[++i];
+    } else if (arg == "--material" && has_value) {
+      config->material = argv[++i];
+    } else if (arg == "--threads" && has_value) {
+      config->threads = argv[++i];
+    } else if (arg == "--positions" && has_value) {
+      config->positions = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--rounds" && has_value) {
+      config->rounds = std::atoi(argv[++i]);
+    } else if (arg == "--warmup" && has_value) {
+      config->warmup = std::atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+
+  return !config->tb.empty() && config->positions > 0 && config->rounds > 0;
+}
+
+static std::vector<std::string> Split(std::string_view list) {
+  std::vector<std::string> items;
+
+  while (!list.empty()) {
+    std::size_t comma = list.find(',');
+
+    if (comma > 0) {
+      items.emplace_back(list.substr(0, comma));
+    }
+
+    list.remove_prefix(comma == std::string_view::npos ? list.size()
+                                                       : comma + 1);
+  }
+
+  return items;
+}
+
+static double Elapsed(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool RandomPositions(const Config &config,
+                            std::vector<Position> *positions) {
+  std::vector<Material> materials;
+  std::mt19937 rng(2024);
+  std::uniform_int_distribution<int> squares(0, 63);
+
+  for (const std::string &signature : Split(config.material)) {
+    Material material;
+
+    if (!ParseMaterial(&material, signature) || material.size > TBlargest) {
+      std::fprintf(stderr, "no tables for %s\n", signature.c_str());
+      return false;
+    }
+
+    materials.push_back(material);
+  }
+
+  if (materials.empty()) {
+    return false;
+  }
+
+  while (positions->size() < config.positions) {
+    const Material &material = materials[positions->size() % materials.size()];
+    position::Placement placement;
+    Position position;
+
+    for (int i = 0; i < material.size;) {
+      i += placement.Add(material.colors[i], material.pieces[i],
+                         squares(rng));
+    }
+
+    placement.turn = rng() & 1 ? BLACK : WHITE;
+
+    if (Position::ApplyPlacement(&position, placement)) {
+      positions->push_back(position);
+    }
+  }
+
+  return true;
+}
+
+// Probes every position `rounds` times from each of `threads` threads, each
+// one starting at a different offset. Returns the failed probes.
+static std::size_t Probe(const std::vector<Position> &positions, int threads,
+                         int rounds) {
+  std::atomic<std::size_t> failed = 0;
+  std::vector<std::thread> pool;
+
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back([&, t]() {
+      std::size_t offset = t * positions.size() / threads;
+      std::size_t count = 0;
+
+      for (int round = 0; round < rounds; round++) {
+        for (std::size_t j = 0; j < positions.size(); j++) {
+          int success;
+
+          // INFO: the threads probe the shared positions in place
+          probe_wdl(positions[(j + offset) % positions.size()], &success);
+          count += !success;
+        }
+      }
+
+      failed += count;
+    });
+  }
+
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+
+  return failed;
+}
+
+int main(int argc, char **argv) {
+  Config config;
+  std::vector<Position> positions;
+
+  if (!ParseArgs(&config, argc, argv)) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  options.syzygy_warmup = config.warmup;
+
+  Clock::time_point start = Clock::now();
+
+  syzygy::Init(config.tb);
+
+  double startup = Elapsed(start);
+
+  if (!RandomPositions(config, &positions)) {
+    return 1;
+  }
+
+  // INFO: the warmup runs from the end of Init
+  int warmed = syzygy::JoinWarmup();
+  double warmup = Elapsed(start) - startup;
+
+  // INFO: maps the table of the position unless the warmup did
+  int success;
+
+  start = Clock::now();
+  probe_wdl(positions[0], &success);
+
+  double first = Elapsed(start);
+
+  std::printf(
+      "startup=%.3fms warmup=%.3fs (%d table(s)) first-probe=%.1fus\n",
+      startup * 1e3, warmup, warmed, first * 1e6);
+  std::printf("%lu position(s), %d round(s)\n", positions.size(),
+              config.rounds);
+
+  std::size_t failed = !success;
+
+  for (const std::string &count : Split(config.threads)) {
+    int threads = std::atoi(count.c_str());
+
+    if (threads <= 0) {
+      continue;
+    }
+
+    // INFO: the first pass maps every table again unless they were warmed,
+    // the threads contend for their first probes
+    syzygy::Init(config.tb);
+    syzygy::JoinWarmup();
+
+    start = Clock::now();
+
+    failed += Probe(positions, threads, 1);
+
+    double cold = Elapsed(start);
+
+    unsigned long long hits;
+    unsigned long long misses;
+
+    tb_reset_block_stats();
+
+    start = Clock::now();
+    failed += Probe(positions, threads, config.rounds);
+
+    double warm = Elapsed(start);
+    double probes =
+        static_cast<double>(positions.size()) * threads * config.rounds;
+
+    tb_block_stats(&hits, &misses);
+
+    // INFO: latency of a single probe, the threads probe side by side
+    std::printf(
+        "threads=%-3d cold=%.3fs warm=%.3fs probes/s=%.0f latency=%.0fns",
+        threads, cold, warm, probes / warm, warm * threads / probes * 1e9);
+
+#ifdef TB_STATS
+    std::printf(" block-hits=%.1f%%",
+                100.0 * hits / std::max(hits + misses, 1ULL));
+#endif
+
+    std::printf("\n");
+  }
+
+  // INFO: single-threaded, against the probes on the full move generator
+  std::vector<int> results(positions.size());
+  std::vector<Position> copies = positions;
+  std::size_t mismatches = 0;
+  double total = static_cast<double>(positions.size()) * config.rounds;
+
+  start = Clock::now();
+
+  for (int round = 0; round < config.rounds; round++) {
+    for (std::size_t i = 0; i < positions.size(); i++) {
+      results[i] = probe_wdl(positions[i], &success);
+    }
+  }
+
+  double captures = Elapsed(start);
+
+  start = Clock::now();
+
+  for (int round = 0; round < config.rounds; round++) {
+    for (std::size_t i = 0; i < copies.size(); i++) {
+      mismatches += probe_wdl_reference(copies[i], &success) != results[i];
+    }
+  }
+
+  double reference = Elapsed(start);
+
+  std::printf("captures  time=%.3fs probes/s=%.0f\n", captures,
+              total / captures);
+  std::printf("reference time=%.3fs probes/s=%.0f\n", reference,
+              total / reference);
+  std::printf("%lu failed probe(s), %lu mismatch(es)\n", failed,
+              mismatches / config.rounds);
+
+  return failed != 0 || mismatches != 0;
+}
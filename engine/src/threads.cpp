@@ -1,10 +1,136 @@
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 
 #include "engine/threads.hpp"
 
-void SpinLock::Lock() {
-  while (atomic_flag_.test_and_set(std::memory_order_acquire)) {
+// spins between two checks of the lock once the backoff is saturated
+#define SPIN_LOCK_MAX_BACKOFF 64
+
+static std::mutex sites_mutex;
+
+static std::vector<LockSite *> &Sites() {
+  static std::vector<LockSite *> sites;
+
+  return sites;
+}
+
+static inline void Pause() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+LockSite::LockSite(const char *name) : name(name) {
+  std::lock_guard lock(sites_mutex);
+
+  Sites().push_back(this);
+}
+
+LockSite::~LockSite() {
+  std::lock_guard lock(sites_mutex);
+
+  std::erase(Sites(), this);
+}
+
+void LockSite::Reset() {
+  std::lock_guard lock(sites_mutex);
+
+  for (LockSite *site : Sites()) {
+    site->acquisitions = 0;
+    site->contentions = 0;
+    site->spins = 0;
+    site->max_wait = 0;
+  }
+}
+
+std::string LockSite::Report() {
+#ifdef LOCK_STATS
+  std::string str;
+  std::lock_guard lock(sites_mutex);
+
+  for (LockSite *site : Sites()) {
+    std::uint64_t acquisitions = site->acquisitions.load();
+    std::uint64_t contentions = site->contentions.load();
+
+    if (acquisitions == 0) {
+      continue;
+    }
+
+    str.append(std::format(
+        "lock {}: acquisitions={} contended={} ({:.2f}%) spins={} "
+        "max wait={}ns\n",
+        site->name, acquisitions, contentions,
+        100.0 * contentions / acquisitions, site->spins.load(),
+        site->max_wait.load()));
   }
+
+  return str;
+#else
+  return "lock statistics are disabled, build with LOCK_STATS\n";
+#endif
 }
 
-void SpinLock::Unlock() { atomic_flag_.clear(std::memory_order_release); }
+#ifdef LOCK_STATS
+SpinLock::SpinLock(LockSite *site) : site_(site) {}
+#else
+SpinLock::SpinLock(LockSite *) {}
+#endif
+
+void SpinLock::Contend() {
+  int backoff = 1;
+  std::uint64_t spins = 0;
+
+#ifdef LOCK_STATS
+  auto start = std::chrono::steady_clock::now();
+#endif
+
+  do {
+    while (locked_.load(std::memory_order_relaxed)) {
+      for (int i = 0; i < backoff; i++) {
+        Pause();
+      }
+
+      spins++;
+
+      if (backoff < SPIN_LOCK_MAX_BACKOFF) {
+        backoff <<= 1;
+      } else {
+        // INFO: the holder is likely descheduled, more threads than cores
+        std::this_thread::yield();
+      }
+    }
+  } while (locked_.exchange(true, std::memory_order_acquire));
+
+#ifdef LOCK_STATS
+  if (site_ == nullptr) {
+    return;
+  }
+
+  std::uint64_t wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  std::uint64_t max_wait = site_->max_wait.load(std::memory_order_relaxed);
+
+  while (wait > max_wait && !site_->max_wait.compare_exchange_weak(
+                                max_wait, wait, std::memory_order_relaxed)) {
+  }
+
+  site_->acquisitions.fetch_add(1, std::memory_order_relaxed);
+  site_->contentions.fetch_add(1, std::memory_order_relaxed);
+  site_->spins.fetch_add(spins, std::memory_order_relaxed);
+#else
+  (void)spins;
+#endif
+}
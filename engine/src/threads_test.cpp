@@ -0,0 +1,44 @@
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/threads.hpp"
+
+TEST(SpinLockTestSuite, MutualExclusion) {
+  SpinLock spin;
+  std::uint64_t count = 0;
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 20000; j++) {
+        spin.Lock();
+        count++;
+        spin.Unlock();
+      }
+    });
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(count, 160000u);
+}
+
+#ifdef LOCK_STATS
+TEST(SpinLockTestSuite, CountsAcquisitions) {
+  LockSite site("test");
+  SpinLock spin(&site);
+
+  for (int i = 0; i < 10; i++) {
+    spin.Lock();
+    spin.Unlock();
+  }
+
+  ASSERT_EQ(site.acquisitions.load(), 10u);
+  ASSERT_EQ(site.contentions.load(), 0u);
+}
+#endif
@@ -1,3 +1,5 @@
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 
 #include "engine/position.hpp"
@@ -7,18 +9,26 @@
 
 namespace engine {
 
-TT::TT(std::size_t size) { Resize(size); };
+LockSite TTEntry::lock_site("tt entry");
 
-void TT::Resize(std::size_t size) {
+static std::size_t FloorPowerOfTwo(std::size_t size) {
   if (size & (size - 1)) {
     size--;
-    for (int i = 1; i < 32; i = i * 2) {
+    for (int i = 1; i < 64; i = i * 2) {
       size |= size >> i;
     }
     size++;
     size >>= 1;
   }
 
+  return size;
+}
+
+TT::TT(std::size_t size) { Resize(size); };
+
+void TT::Resize(std::size_t size) {
+  size = FloorPowerOfTwo(size);
+
   if (size < sizeof(TTEntry)) {
     size_ = 0;
     return;
@@ -43,7 +53,11 @@ void TT::Add(Position &position, int depth, int score, const Move &best_move,
 
   entry.spin.Lock();
 
-  if (entry.hash == hash &&
+  // INFO: a deeper entry without a move, e.g. a tablebase probe, still makes
+  // way for a searched one so the root keeps its best move
+  bool moveless = entry.best_move.piece == NONE && best_move.piece != NONE;
+
+  if (entry.hash == hash && !moveless &&
       (entry.depth > depth || entry.age > position.halfmove_clock_)) {
     entry.spin.Unlock();
     return;
@@ -98,4 +112,71 @@ bool TT::CutOff(Position &position, int depth, int alpha, int beta,
   return false;
 }
 
+PerftTT::PerftTT(std::size_t size) { Resize(size); }
+
+void PerftTT::Resize(std::size_t size) {
+  size = FloorPowerOfTwo(size);
+
+  // INFO: entries are grouped in pairs, a depth-preferred slot followed by an
+  // always-replace slot.
+  if (size < 2 * sizeof(PerftTTEntry)) {
+    size_ = 0;
+    entries_.clear();
+    return;
+  }
+
+  size_ = (size / sizeof(PerftTTEntry)) - 1;
+  entries_.assign(size_ + 1, PerftTTEntry{});
+}
+
+void PerftTT::Clear() noexcept {
+  for (PerftTTEntry &entry : entries_) {
+    entry.key = 0;
+    entry.data = 0;
+  }
+}
+
+void PerftTT::Add(const Position &position, int depth, std::uint64_t nodes) {
+  if (entries_.empty()) {
+    return;
+  }
+
+  std::uint64_t hash = position.hash_;
+  PerftTTEntry *bucket = &entries_[hash & size_ & ~static_cast<std::size_t>(1)];
+  std::uint64_t data = (nodes << 8) | static_cast<std::uint8_t>(depth);
+
+  std::atomic_ref<std::uint64_t> preferred(bucket[0].data);
+  int preferred_depth =
+      static_cast<int>(preferred.load(std::memory_order_relaxed) & 0xff);
+  PerftTTEntry *entry = preferred_depth <= depth ? &bucket[0] : &bucket[1];
+
+  std::atomic_ref<std::uint64_t>(entry->key)
+      .store(hash ^ data, std::memory_order_relaxed);
+  std::atomic_ref<std::uint64_t>(entry->data)
+      .store(data, std::memory_order_relaxed);
+}
+
+bool PerftTT::Probe(const Position &position, int depth, std::uint64_t *nodes) {
+  if (entries_.empty()) {
+    return false;
+  }
+
+  std::uint64_t hash = position.hash_;
+  PerftTTEntry *bucket = &entries_[hash & size_ & ~static_cast<std::size_t>(1)];
+
+  for (int i = 0; i < 2; i++) {
+    std::uint64_t key = std::atomic_ref<std::uint64_t>(bucket[i].key)
+                            .load(std::memory_order_relaxed);
+    std::uint64_t data = std::atomic_ref<std::uint64_t>(bucket[i].data)
+                             .load(std::memory_order_relaxed);
+
+    if ((key ^ data) == hash && static_cast<int>(data & 0xff) == depth) {
+      *nodes = data >> 8;
+      return true;
+    }
+  }
+
+  return false;
+}
+
 }  // namespace engine
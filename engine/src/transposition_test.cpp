@@ -106,3 +106,53 @@ TEST_F(TranspositionTestSuite, TestApplyBetaCutOff) {
   ASSERT_EQ(score, 25);
   ASSERT_FALSE(tt.CutOff(position, 8, -50, 20, &best_move, &score));
 }
+
+TEST(PerftTTTestSuite, TestAddEntry) {
+  std::uint64_t nodes;
+  PerftTT tt(1024 * sizeof(PerftTTEntry));
+  Position position = Position::FromFen(kStartPos);
+
+  ASSERT_FALSE(tt.Probe(position, 3, &nodes));
+
+  tt.Add(position, 3, 8902);
+
+  ASSERT_TRUE(tt.Probe(position, 3, &nodes));
+  ASSERT_EQ(nodes, 8902);
+  ASSERT_FALSE(tt.Probe(position, 4, &nodes));
+}
+
+TEST(PerftTTTestSuite, TestKeepsDeeperEntry) {
+  std::uint64_t nodes;
+  PerftTT tt(1024 * sizeof(PerftTTEntry));
+  Position position = Position::FromFen(kStartPos);
+
+  tt.Add(position, 5, 4865609);
+  tt.Add(position, 2, 400);
+  tt.Add(position, 3, 8902);
+
+  ASSERT_TRUE(tt.Probe(position, 5, &nodes));
+  ASSERT_EQ(nodes, 4865609);
+  ASSERT_TRUE(tt.Probe(position, 3, &nodes));
+  ASSERT_EQ(nodes, 8902);
+  ASSERT_FALSE(tt.Probe(position, 2, &nodes));
+}
+
+TEST(PerftTTTestSuite, TestTranspositionsShareEntry) {
+  std::uint64_t nodes;
+  PerftTT tt(1024 * sizeof(PerftTTEntry));
+  Position position = Position::FromFen(kStartPos);
+
+  int moves[][2] = {{g1, f3}, {g8, f6}, {b1, c3}, {b8, c6}};
+
+  for (auto [from, to] : moves) {
+    position.Make(DeduceMove(position, from, to));
+  }
+
+  tt.Add(position, 2, 1234);
+
+  Position other = Position::FromFen(
+      "r1bqkb1r/pppppppp/2n2n2/8/8/2N2N2/PPPPPPPP/R1BQKB1R w KQkq - 4 3");
+
+  ASSERT_TRUE(tt.Probe(other, 2, &nodes));
+  ASSERT_EQ(nodes, 1234);
+}
@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "engine/evaluation.hpp"
+#include "engine/position.hpp"
+#include "engine/scheduler.hpp"
+#include "engine/score.hpp"
+#include "engine/tuner.hpp"
+#include "engine/weights.hpp"
+
+namespace engine {
+
+// INFO: comments emitted above the weights, same as the hand-written header
+static const std::pair<int, const char *> kWeightGroups[] = {
+    {ROOK, "materials"},
+    {BISHOP_PAIR, "bishop pair values"},
+    {DOUBLED_PAWNS, "pawns structure"},
+    {TEMPO, "tempo"},
+    {KNIGHT_MOBILITY, "knight mobility"},
+    {BISHOP_MOBILITY, "bishop mobility"},
+    {ROOK_MOBILITY, "rook mobility"},
+    {CLOSED_FILE, "file"},
+    {ROOK_ON_7th, "7th rank"}};
+
+Tuner::Tuner(Scheduler *scheduler)
+    : scheduler_(scheduler),
+      momentum_{},
+      velocity_{},
+      epoch_(0),
+      k_(1.0) {
+  for (int i = 0; i < WEIGHTS; i++) {
+    weights_[i][0] = OpeningValue(kWeights[i]);
+    weights_[i][1] = EndgameValue(kWeights[i]);
+  }
+}
+
+void Tuner::Add(Position &position, double result) {
+  EvalTrace trace;
+  int score = Evaluate(position, &trace);
+  int phase = EvalState::For(position, false).phase;
+  TunerEntry entry = {static_cast<std::uint32_t>(features_.size()), 0,
+                      static_cast<std::int16_t>(phase), 0,
+                      static_cast<float>(result)};
+
+  for (int i = 0; i < WEIGHTS; i++) {
+    if (trace.coefficients[i] == 0) {
+      continue;
+    }
+
+    features_.push_back({static_cast<std::uint16_t>(i),
+                         static_cast<std::int16_t>(trace.coefficients[i])});
+    entry.size++;
+  }
+
+  entries_.push_back(entry);
+
+  // whatever the weights don't explain stays constant while tuning
+  entries_.back().base = score - Predict(entries_.back());
+}
+
+bool Tuner::Load(const std::string &path) {
+  std::string line;
+  std::ifstream file(path);
+
+  if (!file) {
+    return false;
+  }
+
+  std::vector<std::string> lines;
+
+  while (std::getline(file, line)) {
+    lines.push_back(std::move(line));
+  }
+
+  // INFO: every chunk is traced by a tuner of its own, merged afterwards
+  std::size_t chunks =
+      std::min<std::size_t>(lines.size(), 4 * scheduler_->Size());
+  std::vector<Tuner> tuners(chunks, Tuner(scheduler_));
+
+  scheduler_->ParallelFor(
+      0, chunks,
+      [&](std::size_t chunk) {
+        std::string fen;
+        double result;
+
+        for (std::size_t i = chunk; i < lines.size(); i += chunks) {
+          if (ParseLabelled(&fen, &result, lines[i])) {
+            Position position = Position::FromFen(fen);
+
+            tuners[chunk].Add(position, result);
+          }
+        }
+      },
+      1);
+
+  for (Tuner &tuner : tuners) {
+    std::uint32_t offset = features_.size();
+
+    for (TunerEntry entry : tuner.entries_) {
+      entry.offset += offset;
+      entries_.push_back(entry);
+    }
+
+    features_.insert(features_.end(), tuner.features_.begin(),
+                     tuner.features_.end());
+  }
+
+  return true;
+}
+
+double Tuner::Predict(const TunerEntry &entry) const {
+  double opening = 0;
+  double endgame = 0;
+
+  for (std::uint32_t i = entry.offset; i < entry.offset + entry.size; i++) {
+    const TunerFeature &feature = features_[i];
+
+    opening += feature.coefficient * weights_[feature.index][0];
+    endgame += feature.coefficient * weights_[feature.index][1];
+  }
+
+  return entry.base +
+         (opening * (256 - entry.phase) + endgame * entry.phase) / 256;
+}
+
+static inline double Sigmoid(double k, double score) {
+  return 1 / (1 + std::pow(10.0, -k * score / 400));
+}
+
+double Tuner::Error(double k) const {
+  std::size_t chunks = 4 * scheduler_->Size();
+  std::vector<double> errors(chunks);
+
+  scheduler_->ParallelFor(
+      0, chunks,
+      [&](std::size_t chunk) {
+        double sum = 0;
+
+        for (std::size_t i = chunk; i < entries_.size(); i += chunks) {
+          double error =
+              entries_[i].result - Sigmoid(k, Predict(entries_[i]));
+
+          sum += error * error;
+        }
+
+        // INFO: adjacent chunks share a cache line, write them once
+        errors[chunk] = sum;
+      },
+      1);
+
+  double total = 0;
+
+  for (double error : errors) {
+    total += error;
+  }
+
+  return entries_.empty() ? 0 : total / entries_.size();
+}
+
+double Tuner::Error() const { return Error(k_); }
+
+// INFO: the error is convex in k, every pass narrows the range tenfold
+// around the best value.
+double Tuner::FitK() {
+  double start = 0;
+  double end = 10;
+  double step = 1;
+
+  for (int pass = 0; pass < 6; pass++) {
+    double best = Error(start);
+
+    for (double k = start; k <= end; k += step) {
+      double error = Error(k);
+
+      if (error <= best) {
+        best = error;
+        k_ = k;
+      }
+    }
+
+    start = std::max(0.0, k_ - step);
+    end = k_ + step;
+    step /= 10;
+  }
+
+  return k_;
+}
+
+void Tuner::Gradient(double gradient[WEIGHTS][2]) const {
+  std::size_t chunks = 4 * scheduler_->Size();
+  std::vector<double> partials(chunks * WEIGHTS * 2);
+
+  scheduler_->ParallelFor(
+      0, chunks,
+      [&](std::size_t chunk) {
+        double *partial = &partials[chunk * WEIGHTS * 2];
+
+        for (std::size_t i = chunk; i < entries_.size(); i += chunks) {
+          const TunerEntry &entry = entries_[i];
+          double sigmoid = Sigmoid(k_, Predict(entry));
+
+          // derivative of (result - sigmoid)^2 with respect to the score
+          double slope = -2 * (entry.result - sigmoid) * sigmoid *
+                         (1 - sigmoid) * k_ * std::log(10.0) / 400;
+          double opening = slope * (256 - entry.phase) / 256;
+          double endgame = slope * entry.phase / 256;
+
+          for (std::uint32_t j = entry.offset; j < entry.offset + entry.size;
+               j++) {
+            const TunerFeature &feature = features_[j];
+
+            partial[feature.index * 2] += opening * feature.coefficient;
+            partial[feature.index * 2 + 1] += endgame * feature.coefficient;
+          }
+        }
+      },
+      1);
+
+  for (int i = 0; i < WEIGHTS; i++) {
+    gradient[i][0] = 0;
+    gradient[i][1] = 0;
+
+    for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+      gradient[i][0] += partials[chunk * WEIGHTS * 2 + i * 2];
+      gradient[i][1] += partials[chunk * WEIGHTS * 2 + i * 2 + 1];
+    }
+
+    gradient[i][0] /= entries_.size();
+    gradient[i][1] /= entries_.size();
+  }
+}
+
+double Tuner::Train(int epochs, double rate) {
+  double gradient[WEIGHTS][2];
+
+  if (entries_.empty()) {
+    return 0;
+  }
+
+  for (int epoch = 0; epoch < epochs; epoch++) {
+    Gradient(gradient);
+
+    epoch_++;
+
+    double beta1 = 1 - std::pow(TUNER_BETA1, epoch_);
+    double beta2 = 1 - std::pow(TUNER_BETA2, epoch_);
+
+    for (int i = 0; i < WEIGHTS; i++) {
+      for (int j = 0; j < 2; j++) {
+        double &momentum = momentum_[i][j];
+        double &velocity = velocity_[i][j];
+
+        momentum = TUNER_BETA1 * momentum + (1 - TUNER_BETA1) * gradient[i][j];
+        velocity = TUNER_BETA2 * velocity +
+                   (1 - TUNER_BETA2) * gradient[i][j] * gradient[i][j];
+
+        weights_[i][j] -= rate * (momentum / beta1) /
+                          (std::sqrt(velocity / beta2) + TUNER_EPSILON);
+      }
+    }
+  }
+
+  return Error();
+}
+
+std::string Tuner::Header() const {
+  std::string str =
+      "#ifndef ENGINE_WEIGHTS_HPP\n"
+      "#define ENGINE_WEIGHTS_HPP\n"
+      "\n"
+      "#include \"score.hpp\"\n"
+      "\n"
+      "// INFO: regenerated by the tuner, indexed by the term ids of "
+      "evaluation.hpp\n"
+      "#define WEIGHTS 26\n"
+      "\n"
+      "namespace engine {\n"
+      "\n"
+      "// INFO: opening & endgame weights\n"
+      "// order of weights should corresponding with type::piece spec.\n"
+      "inline constexpr Score kWeights[WEIGHTS] = {\n";
+
+  for (int i = 0; i < WEIGHTS; i++) {
+    for (auto [index, group] : kWeightGroups) {
+      if (index == i) {
+        str.append(std::format("    // {}\n", group));
+      }
+    }
+
+    str.append(std::format("    MakeScore({}, {}),\n",
+                           static_cast<int>(std::lround(weights_[i][0])),
+                           static_cast<int>(std::lround(weights_[i][1]))));
+  }
+
+  str.append("};\n\ninline constexpr int kRankBonus[6] = {");
+
+  for (int i = 0; i < 6; i++) {
+    str.append(std::format("{}{}", i ? ", " : "", kRankBonus[i]));
+  }
+
+  str.append(
+      "};\n"
+      "\n"
+      "}  // namespace engine\n"
+      "\n"
+      "#endif\n");
+
+  return str;
+}
+
+bool ParseLabelled(std::string *fen, double *result, std::string_view line) {
+  std::size_t end;
+
+  if (std::size_t pos = line.find('['); pos != std::string_view::npos) {
+    std::string value(line.substr(pos + 1, line.find(']', pos) - pos - 1));
+    char *parsed;
+
+    *result = std::strtod(value.c_str(), &parsed);
+    end = pos;
+
+    if (parsed == value.c_str()) {
+      return false;
+    }
+  } else if (pos = line.find("c9 \""); pos != std::string_view::npos) {
+    std::string_view value = line.substr(pos + 4);
+
+    if (value.starts_with("1-0")) {
+      *result = 1;
+    } else if (value.starts_with("0-1")) {
+      *result = 0;
+    } else if (value.starts_with("1/2-1/2")) {
+      *result = 0.5;
+    } else {
+      return false;
+    }
+
+    end = pos;
+  } else {
+    return false;
+  }
+
+  // INFO: only the placement, side, castling & en passant fields are kept
+  std::string_view fields = line.substr(0, end);
+  int count = 0;
+
+  fen->clear();
+
+  while (count < 4) {
+    std::size_t start = fields.find_first_not_of(' ');
+
+    if (start == std::string_view::npos) {
+      break;
+    }
+
+    fields.remove_prefix(start);
+
+    std::size_t size = std::min(fields.find(' '), fields.size());
+
+    fen->append(fields.substr(0, size)).append(" ");
+    fields.remove_prefix(size);
+    count++;
+  }
+
+  fen->append("0 1");
+
+  return count == 4;
+}
+
+}  // namespace engine
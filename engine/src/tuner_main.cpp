@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "engine/scheduler.hpp"
+#include "engine/tuner.hpp"
+
+using namespace engine;
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  std::string data;
+  std::string out;
+  int threads = std::thread::hardware_concurrency();
+  int epochs = 1000;
+  int report = 100;
+  double rate = 1.0;
+  double k = 0;
+};
+
+static void Usage(const char *program) {
+  std::printf(
+      "usage: %s --data <file> [options]\n"
+      "  --data <file>    labelled positions, one fen with [1.0] or c9 "
+      "\"1-0\" per line\n"
+      "  --out <file>     where to write the weights header, defaults to "
+      "stdout\n"
+      "  --threads <n>    worker threads, defaults to the hardware threads\n"
+      "  --epochs <n>     passes of gradient descent over the positions\n"
+      "  --rate <r>       learning rate, in centipawns per epoch\n"
+      "  --k <k>          sigmoid scale, 0 fits it to the current weights\n"
+      "  --report <n>     epochs between two error reports\n",
+      program);
+}
+
+static bool ParseArgs(Config *config, int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--data" && has_value) {
+      config->data = argv[++i];
+    } else if (arg == "--out" && has_value) {
+      config->out = argv[++i];
+    } else if (arg == "--threads" && has_value) {
+      config->threads = std::atoi(argv[++i]);
+    } else if (arg == "--epochs" && has_value) {
+      config->epochs = std::atoi(argv[++i]);
+    } else if (arg == "--rate" && has_value) {
+      config->rate = std::atof(argv[++i]);
+    } else if (arg == "--k" && has_value) {
+      config->k = std::atof(argv[++i]);
+    } else if (arg == "--report" && has_value) {
+      config->report = std::atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+
+  return !config->data.empty() && config->threads > 0 &&
+         config->epochs >= 0 && config->report > 0 && config->rate > 0;
+}
+
+static double Elapsed(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+  Config config;
+
+  if (!ParseArgs(&config, argc, argv)) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  Scheduler scheduler(config.threads);
+  Tuner tuner(&scheduler);
+
+  scheduler.Init();
+
+  Clock::time_point start = Clock::now();
+
+  if (!tuner.Load(config.data)) {
+    std::fprintf(stderr, "unable to open %s\n", config.data.c_str());
+    return 1;
+  }
+
+  // INFO: progress goes to stderr, stdout may be the header
+  std::fprintf(stderr, "traced %lu position(s) in %.3fs\n", tuner.Size(),
+               Elapsed(start));
+
+  if (tuner.Size() == 0) {
+    return 1;
+  }
+
+  if (config.k > 0) {
+    tuner.SetK(config.k);
+  } else {
+    tuner.FitK();
+  }
+
+  std::fprintf(stderr, "k=%.4f error=%.6f\n", tuner.K(), tuner.Error());
+
+  start = Clock::now();
+
+  for (int epoch = 0; epoch < config.epochs; epoch += config.report) {
+    int epochs = std::min(config.report, config.epochs - epoch);
+    double error = tuner.Train(epochs, config.rate);
+
+    std::fprintf(stderr, "epoch %d error=%.6f time=%.3fs\n", epoch + epochs,
+                 error, Elapsed(start));
+  }
+
+  std::string header = tuner.Header();
+
+  if (config.out.empty()) {
+    std::fputs(header.c_str(), stdout);
+    return 0;
+  }
+
+  std::ofstream file(config.out);
+
+  if (!(file << header)) {
+    std::fprintf(stderr, "unable to write %s\n", config.out.c_str());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "engine/evaluation.hpp"
+#include "engine/move.hpp"
+#include "engine/position.hpp"
+#include "engine/scheduler.hpp"
+#include "engine/tuner.hpp"
+#include "engine/types.hpp"
+
+using namespace engine;
+
+class TunerTestSuite : public testing::Test {
+ protected:
+  Scheduler scheduler;
+  Tuner tuner;
+
+  TunerTestSuite() : scheduler(2), tuner(&scheduler) {}
+
+  void SetUp() override { scheduler.Init(); }
+};
+
+TEST_F(TunerTestSuite, ParseLabelled) {
+  std::string fen;
+  double result;
+
+  ASSERT_TRUE(ParseLabelled(
+      &fen, &result,
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [0.5]"));
+  ASSERT_EQ(fen, kStartPos);
+  ASSERT_EQ(result, 0.5);
+
+  ASSERT_TRUE(
+      ParseLabelled(&fen, &result,
+                    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - c9 \"0-1\";"));
+  ASSERT_EQ(fen, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+  ASSERT_EQ(result, 0);
+
+  ASSERT_TRUE(ParseLabelled(&fen, &result,
+                            "8/8/8/8/8/8/8/K6k b - - c9 \"1/2-1/2\";"));
+  ASSERT_EQ(result, 0.5);
+
+  ASSERT_FALSE(ParseLabelled(&fen, &result, kStartPos));
+  ASSERT_FALSE(ParseLabelled(&fen, &result, "8/8/8/8 [1.0]"));
+}
+
+TEST_F(TunerTestSuite, TraceCountsTerms) {
+  Position position = Position::FromFen(kStartPos);
+  EvalTrace trace;
+
+  Evaluate(position, &trace);
+
+  ASSERT_EQ(trace.coefficients[TEMPO], 1);
+  ASSERT_EQ(trace.coefficients[ROOK], 0);
+  ASSERT_EQ(trace.coefficients[KNIGHT_MOBILITY], 0);
+
+  // rook against pawn with the rooks on the 7th, black to move
+  position = Position::FromFen("4k3/RR5p/8/8/8/8/8/4K2r b - - 0 1");
+  trace = {};
+
+  Evaluate(position, &trace);
+
+  ASSERT_EQ(trace.coefficients[TEMPO], -1);
+  ASSERT_EQ(trace.coefficients[ROOK], 1);
+  ASSERT_EQ(trace.coefficients[PAWN], -1);
+  ASSERT_EQ(trace.coefficients[ROOK_ON_7th], 1);
+}
+
+TEST_F(TunerTestSuite, UntrainedWeightsRegenerateHeader) {
+  std::ifstream file(ENGINE_WEIGHTS_HEADER);
+  std::string header((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+
+  ASSERT_FALSE(header.empty());
+  ASSERT_EQ(tuner.Header(), header);
+}
+
+TEST_F(TunerTestSuite, TrainingLowersError) {
+  const char *fens[] = {
+      kStartPos,
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      "r1b1k2r/1pp2ppp/p1pb4/8/3PP3/2P2N2/PP3PPP/R1B1K2R b KQkq - 0 1"};
+
+  // INFO: labels that disagree with the material, the weights have to move
+  for (const char *fen : fens) {
+    Position position = Position::FromFen(fen);
+
+    for (Move &move : position.LegalMoves()) {
+      position.Make(move);
+      tuner.Add(position, position.Turn() == WHITE ? 0 : 1);
+      position.Undo(move);
+    }
+  }
+
+  tuner.SetK(1.0);
+
+  double before = tuner.Error();
+  double after = tuner.Train(50, 1.0);
+
+  ASSERT_LT(after, before);
+}
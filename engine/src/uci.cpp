@@ -1,43 +1,271 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <map>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+
 #include "uci/command.hpp"
 #include "uci/link.hpp"
+#include "uci/types.hpp"
 
+#include "engine/affinity.hpp"
+#include "engine/config.hpp"
+#include "engine/move_gen.hpp"
+#include "engine/network.hpp"
+#include "engine/options.hpp"
+#include "engine/perft.hpp"
+#include "engine/scheduler.hpp"
+#include "engine/search.hpp"
+#include "engine/syzygy.hpp"
+#include "engine/transposition.hpp"
+#include "engine/types.hpp"
 #include "engine/uci.hpp"
+#include "engine/utils.hpp"
+
+// INFO: default & largest Hash option values, in MB
+static constexpr std::int64_t kHashSize = 16;
+static constexpr std::int64_t kMaxHashSize = 4096;
+
+// INFO: moves left assumed when the clock gives no `movestogo`
+static constexpr int kMovesToGo = 30;
 
 static command::ID kEngineAuthor(command::ID::Type::AUTHOR, "Rasheed Atanda");
 static command::ID kEngineName(command::ID::Type::NAME, "Chesstillo 0.1");
 
+static command::Option AffinityOption() {
+  command::Option option;
+
+  option.type = uci::OptionType::COMBO;
+  option.id = "Affinity";
+  option.def4ult = std::string_view("none");
+  option.vars = {"none", "compact", "spread"};
+
+  return option;
+}
+
+static command::Option HashOption() {
+  command::Option option;
+
+  option.type = uci::OptionType::SPIN;
+  option.id = "Hash";
+  option.def4ult = kHashSize;
+  option.min = 1;
+  option.max = kMaxHashSize;
+
+  return option;
+}
+
+static command::Option EvalFileOption() {
+  command::Option option;
+
+  option.type = uci::OptionType::STRING;
+  option.id = "EvalFile";
+  option.def4ult = std::string_view("<empty>");
+
+  return option;
+}
+
+static command::Option SyzygyPathOption() {
+  command::Option option;
+
+  option.type = uci::OptionType::STRING;
+  option.id = "SyzygyPath";
+  option.def4ult = std::string_view("<empty>");
+
+  return option;
+}
+
+static command::Option SyzygyProbeDepthOption() {
+  command::Option option;
+
+  option.type = uci::OptionType::SPIN;
+  option.id = "SyzygyProbeDepth";
+  option.def4ult =
+      static_cast<std::int64_t>(engine::options.syzygy_probe_depth);
+  option.min = 1;
+  option.max = MAX_DEPTH;
+
+  return option;
+}
+
+static command::Option SyzygyProbeLimitOption() {
+  command::Option option;
+
+  option.type = uci::OptionType::SPIN;
+  option.id = "SyzygyProbeLimit";
+  option.def4ult =
+      static_cast<std::int64_t>(engine::options.syzygy_probe_limit);
+  option.min = 0;
+  option.max = SYZYGY_MAX_PIECES;
+
+  return option;
+}
+
+static command::Option SyzygyWarmupOption() {
+  command::Option option;
+
+  option.type = uci::OptionType::SPIN;
+  option.id = "SyzygyWarmup";
+  option.def4ult = static_cast<std::int64_t>(engine::options.syzygy_warmup);
+  option.min = 0;
+  option.max = SYZYGY_MAX_PIECES;
+
+  return option;
+}
+
+// Milliseconds the search may take, 0 when only its depth bounds it. The
+// clock is in seconds as `wsec`/`bsec` & the increments in milliseconds.
+static std::int64_t Budget(const command::Go &command, engine::Color turn) {
+  if (command.movetime > 0) {
+    return command.movetime;
+  }
+
+  int seconds = turn == engine::WHITE ? command.wsec : command.bsec;
+  int increment = turn == engine::WHITE ? command.winc : command.binc;
+
+  if (seconds < 0) {
+    return 0;
+  }
+
+  std::int64_t left = static_cast<std::int64_t>(seconds) * 1000;
+  int moves = command.movestogo > 0 ? command.movestogo : kMovesToGo;
+
+  // INFO: never more than half of what's left so the clock can't run out
+  return std::max<std::int64_t>(
+      std::min(left / moves + increment, left / 2), 1);
+}
+
 namespace engine {
 UCILink::UCILink(Position *position)
-    : uci::Link(std::cin, std::cout), position_(position) {}
+    : uci::Link(std::cin, std::cout),
+      position_(position),
+      tt_(kHashSize << 20),
+      stop_(false),
+      perft_tt_(kHashSize << 20) {
+  // INFO: through Send, the tables can be loaded from any thread
+  syzygy::SetLogger([this](std::string_view message) {
+    command::Info info;
+
+    info.string = message;
+    Send(info);
+  });
+}
+
+UCILink::~UCILink() {
+  Stop();
+  syzygy::Warmup(0);
+  syzygy::SetLogger(nullptr);
+}
 
 void UCILink::Handle(command::Input *command) {
   static uci::command::Input kUciOk("uciok");
   static uci::command::Input kReadyOk("readyok");
+  static command::Option kAffinity = AffinityOption();
+  static command::Option kHash = HashOption();
+  static command::Option kEvalFile = EvalFileOption();
+  static command::Option kSyzygyPath = SyzygyPathOption();
+  static command::Option kSyzygyProbeDepth = SyzygyProbeDepthOption();
+  static command::Option kSyzygyProbeLimit = SyzygyProbeLimitOption();
+  static command::Option kSyzygyWarmup = SyzygyWarmupOption();
 
   switch (command->type) {
     case uci::TokenType::UCI:
       Send(kEngineName);
       Send(kEngineAuthor);
-      // TODO: send supported options
+      Send(kAffinity);
+      Send(kHash);
+      Send(kEvalFile);
+      Send(kSyzygyPath);
+      Send(kSyzygyProbeDepth);
+      Send(kSyzygyProbeLimit);
+      Send(kSyzygyWarmup);
       Send(kUciOk);
       break;
 
     case uci::TokenType::UCI_NEW_GAME:
-      // TODO: clear all search data
+      Stop();
       position_->Reset();
+      tt_.Clear();
       break;
 
     case uci::TokenType::IS_READY:
       Send(kReadyOk);
       break;
 
+    // INFO: the thread running `go` answers once it has unwound
+    case uci::TokenType::STOP:
+      stop_ = true;
+      stop_.notify_all();
+      break;
+
     default:
       break;
   }
 }
 
 void UCILink::Handle(command::Debug *) {}
-void UCILink::Handle(command::SetOption *) {}
+void UCILink::Handle(command::SetOption *command) {
+  auto *value = std::get_if<std::string_view>(&command->value);
+  auto *number = std::get_if<std::int64_t>(&command->value);
+
+  if (command->id == "Hash" && number != nullptr) {
+    std::size_t size = std::clamp<std::int64_t>(*number, 1, kMaxHashSize)
+                       << 20;
+
+    Stop();
+    tt_.Resize(size);
+    tt_.Clear();
+    perft_tt_.Resize(size);
+    return;
+  }
+
+  if (command->id == "EvalFile" && value != nullptr) {
+    LoadNetwork(*value);
+    return;
+  }
+
+  // INFO: the tables found are reported through the syzygy logger
+  if (command->id == "SyzygyPath" && value != nullptr) {
+    syzygy::Init(*value);
+    return;
+  }
+
+  if (command->id == "SyzygyProbeDepth" && number != nullptr) {
+    options.syzygy_probe_depth = std::clamp<int>(*number, 1, MAX_DEPTH);
+    return;
+  }
+
+  if (command->id == "SyzygyProbeLimit" && number != nullptr) {
+    options.syzygy_probe_limit = std::clamp<int>(*number, 0, SYZYGY_MAX_PIECES);
+    return;
+  }
+
+  if (command->id == "SyzygyWarmup" && number != nullptr) {
+    options.syzygy_warmup = std::clamp<int>(*number, 0, SYZYGY_MAX_PIECES);
+    syzygy::Warmup(options.syzygy_warmup);
+    return;
+  }
+
+  if (command->id != "Affinity" || value == nullptr ||
+      !affinity::Parse(&options.affinity, *value)) {
+    return;
+  }
+
+  // INFO: takes effect for workers created after this point
+  std::string placement = affinity::Describe(options.tasks, options.affinity);
+  command::Info info;
+
+  info.string = placement;
+  Send(info);
+}
 void UCILink::Handle(command::Register *) {}
 
 void UCILink::Handle(command::Position *command) {
@@ -49,5 +277,172 @@ void UCILink::Handle(command::Position *command) {
   engine::Position::ApplyFen(position_, fen_);
 }
 
-void UCILink::Handle(command::Go *) {}
+void UCILink::Handle(command::Go *command) {
+  // INFO: a new `go` cuts short the perft or search still running
+  Stop();
+
+  if (command->perft > 0) {
+    RunPerft(command->perft);
+    return;
+  }
+
+  // INFO: without a depth the search goes as deep as it can in its budget,
+  // `infinite` & `ponder` only answer once stopped
+  int depth = command->depth > 0 ? std::min(command->depth, MAX_DEPTH)
+                                 : MAX_DEPTH;
+
+  RunSearch(depth, Budget(*command, position_->Turn()),
+            command->infinite || command->ponder);
+}
+
+void UCILink::RunPerft(int depth) {
+  stop_ = false;
+
+  // INFO: counts a copy, the position can be changed while it runs
+  go_ = std::thread([this, depth, position = *position_]() mutable {
+    Scheduler scheduler(options.tasks, options.affinity);
+
+    scheduler.Init();
+
+    auto start = std::chrono::steady_clock::now();
+    PerftStat stat = ThreadedPerft(&scheduler, position, depth, true, true,
+                                   &perft_tt_, 0, &stop_);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::int64_t ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+            .count();
+    std::map<std::string, std::size_t> divide(stat.map.begin(),
+                                              stat.map.end());
+
+    for (const auto &[move, nodes] : divide) {
+      std::string line = std::format("{}: {}", move, nodes);
+      command::Info info;
+
+      info.string = line;
+      Send(info);
+    }
+
+    command::Info info;
+
+    info.depth = depth;
+    info.time = ms;
+    info.nodes = stat.nodes;
+    info.nps = stat.nodes * 1000 / (ms + 1);
+
+    Send(info);
+  });
+}
+
+void UCILink::Stop() {
+  stop_ = true;
+  stop_.notify_all();
+
+  if (go_.joinable()) {
+    go_.join();
+  }
+}
+
+void UCILink::RunSearch(int depth, std::int64_t budget, bool infinite) {
+  stop_ = false;
+
+  // INFO: searches a copy, the position can be changed while it runs
+  go_ = std::thread([this, depth, budget, infinite,
+                     position = *position_]() mutable {
+    search::WorkerRegistry workers(0);
+    Search search(&workers);
+    std::jthread timer;
+
+    search.tt = &tt_;
+    search.position = &position;
+    search.max_depth = depth;
+    search.stop = &stop_;
+
+    if (budget > 0) {
+      timer = std::jthread([this, budget](std::stop_token token) {
+        std::mutex mutex;
+        std::condition_variable_any done;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        done.wait_for(lock, token, std::chrono::milliseconds(budget),
+                      [] { return false; });
+
+        if (!token.stop_requested()) {
+          stop_ = true;
+        }
+      });
+    }
+
+    syzygy::ResetStats();
+
+    auto start = std::chrono::steady_clock::now();
+    int score = search.Run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    timer.request_stop();
+
+    if (infinite) {
+      stop_.wait(false);
+    }
+
+    Report(position, search, score,
+           std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+               .count());
+  });
+}
+
+void UCILink::Report(Position &position, const Search &search, int score,
+                     std::int64_t ms) {
+  MoveList moves;
+  char move[6] = "0000";
+  command::Info info;
+
+  if (search.BestMove().piece != NONE) {
+    ToString(move, search.BestMove());
+    info.pv = {move};
+    info.depth = search.CompletedDepth();
+  } else if (!(moves = GenerateMoves(position)).empty()) {
+    // INFO: stopped before the first iteration completed
+    ToString(move, moves.front());
+  }
+
+  info.score = new command::Info::Score{command::Info::Score::CP, score};
+  info.time = ms;
+  info.tbhits = static_cast<int>(syzygy::Hits());
+
+  Send(info);
+
+  syzygy::Stats stats = syzygy::GetStats();
+
+  if (stats.cache_hits + stats.table_probes > 0) {
+    command::Info cache;
+    std::uint64_t probes = stats.cache_hits + stats.table_probes;
+    std::uint64_t blocks = stats.block_hits + stats.block_misses;
+    std::uint64_t latency = stats.table_nanoseconds /
+                            std::max<std::uint64_t>(stats.table_probes, 1);
+
+    cache.string = std::format("tbcache wdl {}/{} blocks {}/{} latency {}ns",
+                               stats.cache_hits, probes, stats.block_hits,
+                               blocks, latency);
+
+    Send(cache);
+  }
+
+  Send(command::BestMove(move));
+}
+
+void UCILink::LoadNetwork(std::string_view path) {
+  command::Info info;
+
+  if (path == "<empty>") {
+    network::Unload();
+    return;
+  }
+
+  info.string = network::Load(std::string(path))
+                    ? std::format("loaded network {}", path)
+                    : std::format("unable to load network {}", path);
+
+  Send(info);
+}
 }  // namespace engine
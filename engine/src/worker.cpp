@@ -1,18 +1,22 @@
 #include <cassert>
 #include <cstddef>
+#include <memory>
 #include <mutex>
 #include <thread>
 
+#include "engine/affinity.hpp"
 #include "engine/move.hpp"
+#include "engine/options.hpp"
+#include "engine/position.hpp"
 #include "engine/search.hpp"
 #include "engine/types.hpp"
 
 namespace engine {
 namespace search {
 WorkerRegistry::WorkerRegistry(std::size_t count)
-    : idle_(count), workers_(count), stack_(count) {
+    : idle_(count), stack_(count) {
   for (std::size_t i = 0; i < idle_; i++) {
-    auto worker = &workers_[i];
+    auto worker = &workers_.emplace_back(static_cast<int>(i));
 
     worker->registry = this;
 
@@ -38,12 +42,13 @@ void WorkerRegistry::PutIdleWorker(Worker *worker) {
   stack_[idle_++] = worker;
 }
 
-Worker::Worker(bool loop)
-    : loop_(loop), node_(nullptr), nodes_(0), search_(nullptr) {
-  std::lock_guard lock(mutex_);
+Worker::Worker(int id, bool loop)
+    : loop_(loop), node_(nullptr), nodes_(0), id_(id), search_(nullptr) {
+  std::unique_lock lock(mutex_);
 
-  search_.position = &position_;
   thread_ = std::thread(&Worker::Loop, this);
+
+  cv_.wait(lock, [this] { return position_ != nullptr; });
 }
 
 Worker::~Worker() {
@@ -134,8 +139,17 @@ void Worker::Search() {
 }
 
 void Worker::Loop() {
+  if (options.affinity != Affinity::NONE && id_ >= 0) {
+    affinity::Pin(id_, options.affinity);
+  }
+
   std::unique_lock lock(mutex_);
 
+  position_ = std::make_unique<Position>();
+  search_.position = position_.get();
+
+  cv_.notify_all();
+
   while (loop_) {
     cv_.wait(lock, [&] { return !loop_ || node_ != nullptr; });
 
@@ -3,6 +3,10 @@
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
 #include <unistd.h>
 
 #include <erl_nif.h>
@@ -21,6 +25,10 @@ namespace chess {
 
 ErlNifResourceType *kResourceType;
 
+// INFO: the DTZ tables sit in a shared most-recently-used list, probes from
+// concurrent dirty schedulers take turns on it
+static std::mutex probe_mutex;
+
 void Destroy(ErlNifEnv *, void *ptr) {
   auto resource = reinterpret_cast<engine::Position **>(ptr);
 
@@ -107,17 +115,18 @@ ERL_NIF_TERM InitTablebase(ErlNifEnv *env, int, const ERL_NIF_TERM argv[]) {
     return enif_make_badarg(env);
   }
 
-  ++len;
-  auto str = new char[len];
+  std::vector<char> str(len + 1);
 
-  if (enif_get_string(env, path, str, len, ERL_NIF_UTF8) !=
-      static_cast<int>(len)) {
+  if (enif_get_string(env, path, str.data(), str.size(), ERL_NIF_UTF8) !=
+      static_cast<int>(str.size())) {
     return enif_make_badarg(env);
   }
 
-  init_tablebases(str);
+  // INFO: the tables get unmapped, probes on other dirty schedulers have to
+  // be done with them first
+  std::lock_guard<std::mutex> lock(probe_mutex);
 
-  delete[] str;
+  init_tablebases(str.data());
 
   return erlang::ok(env);
 }
@@ -132,7 +141,11 @@ ERL_NIF_TERM ProbeDTZ(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
     return enif_make_badarg(env);
   }
 
-  value = probe_dtz(**position, &success);
+  {
+    std::lock_guard<std::mutex> lock(probe_mutex);
+
+    value = probe_dtz(**position, &success);
+  }
 
   if (!success) {
     return erlang::error(env);
@@ -143,6 +156,26 @@ ERL_NIF_TERM ProbeDTZ(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
 
 bool SufficientMaterials(const engine::PieceList &pieces);
 
+static bool GameOver(engine::Position &position) {
+  const auto b_pieces = position.Pieces(engine::BLACK);
+  const auto w_pieces = position.Pieces(engine::WHITE);
+
+  auto b_king = b_pieces[engine::KING];
+  auto w_king = w_pieces[engine::KING];
+
+  if ((KING_ATTACKS(w_king) & b_king) || (KING_ATTACKS(b_king) & w_king)) {
+    return true;
+  }
+
+  auto moves = position.LegalMoves();
+
+  if (moves.empty()) {
+    return true;
+  }
+
+  return !SufficientMaterials(w_pieces) && !SufficientMaterials(b_pieces);
+}
+
 ERL_NIF_TERM IsGameOver(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   assert(argc == 1);
   engine::Position **position;
@@ -151,28 +184,227 @@ ERL_NIF_TERM IsGameOver(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
     return enif_make_badarg(env);
   }
 
-  auto pos = *position;
-  const auto b_pieces = pos->Pieces(engine::BLACK);
-  const auto w_pieces = pos->Pieces(engine::WHITE);
+  return erlang::atom(env, GameOver(**position) ? "true" : "false");
+}
 
-  auto b_king = b_pieces[engine::KING];
-  auto w_king = w_pieces[engine::KING];
+// Decodes PACKED_POSITION_SIZE bytes, rejects anything a table can't index:
+// a missing or extra king, pawns on the back ranks & the side that just moved
+// left in check.
+static bool Unpack(engine::Position *position, const unsigned char *packed) {
+  engine::position::Placement placement;
 
-  if ((KING_ATTACKS(w_king) & b_king) || (KING_ATTACKS(b_king) & w_king)) {
-    return erlang::atom(env, "true");
+  if (packed[0] > engine::BLACK) {
+    return false;
   }
 
-  auto moves = pos->LegalMoves();
+  for (int square = 0; square < 64; square++) {
+    int code = packed[square + 1];
 
-  if (moves.empty()) {
-    return erlang::atom(env, "true");
+    if (code == 0) {
+      continue;
+    }
+
+    int color = code >> 3;
+    int piece = (code & 7) - 1;
+
+    if (color > engine::BLACK || piece < engine::ROOK || piece > engine::PAWN) {
+      return false;
+    }
+
+    placement.Add(static_cast<engine::Color>(color),
+                  static_cast<engine::Piece>(piece), square);
+  }
+
+  placement.turn = static_cast<engine::Color>(packed[0]);
+
+  return engine::Position::ApplyPlacement(position, placement);
+}
+
+// Only the placement field is checked, ApplyFen trusts it to cover 64 squares.
+static bool ValidFen(std::string_view fen) {
+  std::string_view placement = fen.substr(0, fen.find(' '));
+  int ranks = 1;
+  int squares = 0;
+
+  if (placement.size() == fen.size()) {
+    return false;
   }
 
-  if (SufficientMaterials(w_pieces) || SufficientMaterials(b_pieces)) {
-    return erlang::atom(env, "false");
+  for (char c : placement) {
+    if (c == '/') {
+      if (squares != 8) {
+        return false;
+      }
+
+      ranks++;
+      squares = 0;
+    } else if (c >= '1' && c <= '8') {
+      squares += c - '0';
+    } else if (std::strchr("prnbqkPRNBQK", c) != nullptr) {
+      squares++;
+    } else {
+      return false;
+    }
+
+    if (squares > 8) {
+      return false;
+    }
   }
 
-  return erlang::atom(env, "true");
+  return ranks == 8 && squares == 8;
+}
+
+// ApplyFen trusts the pieces it's given, they're put back through
+// ApplyPlacement so that FENs get the same checks as Unpack.
+static bool Validate(engine::Position *position) {
+  engine::position::Placement placement;
+
+  for (engine::Color color : {engine::WHITE, engine::BLACK}) {
+    placement.pieces[color] = position->Pieces(color);
+  }
+
+  for (engine::Castling flag : {engine::position::CASTLE_W_KING_SIDE,
+                                engine::position::CASTLE_W_QUEEN_SIDE,
+                                engine::position::CASTLE_B_KING_SIDE,
+                                engine::position::CASTLE_B_QUEEN_SIDE}) {
+    if (position->CanCastle(flag)) {
+      placement.castling_rights |= flag;
+    }
+  }
+
+  placement.turn = position->Turn();
+  placement.en_passant_sq = position->EnPassantSquare();
+  placement.halfmove_clock = position->HalfmoveClock();
+
+  return engine::Position::ApplyPlacement(position, placement);
+}
+
+static void Probe(engine::Position &position, unsigned char *result) {
+  int success = 1;
+  int wdl = 0;
+  int dtz = 0;
+  ProbeStatus status = PROBE_OK;
+
+  if (GameOver(position)) {
+    status = PROBE_GAME_OVER;
+  } else {
+    wdl = probe_wdl(position, &success);
+
+    if (success) {
+      dtz = probe_dtz(position, &success);
+    }
+
+    if (!success) {
+      status = PROBE_FAILED;
+      wdl = dtz = 0;
+    }
+  }
+
+  result[0] = status;
+  result[1] = static_cast<unsigned char>(wdl);
+  result[2] = dtz & 0xff;
+  result[3] = (dtz >> 8) & 0xff;
+}
+
+static void Invalid(unsigned char *result) {
+  std::memset(result, 0, PROBE_RESULT_SIZE);
+
+  result[0] = PROBE_INVALID;
+}
+
+ERL_NIF_TERM SetPieces(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  assert(argc == 2);
+
+  ErlNifBinary packed;
+  engine::Position **position;
+
+  if (!erlang::resource(env, argv[0], kResourceType, &position) ||
+      !enif_inspect_binary(env, argv[1], &packed) ||
+      packed.size != PACKED_POSITION_SIZE) {
+    return enif_make_badarg(env);
+  }
+
+  if (!Unpack(*position, packed.data)) {
+    return enif_make_badarg(env);
+  }
+
+  return erlang::ok(env);
+}
+
+ERL_NIF_TERM ProbeFens(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  assert(argc == 1);
+
+  unsigned int length;
+  ERL_NIF_TERM list = argv[0];
+  ERL_NIF_TERM head;
+  ERL_NIF_TERM term;
+
+  if (!enif_get_list_length(env, list, &length)) {
+    return enif_make_badarg(env);
+  }
+
+  unsigned char *results =
+      enif_make_new_binary(env, length * PROBE_RESULT_SIZE, &term);
+  engine::Position position;
+  std::lock_guard<std::mutex> lock(probe_mutex);
+
+  for (unsigned int i = 0; enif_get_list_cell(env, list, &head, &list); i++) {
+    ErlNifBinary fen;
+    unsigned char *result = results + i * PROBE_RESULT_SIZE;
+
+    if (!enif_inspect_binary(env, head, &fen)) {
+      Invalid(result);
+      continue;
+    }
+
+    std::string_view view(reinterpret_cast<const char *>(fen.data), fen.size);
+
+    if (!ValidFen(view)) {
+      Invalid(result);
+      continue;
+    }
+
+    engine::Position::ApplyFen(&position, view);
+
+    if (!Validate(&position)) {
+      Invalid(result);
+      continue;
+    }
+
+    Probe(position, result);
+  }
+
+  return term;
+}
+
+ERL_NIF_TERM ProbePacked(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  assert(argc == 1);
+
+  ErlNifBinary packed;
+  ERL_NIF_TERM term;
+
+  if (!enif_inspect_binary(env, argv[0], &packed) ||
+      packed.size % PACKED_POSITION_SIZE != 0) {
+    return enif_make_badarg(env);
+  }
+
+  std::size_t count = packed.size / PACKED_POSITION_SIZE;
+  unsigned char *results =
+      enif_make_new_binary(env, count * PROBE_RESULT_SIZE, &term);
+  engine::Position position;
+  std::lock_guard<std::mutex> lock(probe_mutex);
+
+  for (std::size_t i = 0; i < count; i++) {
+    unsigned char *result = results + i * PROBE_RESULT_SIZE;
+
+    if (Unpack(&position, packed.data + i * PACKED_POSITION_SIZE)) {
+      Probe(position, result);
+    } else {
+      Invalid(result);
+    }
+  }
+
+  return term;
 }
 
 bool SufficientMaterials(const engine::PieceList &pieces) {
@@ -46,14 +46,21 @@ static int Load(ErlNifEnv *env, void **, ERL_NIF_TERM) {
   return 0;
 }
 
+// INFO: anything touching the tablebases may block on page faults of the
+// mapped files, it runs on the dirty IO schedulers
 static ErlNifFunc nif_funcs[] = {
     {"init_chessboard", 0, nn::chess::InitBoard, 0},
-    {"init_syzygy_tb", 1, nn::chess::InitTablebase, 0},
-    {"syzygy_probe_dtz", 1, nn::chess::ProbeDTZ, 0},
+    {"init_syzygy_tb", 1, nn::chess::InitTablebase,
+     ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"syzygy_probe_dtz", 1, nn::chess::ProbeDTZ, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"syzygy_probe_fens", 1, nn::chess::ProbeFens, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"syzygy_probe_packed", 1, nn::chess::ProbePacked,
+     ERL_NIF_DIRTY_JOB_IO_BOUND},
     {"chessboard_to_fen", 1, nn::chess::BoardToFen, 0},
     {"set_piece_on_board", 4, nn::chess::SetPieceAt, 0},
+    {"set_pieces_on_board", 2, nn::chess::SetPieces, 0},
     {"set_board_turn", 2, nn::chess::SetTurn, 0},
-    {"game_over?", 1, nn::chess::IsGameOver, 0},
+    {"game_over?", 1, nn::chess::IsGameOver, ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {"constants", 0, Constants, 0},
     {"hello", 0, Hello, 0},
 };
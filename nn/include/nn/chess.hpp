@@ -3,9 +3,19 @@
 
 #include <erl_nif.h>
 
+// A position packed as the side to move followed by one byte per square, 0
+// when empty & (color << 3) | (piece + 1) otherwise.
+#define PACKED_POSITION_SIZE 65
+
+// A probe result: the status, the WDL as an int8 & the DTZ as a little-endian
+// int16, both from the side to move's view.
+#define PROBE_RESULT_SIZE 4
+
 namespace nn {
 namespace chess {
 
+enum ProbeStatus { PROBE_OK, PROBE_GAME_OVER, PROBE_FAILED, PROBE_INVALID };
+
 void Load(ErlNifEnv *env);
 
 ERL_NIF_TERM InitBoard(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]);
@@ -16,6 +26,12 @@ ERL_NIF_TERM IsGameOver(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]);
 ERL_NIF_TERM InitTablebase(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]);
 ERL_NIF_TERM ProbeDTZ(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]);
 
+// INFO: batched variants, one call for a whole placement or a whole list of
+// positions
+ERL_NIF_TERM SetPieces(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM ProbeFens(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM ProbePacked(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]);
+
 }  // namespace chess
 }  // namespace nn
 
@@ -6,6 +6,15 @@ defmodule Chess.Board do
 
   @type t :: %__MODULE__{ref: reference()}
 
+  @type piece_loc :: %{color: T.color(), piece: T.piece(), square: non_neg_integer()}
+
+  @typedoc """
+  WDL and DTZ are from the side to move's view, game over covers mates,
+  stalemates and dead draws.
+  """
+  @type probe_result ::
+          {:ok, wdl :: integer(), dtz :: integer()} | :game_over | :error | :invalid
+
   @constants NN.constants()
 
   @spec new() :: t()
@@ -43,6 +52,62 @@ defmodule Chess.Board do
     board
   end
 
+  @doc """
+  Sets the whole placement & the side to move in a single call.
+  """
+  @spec set_pieces(t(), T.color(), [piece_loc()]) :: t()
+  def set_pieces(%__MODULE__{} = board, turn, pieces) do
+    :ok = NN.set_pieces_on_board(board.ref, pack(turn, pieces))
+
+    board
+  end
+
+  @doc """
+  Packs a position for `probe_packed/1`: the side to move, then a byte per
+  square, 0 when empty and `color <<< 3 ||| (piece + 1)` otherwise.
+  """
+  @spec pack(T.color(), [piece_loc()]) :: binary()
+  def pack(turn, pieces) when is_atom(turn) do
+    consts = constants()
+
+    squares =
+      Map.new(pieces, fn %{color: c, piece: p, square: s} ->
+        {s, Bitwise.bsl(Map.fetch!(consts, c), 3) + Map.fetch!(consts, p) + 1}
+      end)
+
+    for square <- 0..63, into: <<Map.fetch!(consts, turn)>> do
+      <<Map.get(squares, square, 0)>>
+    end
+  end
+
+  @spec probe_fens([String.t()]) :: [probe_result()]
+  def probe_fens(fens) when is_list(fens) do
+    fens
+    |> NN.syzygy_probe_fens()
+    |> decode_probes()
+  end
+
+  @doc """
+  Probes every position of a concatenation of `pack/2` results.
+  """
+  @spec probe_packed(binary()) :: [probe_result()]
+  def probe_packed(packed) when is_binary(packed) do
+    packed
+    |> NN.syzygy_probe_packed()
+    |> decode_probes()
+  end
+
+  defp decode_probes(results) do
+    for <<status, wdl::signed-8, dtz::signed-little-16 <- results>> do
+      case status do
+        0 -> {:ok, wdl, dtz}
+        1 -> :game_over
+        2 -> :error
+        3 -> :invalid
+      end
+    end
+  end
+
   @spec to_fen(t()) :: String.t()
   def to_fen(%__MODULE__{} = board), do: NN.chessboard_to_fen(board.ref)
 
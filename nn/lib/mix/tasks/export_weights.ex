@@ -0,0 +1,120 @@
+defmodule Mix.Tasks.Export.Weights do
+  @moduledoc """
+  Writes a trained model in the engine's network format, quantized the way
+  the engine runs it so that loading it is a single mmap.
+
+  The file starts with a 128 byte header of little-endian uint32: the magic
+  `CTNN`, the format version, the number of layers, the file size, the CRC-32
+  of everything after the header and a reserved word. Then come, per layer,
+  its inputs, outputs, quantization scale and the offsets of its weights and
+  biases. Every section starts on a 64 byte boundary.
+
+  The first layer is the accumulator: int16 weights, one column per input,
+  and int16 biases, both at a fixed scale of 64. The other layers store int8
+  weights widened to int16, one row per output, at a per-layer scale, with
+  int32 biases at that scale times 64.
+  """
+
+  use Mix.Task
+
+  @otp_app :nn
+
+  @layers ~w[dense_0 dense_1 dense_2 dense_3]
+
+  @magic 0x4E4E5443
+  @version 1
+  @alignment 64
+  @header_size 128
+  @accumulator_scale 64
+
+  @impl Mix.Task
+  def run(argv) do
+    {opts, _} = OptionParser.parse!(argv, strict: [model: :string, out: :string])
+
+    model_dir = Keyword.get(opts, :model, Application.app_dir(@otp_app, ["priv", "model-v1"]))
+    out = Keyword.get(opts, :out, Path.join(model_dir, "network.bin"))
+
+    params =
+      model_dir
+      |> Path.join("model.axon")
+      |> File.read!()
+      |> Nx.deserialize()
+      |> params()
+
+    {layers, payload} =
+      @layers
+      |> Enum.with_index()
+      |> Enum.map_reduce(<<>>, fn {name, index}, payload ->
+        %{"kernel" => kernel, "bias" => bias} = Map.fetch!(params, name)
+        {inputs, outputs} = Nx.shape(kernel)
+        scale = scale(kernel, index)
+        {weights, biases} = quantize(kernel, bias, scale, index)
+
+        weights_offset = @header_size + byte_size(payload)
+        payload = pad(payload <> weights, @alignment)
+        biases_offset = @header_size + byte_size(payload)
+        payload = pad(payload <> biases, @alignment)
+
+        layer =
+          <<inputs::32-little, outputs::32-little, scale::32-little,
+            weights_offset::32-little, biases_offset::32-little>>
+
+        {layer, payload}
+      end)
+
+    size = @header_size + byte_size(payload)
+
+    header =
+      <<@magic::32-little, @version::32-little, length(@layers)::32-little,
+        size::32-little, :erlang.crc32(payload)::32-little, 0::32-little>>
+      |> Kernel.<>(Enum.join(layers))
+      |> pad(@header_size)
+
+    File.write!(out, header <> payload)
+
+    Mix.shell().info("wrote #{size} bytes to #{out}")
+  end
+
+  defp params(%{data: data}), do: data
+  defp params(params), do: params
+
+  defp scale(_kernel, 0), do: @accumulator_scale
+
+  # the largest weight has to fit in an int8
+  defp scale(kernel, _index) do
+    max = kernel |> Nx.abs() |> Nx.reduce_max() |> Nx.to_number()
+
+    if max > 0, do: max(1, floor(127 / max)), else: 1
+  end
+
+  defp quantize(kernel, bias, scale, 0) do
+    {to_int(kernel, scale, 16), to_int(bias, scale, 16)}
+  end
+
+  defp quantize(kernel, bias, scale, _index) do
+    weights = kernel |> Nx.transpose() |> to_int(scale, 16)
+
+    {weights, to_int(bias, scale * @accumulator_scale, 32)}
+  end
+
+  # Nx stores tensors in the host's byte order
+  defp to_int(tensor, scale, bits) do
+    tensor
+    |> Nx.as_type(:f32)
+    |> Nx.multiply(scale)
+    |> Nx.round()
+    |> Nx.as_type({:s, bits})
+    |> Nx.to_binary()
+    |> then(fn binary ->
+      for <<value::signed-size(bits)-native <- binary>>, into: <<>> do
+        <<value::signed-size(bits)-little>>
+      end
+    end)
+  end
+
+  defp pad(binary, alignment) do
+    padding = rem(alignment - rem(byte_size(binary), alignment), alignment)
+
+    binary <> :binary.copy(<<0>>, padding)
+  end
+end
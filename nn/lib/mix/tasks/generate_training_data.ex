@@ -21,13 +21,12 @@ defmodule Mix.Tasks.Generate.Training.Data do
             wk_sqs = gen_random_sqs(64)
             wr_sqs = gen_random_sqs(64)
 
-            pairs = gen_pairs(wk_sqs, wr_sqs, bk_sq)
+            pairs = wk_sqs |> gen_pairs(wr_sqs, bk_sq) |> probe_pairs()
 
             {pairs, bk_sq + 1}
         end,
         fn _ -> :ok end
       )
-      |> Stream.reject(&is_nil/1)
       |> Stream.map(&Tuple.to_list/1)
       |> CSV.encode()
       |> Stream.into(File.stream!(path))
@@ -61,24 +60,34 @@ defmodule Mix.Tasks.Generate.Training.Data do
   end
 
   defp to_pair(bk_sq, wk_sq, wr_sq, turn) do
-    board =
-      Board.new()
-      |> Board.set_turn(turn)
-      |> Board.set_piece_loc(%{color: :black, piece: :king, square: bk_sq})
-      |> Board.set_piece_loc(%{color: :white, piece: :king, square: wk_sq})
-      |> Board.set_piece_loc(%{color: :white, piece: :rook, square: wr_sq})
-
-    case distance_to_mate(board) do
-      {:ok, eval} -> {Board.to_fen(board), eval}
-      {:error, :game_over} -> nil
-    end
+    pieces = [
+      %{color: :black, piece: :king, square: bk_sq},
+      %{color: :white, piece: :king, square: wk_sq},
+      %{color: :white, piece: :rook, square: wr_sq}
+    ]
+
+    {turn, pieces}
   end
 
-  defp distance_to_mate(board) do
-    case Board.terminal?(board) do
-      true -> {:error, :game_over}
-      false -> {:ok, Board.probe_dtz(board)}
-    end
+  # one dirty NIF call probes every position of a chunk, game overs are dropped
+  defp probe_pairs(pairs) do
+    results =
+      pairs
+      |> Enum.map(fn {turn, pieces} -> Board.pack(turn, pieces) end)
+      |> IO.iodata_to_binary()
+      |> Board.probe_packed()
+
+    pairs
+    |> Enum.zip(results)
+    |> Enum.flat_map(fn
+      {{turn, pieces}, {:ok, _wdl, dtz}} ->
+        fen = Board.new() |> Board.set_pieces(turn, pieces) |> Board.to_fen()
+
+        [{fen, dtz}]
+
+      {_pair, _result} ->
+        []
+    end)
   end
 
   defp gen_random_sqs(count, acc \\ [])
@@ -31,6 +31,16 @@ defmodule NN do
   @spec syzygy_probe_dtz(reference()) :: integer()
   def syzygy_probe_dtz(_ref), do: :erlang.nif_error("NIF library not loaded")
 
+  @doc """
+  Probes every FEN, see `Chess.Board.probe_fens/1` for the layout of the
+  results.
+  """
+  @spec syzygy_probe_fens([String.t()]) :: binary()
+  def syzygy_probe_fens(_fens), do: :erlang.nif_error("NIF library not loaded")
+
+  @spec syzygy_probe_packed(binary()) :: binary()
+  def syzygy_probe_packed(_packed), do: :erlang.nif_error("NIF library not loaded")
+
   @spec init_chessboard() :: reference()
   def init_chessboard do
     :erlang.nif_error("NIF library not loaded")
@@ -47,6 +57,11 @@ defmodule NN do
     :erlang.nif_error("NIF library not loaded")
   end
 
+  @spec set_pieces_on_board(reference(), binary()) :: :ok
+  def set_pieces_on_board(_board, _packed) do
+    :erlang.nif_error("NIF library not loaded")
+  end
+
   @spec set_board_turn(reference(), non_neg_integer()) :: :ok
   def set_board_turn(_board, _turn) do
     :erlang.nif_error("NIF library not loaded")
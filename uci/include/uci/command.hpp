@@ -104,6 +104,7 @@ struct Go : public Command {
   int nodes = 0;
   int mate = 0;
   int movetime = 0;
+  int perft = 0;
   bool infinite = false;
 
   std::string ToString() const override;
@@ -204,8 +205,8 @@ struct Info : public Command {
   int seldepth{0};
   int multipv{0};
   Score *score;
-  int nodes{0};
-  int nps{0};
+  std::int64_t nodes{0};
+  std::int64_t nps{0};
   int hashfull{0};
   int tbhits{0};
   int sbhits{0};
@@ -2,6 +2,7 @@
 #define UCI_LINK_HPP
 
 #include <iostream>
+#include <mutex>
 #include <string>
 
 #include "command.hpp"
@@ -29,6 +30,9 @@ class Link : Visitor {
 
   bool quit_;
 
+  // INFO: commands can be sent from threads other than the loop's
+  std::mutex mutex_;
+
   void WriteToUI(std::string &&line);
 
   void VisitInput(command::Input *) override;
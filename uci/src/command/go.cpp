@@ -18,7 +18,7 @@ std::unique_ptr<Command> Parser::Go() {
       {"winc", &command->winc},           {"binc", &command->binc},
       {"movestogo", &command->movestogo}, {"depth", &command->depth},
       {"nodes", &command->nodes},         {"mate", &command->mate},
-      {"movetime", &command->movetime}};
+      {"movetime", &command->movetime},   {"perft", &command->perft}};
 
 maybe_return: {
   if (IsAtEnd()) {
@@ -31,7 +31,7 @@ maybe_return: {
 command: {
   std::string_view msg =
       "Expected searchmoves, ponder, wsec, bsec, winc, binc, movestogo, "
-      "depth, nodes, mate, movetime or infinite.";
+      "depth, nodes, mate, movetime, perft or infinite.";
 
   const auto &token = Consume(TokenType::WORD, msg);
   const auto &literal = std::get<std::string_view>(token.literal);
@@ -116,6 +116,10 @@ std::string command::Go::ToString() const {
     str.append(" movetime ").append(std::to_string(movetime));
   }
 
+  if (perft > 0) {
+    str.append(" perft ").append(std::to_string(perft));
+  }
+
   if (infinite) {
     str.append(" infinite ");
   }
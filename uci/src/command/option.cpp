@@ -198,11 +198,12 @@ std::string command::Option::ToString() const {
     }
   }
 
-  if (min > 0) {
+  // INFO: a spin always has bounds, even when one of them is 0
+  if (min > 0 || type == OptionType::SPIN) {
     str.append(" min ").append(std::to_string(min));
   }
 
-  if (max > 0) {
+  if (max > 0 || type == OptionType::SPIN) {
     str.append(" max ").append(std::to_string(max));
   }
 
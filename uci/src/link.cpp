@@ -1,6 +1,7 @@
 #include <format>
 #include <istream>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -112,6 +113,10 @@ void Link::VisitOption(command::Option *command) {
   WriteToUI(command->ToString());
 }
 
-void Link::WriteToUI(std::string &&line) { out_ << line << std::endl; }
+void Link::WriteToUI(std::string &&line) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  out_ << line << std::endl;
+}
 
 }  // namespace uci
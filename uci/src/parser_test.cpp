@@ -219,6 +219,12 @@ TEST_F(UCIParserTestSuite, TestParseGoInput) {
   ASSERT_EQ(command->searchmoves[0], "e2e4");
   ASSERT_EQ(command->searchmoves[1], "d2d4");
 
+  TOKENIZE(tokens, "go perft 5");
+  PARSE(command, tokens);
+
+  ASSERT_NE(command, nullptr);
+  ASSERT_EQ(command->perft, 5);
+
   EXPECT_CALL(mock_, VisitGo(testing::Eq(command.get()))).Times(1);
 
   command->Accept(mock_);